@@ -0,0 +1,51 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef INFLUXDATA_CANCELLATIONTOKEN_H
+#define INFLUXDATA_CANCELLATIONTOKEN_H
+
+#include <atomic>
+#include <memory>
+
+namespace influxdb
+{
+
+/// \brief Cooperative cancellation of asynchronous queries; copies share the cancellation state
+class CancellationToken
+{
+  public:
+    CancellationToken() : mCancelled{std::make_shared<std::atomic<bool>>(false)} {}
+
+    /// Requests cancellation, running queries are aborted at their next check
+    void cancel() const { mCancelled->store(true, std::memory_order_relaxed); }
+
+    /// Returns true once cancellation is requested
+    bool isCancelled() const { return mCancelled->load(std::memory_order_relaxed); }
+
+  private:
+    std::shared_ptr<std::atomic<bool>> mCancelled;
+};
+
+} // namespace influxdb
+
+#endif // INFLUXDATA_CANCELLATIONTOKEN_H
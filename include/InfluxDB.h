@@ -28,18 +28,28 @@
 #define INFLUXDATA_INFLUXDB_H
 
 #include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <deque>
+#include <future>
 
+#include "CancellationToken.h"
 #include "Transport.h"
 #include "Point.h"
+#include "QueryResult.h"
 #include "influxdb_export.h"
 
 namespace influxdb
 {
 
+namespace internal
+{
+    class SchemaCache;
+}
+
 class INFLUXDB_EXPORT InfluxDB
 {
   public:
@@ -52,6 +62,8 @@ class INFLUXDB_EXPORT InfluxDB
     /// Constructor required valid transport
     explicit InfluxDB(std::unique_ptr<Transport> transport);
 
+    ~InfluxDB();
+
     /// Writes a point
     /// \param point
     void write(Point&& point);
@@ -60,15 +72,96 @@ class INFLUXDB_EXPORT InfluxDB
     /// \param point
     void write(std::vector<Point> &&points);
 
-    /// Queries InfluxDB database
+    /// Writes the points supplied by the generator as one stream, formatting them while being transmitted;
+    /// batching is bypassed
+    /// \param nextPoint returns the next point or std::nullopt after the last one
+    void writeStream(const std::function<std::optional<Point>()>& nextPoint);
+
+    /// Sets a handler for lines rejected by the server, the remaining points of a write are still written
+    /// instead of failing the whole write
+    /// \param handler called for each rejected line
+    /// \throw InfluxDBException 	if not supported by the transport
+    void setRejectedLinesHandler(RejectedLinesHandler handler);
+
+    /// Queries InfluxDB database, the points of all statements are returned in statement order
+    /// \note numeric values are returned as double fields, all other values as tags;
+    ///       use \ref execute() for typed results
     std::vector<Point> query(const std::string& query);
 
+    /// Queries InfluxDB database, returning the points of each statement of a query of multiple
+    /// statements separated by `;` along with the error of the statement, if any
+    /// \note values are converted as by \ref query()
+    /// \throw InfluxDBException 	if the query fails or the response is malformed
+    std::vector<StatementPoints> queryStatements(const std::string& query);
+
+    /// Queries InfluxDB database, returning typed columns per statement and series
+    /// \throw InfluxDBException 	if the query fails or the response is malformed
+    QueryResult execute(const std::string& query);
+
+    /// Queries InfluxDB database, passing each row to the handler as soon as it is parsed;
+    /// memory use does not depend on the size of the result if the transport supports chunked responses
+    /// \param onRow called for each row, the row refers to data valid during the call only
+    /// \throw InfluxDBException 	if the query or a statement fails or the response is malformed
+    void queryStream(const std::string& query, const std::function<void(const QueryRow&)>& onRow);
+
+    /// Runs \ref query() on a separate thread; queries run concurrently if the transport supports it.
+    /// The InfluxDB object must outlive the returned future.
+    /// \param cancellation 	cancels the query, the future throws QueryCancelled then
+    std::future<std::vector<Point>> queryAsync(const std::string& query, CancellationToken cancellation = {});
+
+    /// Runs \ref execute() on a separate thread, see \ref queryAsync()
+    std::future<QueryResult> executeAsync(const std::string& query, CancellationToken cancellation = {});
+
+    /// Queries a time range split into windows which are queried concurrently; each `$timeFilter`
+    /// of the query is replaced with the time condition of the window, e.g.
+    /// `SELECT * FROM cpu WHERE $timeFilter`.
+    /// \note points are ordered by window. Each window is a query of its own: `GROUP BY time()` buckets
+    /// crossing a window border are split into two partial buckets, window borders should align with the
+    /// interval. Queries with LIMIT, OFFSET, SLIMIT, SOFFSET or DESC would be applied per window and are rejected.
+    /// \param windows 	number of sub-queries, at most one per nanosecond of the range
+    /// \param maxConcurrency 	sub-queries running at once, the results of at most as many windows are buffered
+    /// \throw InfluxDBException 	if a sub-query fails, the query has no `$timeFilter` or a clause named above,
+    /// the range is empty or maxConcurrency is 0
+    std::vector<Point> querySplit(const std::string& query, std::chrono::system_clock::time_point from,
+                                  std::chrono::system_clock::time_point to, std::size_t windows, std::size_t maxConcurrency = 8);
+
+    /// Queries a time range split into windows, see \ref querySplit(); points of the first window are
+    /// passed as soon as they are parsed, those of later windows once all preceding windows are passed
+    void querySplit(const std::string& query, std::chrono::system_clock::time_point from,
+                    std::chrono::system_clock::time_point to, std::size_t windows, const std::function<void(Point&&)>& onPoint,
+                    std::size_t maxConcurrency = 8);
+
+    /// Enables caching of query responses, keyed by the query text with whitespace normalized;
+    /// concurrent calls of a query which is not cached share a single request.
+    /// Writes do not invalidate cached responses, they are used until the TTL expires.
+    /// \param ttl 	time a response is used after being received
+    /// \param maxBytes 	memory cap of the cached responses, least recently used responses are evicted
+    /// \throw InfluxDBException 	if the query cache is already enabled
+    void enableQueryCache(std::chrono::milliseconds ttl, std::size_t maxBytes = 64 * 1024 * 1024);
+
+    /// Enables caching of the measurements, tag keys and field types, loaded through SHOW queries on first
+    /// use and reloaded in the background; measurements created later are loaded in the background once
+    /// queried or written, their columns are unknown until then. Query results are typed as declared instead of guessed from the
+    /// values, e.g. integral values of float fields are returned as double, and written fields are checked
+    /// against the declared types before sending.
+    /// \param refreshInterval 	interval of reloading the schema
+    void enableSchemaCache(std::chrono::milliseconds refreshInterval = std::chrono::minutes{5});
+
+    /// Returns the counters of the transport if it sends asynchronously, e.g. of the messages dropped
+    /// \throw InfluxDBException 	if not supported by the transport
+    TransportStatistics transportStatistics() const;
+
     /// Create InfluxDB database if does not exists
     void createDatabaseIfNotExists();
 
     /// Flushes points batched (this can also happens when buffer is full)
     void flushBatch();
 
+    /// Flushes points batched and waits until the transport has sent the messages it queued,
+    /// e.g. if sending asynchronously
+    /// \throw InfluxDBException 	if the transport fails to send them
+    void flushTransport();
+
     /// \deprecated use \ref flushBatch() instead
     [[deprecated("Use flushBatch() instead")]]
     inline void flushBuffer()
@@ -97,17 +190,23 @@ class INFLUXDB_EXPORT InfluxDB
     /// Points batch size
     std::size_t mBatchSize;
 
-    /// Underlying transport UDP/HTTP/Unix socket
+    /// Underlying transport UDP/HTTP/Unix socket, wrapped by the query cache if enabled
     std::unique_ptr<Transport> mTransport;
 
+    /// Underlying transport without the query cache
+    Transport* mUncachedTransport;
+
+    /// Schema of the database, nullptr if disabled
+    std::unique_ptr<internal::SchemaCache> mSchemaCache;
+
     /// Transmits string over transport
     void transmit(std::string&& point);
 
     /// List of global tags
     std::string mGlobalTags;
 
-
-  std::string joinLineProtocolBatch() const;
+    /// Views on the batched lines and their separators, to be sent without joining
+    std::vector<std::string_view> lineProtocolBatchBuffers() const;
 };
 
 } // namespace influxdb
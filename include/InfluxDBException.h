@@ -60,6 +60,16 @@ public:
   ConnectionError(const std::string &source, const std::string &message) : InfluxDBException(source, message) {};
 };
 
+class QueryCancelled : public InfluxDBException {
+public:
+  QueryCancelled(const std::string &source, const std::string &message) : InfluxDBException(source, message) {}
+};
+
+class SchemaConflict : public InfluxDBException {
+public:
+  SchemaConflict(const std::string &source, const std::string &message) : InfluxDBException(source, message) {}
+};
+
 
 } // namespace influxdb
 
@@ -31,6 +31,9 @@
 #include "Transport.h"
 #include "influxdb_export.h"
 
+#include <string>
+#include <vector>
+
 namespace influxdb
 {
 
@@ -50,6 +53,14 @@ class INFLUXDB_EXPORT InfluxDBFactory
    /// \throw InfluxDBException 	if unrecognised backend or missing protocol
    static std::unique_ptr<InfluxDB> Get(const std::string& url) noexcept(false);
 
+   /// Provides InfluxDB instance writing to all transports, e.g. to dual-write during a migration;
+   /// points are formatted once. Each transport sends on its own thread from its own queue, a slow
+   /// or failing one does not delay the others. Queries are sent to the first transport.
+   /// Per URL, `tee_queue_size`, `tee_max_retries` and `tee_retry_backoff_ms` configure the sending.
+   /// \param urls 	URLs defining the transports
+   /// \throw InfluxDBException 	if no URL is passed or a transport cannot be created
+   static std::unique_ptr<InfluxDB> GetTee(const std::vector<std::string>& urls) noexcept(false);
+
  private:
    ///\return  backend based on provided URL
    static std::unique_ptr<Transport> GetTransport(const std::string& url);
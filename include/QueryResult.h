@@ -0,0 +1,209 @@
+// MIT License
+//
+// Copyright (c) 2019 Adam Wegrzynek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INFLUXDATA_QUERYRESULT_H
+#define INFLUXDATA_QUERYRESULT_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "InfluxDBException.h"
+#include "Point.h"
+#include "influxdb_export.h"
+
+namespace influxdb
+{
+
+/// Type of the values of a column, the order matches the alternatives of Column::Values
+enum class ColumnType
+{
+  Null,
+  Int64,
+  Double,
+  Bool,
+  String,
+  Time
+};
+
+/// \brief Column of a series, the values are stored in a vector by type; booleans and null flags are
+/// bit packed (std::vector<bool>), all other values are contiguous
+struct INFLUXDB_EXPORT Column
+{
+  using Values = std::variant<std::monostate,
+                              std::vector<std::int64_t>,
+                              std::vector<double>,
+                              std::vector<bool>,
+                              std::vector<std::string_view>,
+                              std::vector<std::chrono::system_clock::time_point>>;
+
+  /// Column name
+  std::string name;
+
+  /// Values, std::monostate if all values are null
+  Values values;
+
+  /// Null flag per row, null rows hold a default value
+  std::vector<bool> nulls;
+
+  /// Type of the values
+  ColumnType type() const
+  {
+    return static_cast<ColumnType>(values.index());
+  }
+
+  /// Values of the type
+  /// \throw std::bad_variant_access if the column holds another type
+  template <class T>
+  const std::vector<T>& get() const
+  {
+    return std::get<std::vector<T>>(values);
+  }
+};
+
+/// \brief Series of a statement
+struct INFLUXDB_EXPORT Series
+{
+  /// Measurement name
+  std::string name;
+
+  /// Tags of GROUP BY queries
+  std::vector<std::pair<std::string, std::string>> tags;
+
+  /// Columns, all of the same size
+  std::vector<Column> columns;
+
+  /// Number of rows
+  std::size_t rows() const
+  {
+    return columns.empty() ? 0 : columns.front().nulls.size();
+  }
+
+  /// Column of the name
+  /// \throw InfluxDBException if there is no such column
+  const Column& column(std::string_view columnName) const
+  {
+    if (const auto found = findColumn(columnName))
+    {
+      return *found;
+    }
+    throw InfluxDBException{"Series", "No column " + std::string{columnName}};
+  }
+
+  /// Column of the name, std::nullopt if there is none
+  std::optional<std::reference_wrapper<const Column>> findColumn(std::string_view columnName) const
+  {
+    for (const auto& candidate : columns)
+    {
+      if (candidate.name == columnName)
+      {
+        return candidate;
+      }
+    }
+    return std::nullopt;
+  }
+};
+
+/// \brief Result of a single statement
+struct INFLUXDB_EXPORT StatementResult
+{
+  /// Statement id as reported by the server
+  std::size_t statementId;
+
+  /// Error reported for the statement
+  std::optional<std::string> error;
+
+  /// Series returned by the statement
+  std::vector<Series> series;
+};
+
+/// \brief Points of a single statement
+struct INFLUXDB_EXPORT StatementPoints
+{
+  /// Statement id as reported by the server
+  std::size_t statementId;
+  /// Error reported for the statement
+  std::optional<std::string> error;
+  /// Points of all series of the statement
+  std::vector<Point> points;
+};
+
+/// Value of a streamed row, the order of the alternatives matches ColumnType
+using QueryValue = std::variant<std::monostate, std::int64_t, double, bool, std::string_view, std::chrono::system_clock::time_point>;
+
+/// \brief Row of a streamed query, all references are valid during the callback only
+struct INFLUXDB_EXPORT QueryRow
+{
+  /// Statement id as reported by the server
+  std::size_t statementId;
+
+  /// Measurement name of the series
+  std::string_view name;
+
+  /// Tags of the series
+  const std::vector<std::pair<std::string_view, std::string_view>>& tags;
+
+  /// Column names of the series
+  const std::vector<std::string_view>& columns;
+
+  /// Values in column order, std::monostate for null values
+  const std::vector<QueryValue>& values;
+};
+
+/// \brief Typed, columnar result of a query; string values are views into buffers owned by the result
+class INFLUXDB_EXPORT QueryResult
+{
+  public:
+    QueryResult() = default;
+
+    /// Disable copy, the string views refer to the owned buffers
+    QueryResult(const QueryResult&) = delete;
+    QueryResult& operator=(const QueryResult&) = delete;
+
+    QueryResult(QueryResult&&) = default;
+    QueryResult& operator=(QueryResult&&) = default;
+
+    /// Results per statement
+    std::vector<StatementResult> statements;
+
+    /// Stores a buffer in the result
+    /// \return view of the stored buffer, valid for the lifetime of the result
+    std::string_view store(std::string_view buffer)
+    {
+      return mBuffers.emplace_back(buffer);
+    }
+
+  private:
+    /// Response documents and strings referred to by string columns
+    std::deque<std::string> mBuffers;
+};
+
+} // namespace influxdb
+
+#endif // INFLUXDATA_QUERYRESULT_H
@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef INFLUXDATA_SHAREDMEMORYREADER_H
+#define INFLUXDATA_SHAREDMEMORYREADER_H
+
+#include "influxdb_export.h"
+
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace influxdb
+{
+
+namespace internal
+{
+    class SharedRing;
+}
+
+/// \brief Reads the messages written by the shared memory transport (`shm://name`), e.g. to forward them
+/// to InfluxDB; a ring has a single reader
+///
+/// A producer terminated between reserving and publishing a message leaves a record that is never
+/// published; the reader stops at it and later messages are not read until the ring is removed
+/// and recreated.
+class INFLUXDB_EXPORT SharedMemoryReader
+{
+  public:
+    /// Default size of a new ring
+    static constexpr std::size_t defaultCapacity{16 * 1024 * 1024};
+
+    /// Opens the ring of the shared memory segment, creating it if it does not exist
+    /// \param name 	name of the segment, as passed to the transport
+    /// \param capacity 	size of a new ring
+    /// \throw InfluxDBException 	if the segment cannot be opened or is not a ring
+    explicit SharedMemoryReader(const std::string& name, std::size_t capacity = defaultCapacity);
+
+    ~SharedMemoryReader();
+
+    SharedMemoryReader(const SharedMemoryReader&) = delete;
+    SharedMemoryReader& operator=(const SharedMemoryReader&) = delete;
+
+    /// Passes the messages written so far to the handler in order, each message is line protocol;
+    /// the view is valid during the call only
+    /// \return number of messages read
+    std::size_t read(const std::function<void(std::string_view)>& onMessage,
+                     std::size_t maxMessages = std::numeric_limits<std::size_t>::max());
+
+    /// Waits until a message can be read, polling with increasing intervals up to 100 µs
+    /// \return false if the timeout expired
+    bool wait(std::chrono::microseconds timeout);
+
+    /// Removes the shared memory segment; readers and writers which opened it keep using it
+    static void remove(const std::string& name);
+
+  private:
+    std::unique_ptr<internal::SharedRing> mRing;
+};
+
+} // namespace influxdb
+
+#endif // INFLUXDATA_SHAREDMEMORYREADER_H
@@ -30,9 +30,48 @@
 #include "InfluxDBException.h"
 #include "influxdb_export.h"
 
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace influxdb
 {
 
+/// Handler for lines rejected by the server
+/// \param line 	rejected line
+/// \param reason 	error reported for the line
+using RejectedLinesHandler = std::function<void(std::string_view line, std::string_view reason)>;
+
+/// \brief Counters of a transport sending asynchronously or dropping messages
+struct TransportStatistics
+{
+    /// Messages sent without error
+    std::uint64_t sentMessages{0};
+
+    /// Datagrams handed over to the socket
+    std::uint64_t sentDatagrams{0};
+
+    /// Messages dropped because the send queue or ring buffer was full, or all their datagrams were dropped
+    std::uint64_t droppedMessages{0};
+
+    /// Datagrams dropped because the socket send buffer was full
+    std::uint64_t droppedDatagrams{0};
+
+    /// Messages which failed to be sent, e.g. if the receiver is not running
+    std::uint64_t failedMessages{0};
+
+    /// Bytes of the messages sent without error, counted by the metrics decorator only
+    std::uint64_t sentBytes{0};
+
+    /// Messages the wrapped transport accepted, counted by the metrics decorator only
+    std::uint64_t writtenMessages{0};
+
+    /// Messages the wrapped transport threw on, counted by the metrics decorator only
+    std::uint64_t failedWrites{0};
+};
+
 /// \brief Transport interface
 class INFLUXDB_EXPORT Transport
 {
@@ -44,11 +83,77 @@ class INFLUXDB_EXPORT Transport
     /// Sends string blob
     virtual void send(std::string&& message) = 0;
 
+    /// Sends the buffers as one message, without concatenating them if supported by the transport
+    /// \param buffers 	views on the message parts, must be valid until the call returns
+    virtual void sendBuffers(const std::vector<std::string_view>& buffers) {
+      std::size_t size{0};
+      for (const auto& buffer : buffers) {
+        size += buffer.size();
+      }
+
+      std::string message;
+      message.reserve(size);
+      for (const auto& buffer : buffers) {
+        message.append(buffer);
+      }
+      send(std::move(message));
+    }
+
+    /// Sends the data supplied by the producer as one message, streaming it if supported by the transport
+    /// \param producer 	fills the buffer passed with at most size bytes and returns the number of bytes written, 0 ends the message
+    virtual void sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer) {
+      constexpr std::size_t blockSize{16 * 1024};
+      std::string message;
+      std::size_t written{0};
+      do {
+        message.resize(message.size() + blockSize);
+        written = producer(&message[message.size() - blockSize], blockSize);
+        message.resize(message.size() - blockSize + written);
+      } while (written > 0);
+      send(std::move(message));
+    }
+
+    /// Sends a message in an encoding other than line protocol, e.g. compressed by gzip
+    /// \param body 	encoded message
+    /// \param contentEncoding 	encoding of the body, e.g. `gzip`
+    virtual void sendEncoded([[maybe_unused]] std::string_view body, [[maybe_unused]] std::string_view contentEncoding) {
+      throw InfluxDBException{"Transport", "Encoded messages are not supported by the selected transport"};
+    }
+
     /// Sends request
     virtual std::string query([[maybe_unused]] const std::string& query) {
       throw InfluxDBException{"Transport", "Queries are not supported by the selected transport"};
     }
 
+    /// Sends request, passes the response to the handler part by part as it is received
+    /// \param query 	query to execute
+    /// \param onChunk 	called for each received part of the response
+    virtual void queryChunked(const std::string& query, const std::function<void(std::string_view)>& onChunk) {
+      onChunk(this->query(query));
+    }
+
+    /// Sends request like queryChunked(), the request is aborted once isCancelled returns true
+    /// if supported by the transport; it is polled while waiting for the response
+    /// \throw QueryCancelled 	if the request is aborted
+    virtual void queryCancellable(const std::string& query, const std::function<void(std::string_view)>& onChunk,
+                                  [[maybe_unused]] const std::function<bool()>& isCancelled) {
+      queryChunked(query, onChunk);
+    }
+
+    /// Sets a handler for lines rejected by the server, the remaining lines of a message are still written
+    virtual void setRejectedLinesHandler([[maybe_unused]] RejectedLinesHandler handler) {
+      throw InfluxDBException{"Transport", "Handling of rejected lines is not supported by the selected transport"};
+    }
+
+    /// Waits until the messages queued by the transport are sent, returns immediately if it sends synchronously
+    virtual void flush() {
+    }
+
+    /// Returns the counters of the messages sent, e.g. asynchronously
+    virtual TransportStatistics sendStatistics() const {
+      throw InfluxDBException{"Transport", "Statistics are not supported by the selected transport"};
+    }
+
     /// Sends request
     virtual void createDatabase() {
       throw InfluxDBException{"Transport", "Creation of database is not supported by the selected transport"};
@@ -0,0 +1,45 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <string_view>
+#include <vector>
+
+namespace influxdb::transports
+{
+    /// Maximum number of buffers Asio passes to a single scatter-gather system call
+    inline constexpr std::size_t maxGatherBuffers{64};
+
+    inline std::vector<boost::asio::const_buffer> toAsioBuffers(const std::vector<std::string_view>& buffers)
+    {
+        std::vector<boost::asio::const_buffer> asioBuffers;
+        asioBuffers.reserve(buffers.size());
+        for (const auto& buffer : buffers)
+        {
+            asioBuffers.emplace_back(buffer.data(), buffer.size());
+        }
+        return asioBuffers;
+    }
+}
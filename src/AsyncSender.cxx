@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "AsyncSender.h"
+
+namespace influxdb::internal
+{
+    AsyncSender::AsyncSender(boost::asio::io_service& ioService, std::size_t queueSize)
+        : mIoService(ioService), mWork(std::in_place, ioService), mQueueSize(queueSize),
+          mThread([this] { mIoService.run(); })
+    {
+    }
+
+    AsyncSender::~AsyncSender()
+    {
+        mWork.reset();
+        mThread.join();
+    }
+
+    void AsyncSender::flush()
+    {
+        std::unique_lock lock{mMutex};
+        mIdle.wait(lock, [this] { return mQueued.load() == 0; });
+    }
+
+    void AsyncSender::countSent(std::size_t datagrams)
+    {
+        mSentDatagrams += datagrams;
+        mMessageDatagramsSent += datagrams;
+    }
+
+    void AsyncSender::countSocketBufferFull(std::size_t datagrams)
+    {
+        mDroppedDatagrams += datagrams;
+        mMessageDatagramsDropped += datagrams;
+    }
+
+    TransportStatistics AsyncSender::statistics() const
+    {
+        return {mSentMessages.load(), mSentDatagrams.load(), mDroppedMessages.load(), mDroppedDatagrams.load(), mFailedMessages.load()};
+    }
+
+    void AsyncSender::sendDone()
+    {
+        if (mQueued.fetch_sub(1) == 1)
+        {
+            std::lock_guard lock{mMutex};
+            mIdle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,134 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#pragma once
+
+#include "Transport.h"
+#include <boost/asio.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace influxdb::internal
+{
+    /// \brief Runs the sends of a transport on an I/O thread, so callers never block on the socket;
+    /// sends exceeding the queue capacity are dropped
+    class AsyncSender
+    {
+    public:
+        /// Default capacity of the send queue in messages
+        static constexpr std::size_t defaultQueueSize{8192};
+
+        /// \param ioService 	I/O service of the transport's socket, run by the sender
+        /// \param queueSize 	maximum number of queued messages
+        AsyncSender(boost::asio::io_service& ioService, std::size_t queueSize);
+
+        /// Sends the queued messages and stops the I/O thread
+        ~AsyncSender();
+
+        AsyncSender(const AsyncSender&) = delete;
+        AsyncSender& operator=(const AsyncSender&) = delete;
+
+        /// Queues a send, it is dropped if the queue is full; exceptions thrown by it are counted as failure.
+        /// A message is counted as sent once a datagram of it is accepted by the socket, as dropped if all
+        /// its datagrams are dropped because the socket send buffer is full.
+        template <class Send>
+        void post(Send send)
+        {
+            if (mQueued.fetch_add(1) >= mQueueSize)
+            {
+                sendDone();
+                ++mDroppedMessages;
+                return;
+            }
+
+            mIoService.post([this, send = std::move(send)]() mutable {
+                try
+                {
+                    mMessageDatagramsSent = 0;
+                    mMessageDatagramsDropped = 0;
+                    send();
+                    if (mMessageDatagramsSent == 0 && mMessageDatagramsDropped > 0)
+                    {
+                        ++mDroppedMessages;
+                    }
+                    else
+                    {
+                        ++mSentMessages;
+                    }
+                }
+                catch (const std::exception&)
+                {
+                    ++mFailedMessages;
+                }
+                sendDone();
+            });
+        }
+
+        /// Waits until the queued messages are sent
+        void flush();
+
+        /// Counts datagrams handed over to the socket
+        void countSent(std::size_t datagrams);
+
+        /// Counts datagrams dropped as the socket send buffer is full
+        void countSocketBufferFull(std::size_t datagrams);
+
+        TransportStatistics statistics() const;
+
+    private:
+        /// Removes a message from the queue
+        void sendDone();
+
+        boost::asio::io_service& mIoService;
+
+        /// Keeps the I/O thread running while the queue is empty
+        std::optional<boost::asio::io_service::work> mWork;
+
+        const std::size_t mQueueSize;
+
+        /// Number of queued messages
+        std::atomic<std::size_t> mQueued{0};
+
+        std::atomic<std::uint64_t> mSentMessages{0};
+        std::atomic<std::uint64_t> mSentDatagrams{0};
+        std::atomic<std::uint64_t> mDroppedMessages{0};
+        std::atomic<std::uint64_t> mDroppedDatagrams{0};
+        std::atomic<std::uint64_t> mFailedMessages{0};
+
+        /// Datagrams of the message being sent, used by the I/O thread only
+        std::size_t mMessageDatagramsSent{0};
+        std::size_t mMessageDatagramsDropped{0};
+
+        /// Signals flush() once the queue is empty
+        std::mutex mMutex;
+        std::condition_variable mIdle;
+
+        std::thread mThread;
+    };
+}
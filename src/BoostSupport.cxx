@@ -22,77 +22,130 @@
 // SOFTWARE.
 
 #include "BoostSupport.h"
+#include "StreamSocket.h"
 #include "UDP.h"
 #include "UnixSocket.h"
-#include <chrono>
-#include <boost/lexical_cast.hpp>
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/json_parser.hpp>
+#include "UrlOptions.h"
 
 namespace influxdb::internal
 {
-    std::vector<Point> queryImpl(Transport* transport, const std::string& query)
+    namespace
     {
-        const auto response = transport->query(query);
-        std::stringstream responseString;
-        responseString << response;
-        std::vector<Point> points;
-        boost::property_tree::ptree pt;
-        boost::property_tree::read_json(responseString, pt);
-
-        for (const auto& result : pt.get_child("results"))
+        /// Applies the socket options shared by the datagram transports
+        template <class DatagramTransport>
+        std::unique_ptr<Transport> withSocketOptions(std::unique_ptr<DatagramTransport> transport, http::url& options)
         {
-            const auto isResultEmpty = result.second.find("series");
-            if (isResultEmpty == result.second.not_found())
+            const auto async = takeBoolOption(options, "async").value_or(false);
+            const auto queueSize = takeSizeOption(options, "queue_size").value_or(AsyncSender::defaultQueueSize);
+            if (queueSize == 0)
+            {
+                throw InfluxDBException{__func__, "Invalid value of queue_size: 0"};
+            }
+            if (const auto sendBufferSize = takeSizeOption(options, "send_buffer_size"))
             {
-                return {};
+                transport->setSendBufferSize(*sendBufferSize);
             }
-            for (const auto& series : result.second.get_child("series"))
+            if (async)
             {
-                const auto columns = series.second.get_child("columns");
+                transport->enableAsync(queueSize);
+            }
+            return transport;
+        }
 
-                for (const auto& values : series.second.get_child("values"))
+        /// Applies the options of stream socket transports
+        std::unique_ptr<Transport> withStreamOptions(std::unique_ptr<transports::StreamSocket> transport, http::url& options)
+        {
+            if (const auto maxPendingBytes = takeSizeOption(options, "max_pending_bytes"))
+            {
+                if (*maxPendingBytes == 0)
                 {
-                    Point point{series.second.get<std::string>("name", "")};
-                    auto iColumns = columns.begin();
-                    auto iValues = values.second.begin();
-                    for (; iColumns != columns.end() && iValues != values.second.end(); ++iColumns, ++iValues)
-                    {
-                        const auto value = iValues->second.get_value<std::string>();
-                        const auto column = iColumns->second.get_value<std::string>();
-                        if (!column.compare("time"))
-                        {
-                            std::tm tm = {};
-                            std::stringstream timeString;
-                            timeString << value;
-                            timeString >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%SZ");
-                            point.setTimestamp(std::chrono::system_clock::from_time_t(std::mktime(&tm)));
-                            continue;
-                        }
-                        // cast all values to double, if strings add to tags
-                        try
-                        {
-                            point.addField(column, boost::lexical_cast<double>(value));
-                        }
-                        catch (...)
-                        {
-                            point.addTag(column, value);
-                        }
-                    }
-                    points.push_back(std::move(point));
+                    throw InfluxDBException{__func__, "Invalid value of max_pending_bytes: 0"};
                 }
+                transport->setMaxPendingBytes(*maxPendingBytes);
             }
+            const auto backoff = takeDurationOption(options, "reconnect_backoff_ms").value_or(transports::StreamSocket::defaultReconnectBackoff);
+            const auto maxBackoff = takeDurationOption(options, "max_reconnect_backoff_ms").value_or(transports::StreamSocket::defaultMaxReconnectBackoff);
+            transport->setReconnectBackoff(backoff, maxBackoff);
+            return transport;
+        }
+
+        /// Stream socket transport connecting to a Unix socket
+        std::unique_ptr<Transport> withUnixStreamTransport([[maybe_unused]] http::url& options)
+        {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+            const auto sendBufferSize = takeSizeOption(options, "send_buffer_size");
+            auto transport = std::make_unique<transports::StreamSocket>(
+                [path = options.path, sendBufferSize](transports::StreamSocket::Socket& socket)
+                {
+                    socket.connect(boost::asio::local::stream_protocol::endpoint(path));
+                    if (sendBufferSize)
+                    {
+                        socket.set_option(boost::asio::socket_base::send_buffer_size(static_cast<int>(*sendBufferSize)));
+                    }
+                });
+            return withStreamOptions(std::move(transport), options);
+#else
+            throw InfluxDBException{__func__, "Unix socket not supported on this system"};
+#endif // defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
         }
-        return points;
     }
 
     std::unique_ptr<Transport> withUdpTransport(const http::url& uri)
     {
-        return std::make_unique<transports::UDP>(uri.host, uri.port);
+        auto options = uri;
+        const auto maxDatagramSize = takeSizeOption(options, "max_datagram_size").value_or(transports::UDP::defaultMaxDatagramSize);
+        if (maxDatagramSize == 0)
+        {
+            throw InfluxDBException{__func__, "Invalid value of max_datagram_size: 0"};
+        }
+        auto transport = std::make_unique<transports::UDP>(options.host, options.port, maxDatagramSize);
+        if (takeBoolOption(options, "io_uring").value_or(false))
+        {
+            // Falls back to sendmmsg if io_uring is not available
+            transport->enableIoUring();
+        }
+        return withSocketOptions(std::move(transport), options);
     }
 
     std::unique_ptr<Transport> withUnixSocketTransport(const http::url& uri)
     {
-        return std::make_unique<transports::UnixSocket>(uri.path);
+        auto options = uri;
+        if (takeBoolOption(options, "stream").value_or(false))
+        {
+            return withUnixStreamTransport(options);
+        }
+        return withSocketOptions(std::make_unique<transports::UnixSocket>(options.path), options);
+    }
+
+    std::unique_ptr<Transport> withTcpTransport(const http::url& uri)
+    {
+        auto options = uri;
+        const auto sendBufferSize = takeSizeOption(options, "send_buffer_size");
+        auto transport = std::make_unique<transports::StreamSocket>(
+            [host = options.host, port = std::to_string(options.port), sendBufferSize](transports::StreamSocket::Socket& socket)
+            {
+                boost::asio::io_service ioService;
+                boost::asio::ip::tcp::resolver resolver(ioService);
+                boost::asio::ip::tcp::resolver::query query(host, port);
+                boost::system::error_code error{boost::asio::error::host_not_found};
+                for (auto endpoint = resolver.resolve(query); error && endpoint != decltype(endpoint){}; ++endpoint)
+                {
+                    boost::system::error_code ignored;
+                    socket.close(ignored);
+                    socket.connect(endpoint->endpoint(), error);
+                }
+                if (error)
+                {
+                    throw boost::system::system_error(error);
+                }
+
+                // Batches are coalesced by the transport, waiting for further data only adds latency
+                socket.set_option(boost::asio::ip::tcp::no_delay(true));
+                if (sendBufferSize)
+                {
+                    socket.set_option(boost::asio::socket_base::send_buffer_size(static_cast<int>(*sendBufferSize)));
+                }
+            });
+        return withStreamOptions(std::move(transport), options);
     }
 }
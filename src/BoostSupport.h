@@ -22,16 +22,12 @@
 // SOFTWARE.
 
 #include "Transport.h"
-#include "Point.h"
 #include "UriParser.h"
 #include <memory>
-#include <string>
-#include <vector>
 
 namespace influxdb::internal
 {
-    std::vector<Point> queryImpl(Transport* transport, const std::string& query);
-
     std::unique_ptr<Transport> withUdpTransport(const http::url &uri);
     std::unique_ptr<Transport> withUnixSocketTransport(const http::url &uri);
+    std::unique_ptr<Transport> withTcpTransport(const http::url &uri);
 }
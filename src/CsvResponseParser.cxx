@@ -0,0 +1,302 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "CsvResponseParser.h"
+#include "InfluxDBException.h"
+#include <iterator>
+
+namespace influxdb::internal
+{
+    namespace
+    {
+        bool isDigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        /// Returns true if the text is a JSON style number: -?digits(.digits)?([eE][+-]?digits)?
+        bool isNumber(std::string_view text)
+        {
+            std::size_t i = (text.front() == '-') ? 1 : 0;
+            const auto digits = [&text, &i] {
+                const auto begin = i;
+                while (i < text.size() && isDigit(text[i]))
+                {
+                    ++i;
+                }
+                return i > begin;
+            };
+
+            if (!digits())
+            {
+                return false;
+            }
+            if (i < text.size() && text[i] == '.')
+            {
+                ++i;
+                if (!digits())
+                {
+                    return false;
+                }
+            }
+            if (i < text.size() && (text[i] == 'e' || text[i] == 'E'))
+            {
+                ++i;
+                i += (i < text.size() && (text[i] == '+' || text[i] == '-')) ? 1 : 0;
+                if (!digits())
+                {
+                    return false;
+                }
+            }
+            return i == text.size();
+        }
+
+        ResponseValue valueOf(std::string_view text, bool quoted)
+        {
+            if (quoted)
+            {
+                return {ResponseValue::Type::String, text};
+            }
+            if (text.empty())
+            {
+                return {ResponseValue::Type::Null, "null"};
+            }
+            if (text == "true" || text == "false")
+            {
+                return {ResponseValue::Type::Bool, text};
+            }
+            return {isNumber(text) ? ResponseValue::Type::Number : ResponseValue::Type::String, text};
+        }
+
+        [[noreturn]] void fail(std::size_t offset, const std::string& reason)
+        {
+            throw InfluxDBException{"InfluxDB", "Malformed query response at offset " + std::to_string(offset) + ": " + reason};
+        }
+    }
+
+    void CsvResponseParser::parse(std::string_view records, QueryResponseHandler& handler)
+    {
+        unescaped.clear();
+        std::size_t offset{0};
+
+        while (readRecord(records, offset))
+        {
+            if (fields.size() == 1 && fields.front().text.empty() && !fields.front().quoted)
+            {
+                // Empty lines separate sections, each starting with a header
+                expectHeader = true;
+            }
+            else if (expectError)
+            {
+                throw InfluxDBException{"InfluxDB", std::string{fields.front().text}};
+            }
+            else if (expectHeader && fields.size() == 1 && fields.front().text == "error")
+            {
+                expectError = true;
+            }
+            else if (expectHeader)
+            {
+                parseHeader();
+                if (!started)
+                {
+                    handler.onStatement(0);
+                    started = true;
+                }
+            }
+            else
+            {
+                parseRow(handler);
+            }
+        }
+    }
+
+    void CsvResponseParser::finish(QueryResponseHandler& handler)
+    {
+        if (expectError)
+        {
+            throw InfluxDBException{"InfluxDB", "Query failed without error message"};
+        }
+        if (started)
+        {
+            handler.onStatementEnd();
+        }
+    }
+
+    bool CsvResponseParser::readRecord(std::string_view records, std::size_t& offset)
+    {
+        if (offset >= records.size())
+        {
+            return false;
+        }
+
+        fields.clear();
+        for (;;)
+        {
+            if (records[offset] == '"')
+            {
+                const auto begin = ++offset;
+                bool escaped{false};
+                std::size_t quote{0};
+                while ((quote = records.find('"', offset)) != std::string_view::npos && records.substr(quote + 1, 1) == "\"")
+                {
+                    escaped = true;
+                    offset = quote + 2;
+                }
+                if (quote == std::string_view::npos)
+                {
+                    fail(begin, "unterminated quoted value");
+                }
+                offset = quote + 1;
+
+                auto text = records.substr(begin, quote - begin);
+                if (escaped)
+                {
+                    std::string& value = unescaped.emplace_back();
+                    for (std::size_t i = 0; i < text.size(); ++i)
+                    {
+                        value.push_back(text[i]);
+                        i += (text[i] == '"') ? 1 : 0;
+                    }
+                    text = value;
+                }
+                fields.push_back(Field{text, true});
+            }
+            else
+            {
+                const auto begin = offset;
+                while (offset < records.size() && records[offset] != ',' && records[offset] != '\n' && records[offset] != '\r')
+                {
+                    ++offset;
+                }
+                fields.push_back(Field{records.substr(begin, offset - begin), false});
+            }
+
+            if (offset < records.size() && records[offset] == '\r')
+            {
+                ++offset;
+            }
+            if (offset >= records.size() || records[offset] == '\n')
+            {
+                ++offset;
+                return true;
+            }
+            if (records[offset++] != ',')
+            {
+                fail(offset - 1, "expected separator");
+            }
+            if (offset == records.size())
+            {
+                fields.push_back(Field{{}, false});
+                return true;
+            }
+        }
+    }
+
+    void CsvResponseParser::parseHeader()
+    {
+        if (fields.size() < 2 || fields[0].text != "name" || fields[1].text != "tags")
+        {
+            throw InfluxDBException{"InfluxDB", "Malformed query response: expected CSV header"};
+        }
+
+        columnNames.clear();
+        for (auto field = std::next(fields.cbegin(), 2); field != fields.cend(); ++field)
+        {
+            columnNames.emplace_back(field->text);
+        }
+        columns.assign(columnNames.cbegin(), columnNames.cend());
+        expectHeader = false;
+        seriesOpen = false;
+    }
+
+    void CsvResponseParser::parseRow(QueryResponseHandler& handler)
+    {
+        const auto name = fields[0].text;
+        const auto tagText = fields.size() > 1 ? fields[1].text : std::string_view{};
+
+        if (!seriesOpen || name != seriesName || tagText != seriesTags)
+        {
+            seriesName = name;
+            seriesTags = tagText;
+            parseTags(seriesTags);
+            handler.onSeries(seriesName, tags, columns);
+            seriesOpen = true;
+        }
+
+        row.clear();
+        for (std::size_t i = 2; i < fields.size(); ++i)
+        {
+            row.push_back(valueOf(fields[i].text, fields[i].quoted));
+        }
+        handler.onRow(row);
+    }
+
+    void CsvResponseParser::parseTags(std::string_view text)
+    {
+        tags.clear();
+        tagTexts.clear();
+
+        // Tags are sent as "key=value,..." with ',', '=' and ' ' escaped by '\'
+        const auto unescape = [this](std::string_view escaped) -> std::string_view {
+            if (escaped.find('\\') == std::string_view::npos)
+            {
+                return escaped;
+            }
+            std::string& value = tagTexts.emplace_back();
+            for (std::size_t i = 0; i < escaped.size(); ++i)
+            {
+                const auto next = escaped.substr(i + 1, 1);
+                if (escaped[i] == '\\' && (next == "," || next == "=" || next == " "))
+                {
+                    ++i;
+                }
+                value.push_back(escaped[i]);
+            }
+            return value;
+        };
+
+        std::size_t begin{0};
+        while (begin < text.size())
+        {
+            std::size_t end{begin};
+            std::size_t separator{std::string_view::npos};
+            for (; end < text.size() && text[end] != ','; ++end)
+            {
+                if (text[end] == '\\')
+                {
+                    ++end;
+                }
+                else if (text[end] == '=' && separator == std::string_view::npos)
+                {
+                    separator = end;
+                }
+            }
+            if (separator == std::string_view::npos)
+            {
+                throw InfluxDBException{"InfluxDB", "Malformed query response: invalid tags " + std::string{text}};
+            }
+            tags.emplace_back(unescape(text.substr(begin, separator - begin)), unescape(text.substr(separator + 1, end - separator - 1)));
+            begin = end + 1;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "QueryResponseParser.h"
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace influxdb::internal
+{
+    /// Parses the CSV responses of InfluxDB queries (Accept: application/csv): sections of a
+    /// "name,tags,<columns>" header followed by rows, separated by empty lines.
+    /// CSV carries neither statement ids nor value types, all rows are passed as statement 0
+    /// and values are typed by their text (quoted values are strings)
+    class CsvResponseParser
+    {
+    public:
+        /// Parses complete records, a response may be passed in several parts
+        /// \throw InfluxDBException	if the response is malformed or reports an error
+        void parse(std::string_view records, QueryResponseHandler& handler);
+
+        /// Ends the response
+        void finish(QueryResponseHandler& handler);
+
+    private:
+        struct Field
+        {
+            std::string_view text;
+            bool quoted;
+        };
+
+        /// Reads the fields of the record at the offset, returns false at the end of the data
+        bool readRecord(std::string_view records, std::size_t& offset);
+        void parseHeader();
+        void parseRow(QueryResponseHandler& handler);
+        void parseTags(std::string_view text);
+
+        std::vector<Field> fields;
+        bool expectHeader{true};
+        bool expectError{false};
+        bool started{false};
+        bool seriesOpen{false};
+
+        /// Header and series of the current section, kept over parts
+        std::vector<std::string> columnNames;
+        std::vector<std::string_view> columns;
+        std::string seriesName;
+        std::string seriesTags;
+        std::deque<std::string> tagTexts;
+        std::vector<std::pair<std::string_view, std::string_view>> tags;
+
+        /// Storage of unescaped quoted values of the current part
+        std::deque<std::string> unescaped;
+        std::vector<ResponseValue> row;
+    };
+}
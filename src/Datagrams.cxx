@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Datagrams.h"
+#include <algorithm>
+
+namespace influxdb::internal
+{
+    Datagrams packDatagrams(std::string_view data, std::size_t maxSize)
+    {
+        Datagrams result;
+        std::size_t begin{0};
+        std::size_t end{0};
+        bool pending{false};
+
+        const auto flush = [&] {
+            if (pending)
+            {
+                result.datagrams.push_back(data.substr(begin, end - begin));
+                pending = false;
+            }
+        };
+
+        for (std::size_t pos = 0; pos < data.size();)
+        {
+            const auto lineEnd = std::min(data.find('\n', pos), data.size());
+            const auto lineSize = lineEnd - pos;
+
+            if (lineSize > maxSize)
+            {
+                flush();
+                result.oversizeLines.push_back(data.substr(pos, lineSize));
+            }
+            else if (lineSize > 0)
+            {
+                // The lines of a datagram are contiguous in the data, including the newlines between them
+                if (pending && lineEnd - begin > maxSize)
+                {
+                    flush();
+                }
+                if (!pending)
+                {
+                    begin = pos;
+                    pending = true;
+                }
+                end = lineEnd;
+            }
+            pos = lineEnd + 1;
+        }
+        flush();
+        return result;
+    }
+}
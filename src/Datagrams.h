@@ -0,0 +1,45 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace influxdb::internal
+{
+    /// Datagrams of line protocol split at line boundaries
+    struct Datagrams
+    {
+        /// Views on the datagrams, the lines of a datagram are separated by newlines
+        std::vector<std::string_view> datagrams;
+
+        /// Lines larger than the maximum datagram size, not part of any datagram
+        std::vector<std::string_view> oversizeLines;
+    };
+
+    /// Splits line protocol into as few datagrams of at most maxSize bytes as possible without splitting
+    /// lines; the datagrams are views on the data, the newlines between datagrams are dropped
+    Datagrams packDatagrams(std::string_view data, std::size_t maxSize);
+}
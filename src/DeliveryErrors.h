@@ -0,0 +1,38 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "InfluxDBException.h"
+#include <exception>
+
+namespace influxdb::internal
+{
+    /// Decides whether sending a message again fails the same way, e.g. as the server rejects it or a line is larger
+    /// than a datagram. Such messages are not sent again, the part which was already delivered would be duplicated
+    /// otherwise; other errors, e.g. of the connection or the server, are transient.
+    inline bool isPermanentError(const std::exception& error)
+    {
+        return dynamic_cast<const BadRequest*>(&error) != nullptr || dynamic_cast<const NonExistentDatabase*>(&error) != nullptr ||
+               dynamic_cast<const SchemaConflict*>(&error) != nullptr;
+    }
+}
@@ -0,0 +1,425 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "FileSink.h"
+#include "InfluxDBException.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef INFLUXCXX_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace influxdb::transports
+{
+#ifndef _WIN32
+
+namespace
+{
+  std::string systemError(const std::string& what)
+  {
+    return what + ": " + std::strerror(errno);
+  }
+
+  /// Compresses the file to `<path>.gz` and removes it; the compressed file appears once complete
+  void compressFile(const std::string& path)
+  {
+#ifdef INFLUXCXX_WITH_ZLIB
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+      throw InfluxDBException(__func__, systemError("Cannot open " + path));
+    }
+    const auto partial = path + ".gz.tmp";
+    // Fastest level, compression must keep up with files rotated at the write rate
+    gzFile compressed = ::gzopen(partial.c_str(), "wb1");
+    if (compressed == nullptr)
+    {
+      ::close(fd);
+      throw InfluxDBException(__func__, "Cannot create " + partial);
+    }
+
+    constexpr std::size_t chunkSize{1024 * 1024};
+    const auto chunk = std::make_unique<char[]>(chunkSize);
+    ssize_t count{0};
+    bool failed{false};
+    while ((count = ::read(fd, chunk.get(), chunkSize)) != 0)
+    {
+      if (count < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (count < 0 || ::gzwrite(compressed, chunk.get(), static_cast<unsigned>(count)) != static_cast<int>(count))
+      {
+        failed = true;
+        break;
+      }
+    }
+    ::close(fd);
+    failed = (::gzclose(compressed) != Z_OK) || failed;
+    if (failed || std::rename(partial.c_str(), (path + ".gz").c_str()) != 0)
+    {
+      std::remove(partial.c_str());
+      throw InfluxDBException(__func__, "Cannot compress " + path);
+    }
+    std::remove(path.c_str());
+#else
+    throw InfluxDBException(__func__, "Compression of " + path + " requires zlib");
+#endif
+  }
+}
+
+FileSink::FileSink(const std::string& path, std::size_t bufferSize) :
+  mPath(path), mFd(-1), mFileSize(0), mBuffer(std::make_unique<char[]>(bufferSize)), mBufferSize(bufferSize), mBuffered(0),
+  mMaxFileSize(0), mRotateInterval(0), mCompress(false), mSync(Sync::None)
+{
+  open();
+}
+
+FileSink::~FileSink()
+{
+  try
+  {
+    writeBuffer();
+    if (mSync != Sync::None)
+    {
+      sync();
+    }
+  }
+  catch (const InfluxDBException&)
+  {
+    // Destructors must not throw, the data is lost
+  }
+  if (mFd >= 0)
+  {
+    ::close(mFd);
+  }
+  if (mCompression.valid())
+  {
+    mCompression.wait();
+  }
+}
+
+void FileSink::send(std::string&& message)
+{
+  append(message);
+  endMessage();
+}
+
+void FileSink::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  for (const auto& buffer : buffers)
+  {
+    append(buffer);
+  }
+  endMessage();
+}
+
+void FileSink::sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer)
+{
+  for (;;)
+  {
+    if (mBuffered == mBufferSize)
+    {
+      writeBuffer();
+    }
+    const auto written = producer(mBuffer.get() + mBuffered, mBufferSize - mBuffered);
+    if (written == 0)
+    {
+      break;
+    }
+    mBuffered += written;
+    mFileSize += written;
+  }
+  endMessage();
+}
+
+void FileSink::flush()
+{
+  writeBuffer();
+  if (mSync == Sync::Flush)
+  {
+    sync();
+  }
+  if (mRotateInterval.count() > 0 && std::chrono::steady_clock::now() - mOpened >= mRotateInterval)
+  {
+    rotate();
+  }
+  if (mCompression.valid() && mCompression.wait_for(std::chrono::seconds{0}) == std::future_status::ready)
+  {
+    finishCompression();
+  }
+  if (mError)
+  {
+    std::rethrow_exception(std::exchange(mError, nullptr));
+  }
+}
+
+void FileSink::setMaxFileSize(std::size_t bytes)
+{
+  mMaxFileSize = bytes;
+}
+
+void FileSink::setRotateInterval(std::chrono::milliseconds interval)
+{
+  mRotateInterval = interval;
+}
+
+void FileSink::enableCompression()
+{
+#ifdef INFLUXCXX_WITH_ZLIB
+  mCompress = true;
+#else
+  throw InfluxDBException(__func__, "Compression requires zlib");
+#endif
+}
+
+void FileSink::setSync(Sync sync)
+{
+  mSync = sync;
+}
+
+void FileSink::append(std::string_view data)
+{
+  mFileSize += data.size();
+  if (mBuffered + data.size() <= mBufferSize)
+  {
+    std::memcpy(mBuffer.get() + mBuffered, data.data(), data.size());
+    mBuffered += data.size();
+    return;
+  }
+
+  writeBuffer();
+  if (data.size() >= mBufferSize)
+  {
+    writeToFile(data.data(), data.size());
+    return;
+  }
+  std::memcpy(mBuffer.get(), data.data(), data.size());
+  mBuffered = data.size();
+}
+
+void FileSink::endMessage()
+{
+  append("\n");
+  if ((mMaxFileSize > 0 && mFileSize >= mMaxFileSize) ||
+      (mRotateInterval.count() > 0 && std::chrono::steady_clock::now() - mOpened >= mRotateInterval))
+  {
+    rotate();
+  }
+}
+
+void FileSink::writeBuffer()
+{
+  if (mBuffered == 0)
+  {
+    return;
+  }
+  // The buffer is discarded if writing fails, the error is reported once
+  const auto size = std::exchange(mBuffered, 0);
+  writeToFile(mBuffer.get(), size);
+}
+
+void FileSink::writeToFile(const char* data, std::size_t size)
+{
+  if (mFd < 0)
+  {
+    // Opening failed on rotation, throws again while the file cannot be opened
+    open();
+  }
+  while (size > 0)
+  {
+    const auto written = ::write(mFd, data, size);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      throw InfluxDBException(__func__, systemError("Cannot write " + mPath));
+    }
+    data += written;
+    size -= static_cast<std::size_t>(written);
+  }
+  if (mSync == Sync::Write)
+  {
+    sync();
+  }
+}
+
+void FileSink::open()
+{
+  mFd = ::open(mPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (mFd < 0)
+  {
+    throw InfluxDBException(__func__, systemError("Cannot open " + mPath));
+  }
+  struct stat status{};
+  // Data appended while the file was not open is counted already
+  mFileSize += (::fstat(mFd, &status) == 0 ? static_cast<std::uint64_t>(status.st_size) : 0);
+  mOpened = std::chrono::steady_clock::now();
+}
+
+void FileSink::rotate()
+{
+  writeBuffer();
+  // The messages are written, sending them again would duplicate them; later errors are reported by flush()
+  try
+  {
+    if (mSync != Sync::None)
+    {
+      sync();
+    }
+  }
+  catch (const InfluxDBException&)
+  {
+    recordError(std::current_exception());
+  }
+  if (mFd >= 0)
+  {
+    ::close(mFd);
+    mFd = -1;
+  }
+  // Also if renaming fails, the rotation is not retried for every message
+  mFileSize = 0;
+  mOpened = std::chrono::steady_clock::now();
+
+  const auto epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch());
+  const auto rotated = mPath + "." + std::to_string(epoch.count());
+  if (std::rename(mPath.c_str(), rotated.c_str()) != 0)
+  {
+    // The file is opened again by the next write
+    recordError(std::make_exception_ptr(InfluxDBException(__func__, systemError("Cannot rotate " + mPath))));
+    return;
+  }
+
+  if (mCompress)
+  {
+    // A compression still running delays the writer
+    finishCompression();
+    mCompression = std::async(std::launch::async, compressFile, rotated);
+  }
+  try
+  {
+    open();
+  }
+  catch (const InfluxDBException&)
+  {
+    recordError(std::current_exception());
+  }
+}
+
+void FileSink::finishCompression()
+{
+  if (!mCompression.valid())
+  {
+    return;
+  }
+  try
+  {
+    mCompression.get();
+  }
+  catch (const InfluxDBException&)
+  {
+    recordError(std::current_exception());
+  }
+}
+
+void FileSink::recordError(std::exception_ptr error)
+{
+  if (!mError)
+  {
+    mError = std::move(error);
+  }
+}
+
+void FileSink::sync()
+{
+  if (mFd < 0)
+  {
+    return;
+  }
+#ifdef __APPLE__
+  const int result = ::fsync(mFd);
+#else
+  const int result = ::fdatasync(mFd);
+#endif
+  if (result != 0)
+  {
+    throw InfluxDBException(__func__, systemError("Cannot synchronize " + mPath));
+  }
+}
+
+#else
+
+FileSink::FileSink(const std::string&, std::size_t) :
+  mFd(-1), mFileSize(0), mBufferSize(0), mBuffered(0), mMaxFileSize(0), mRotateInterval(0), mCompress(false), mSync(Sync::None)
+{
+  throw InfluxDBException{__func__, "File transport not supported on this system"};
+}
+
+FileSink::~FileSink() = default;
+
+void FileSink::send(std::string&&)
+{
+}
+
+void FileSink::sendBuffers(const std::vector<std::string_view>&)
+{
+}
+
+void FileSink::sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>&)
+{
+}
+
+void FileSink::flush()
+{
+}
+
+void FileSink::setMaxFileSize(std::size_t)
+{
+}
+
+void FileSink::setRotateInterval(std::chrono::milliseconds)
+{
+}
+
+void FileSink::enableCompression()
+{
+}
+
+void FileSink::setSync(Sync)
+{
+}
+
+#endif // _WIN32
+
+} // namespace influxdb::transports
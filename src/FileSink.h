@@ -0,0 +1,158 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef INFLUXDATA_TRANSPORTS_FILESINK_H
+#define INFLUXDATA_TRANSPORTS_FILESINK_H
+
+#include "Transport.h"
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <string>
+
+namespace influxdb::transports
+{
+
+/// \brief File transport appending newline terminated messages to a file, e.g. for `influx -import`;
+/// messages are collected in a large buffer written by a single system call once full. The file is
+/// rotated at message boundaries by size or age, rotated files are renamed to `<path>.<nanoseconds since epoch>`
+/// and optionally compressed to `.gz` by a background thread.
+class FileSink : public Transport
+{
+  public:
+    /// When the written data is synchronized to the storage device
+    enum class Sync
+    {
+        /// Left to the operating system
+        None,
+        /// Before a file is rotated and closed
+        Rotate,
+        /// On flush() and rotation
+        Flush,
+        /// After every write of the buffer
+        Write
+    };
+
+    /// Default size of the buffer
+    static constexpr std::size_t defaultBufferSize{4 * 1024 * 1024};
+
+    /// Constructor, appends to the file if it exists
+    /// \param bufferSize 	size of the buffer, larger messages are written without copying
+    /// \throw InfluxDBException 	if the file cannot be opened
+    explicit FileSink(const std::string& path, std::size_t bufferSize = defaultBufferSize);
+
+    /// Writes the buffer and waits for a running compression
+    ~FileSink() override;
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    /// Appends the message; the message is written once the file is rotated, errors of the rotation
+    /// are reported by flush() so the message is not sent again
+    /// \throw InfluxDBException 	if writing fails
+    void send(std::string&& message) override;
+
+    /// Appends the buffers as one message, without joining them first
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    /// Appends the produced data as one message, the producer writes into the buffer directly
+    void sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer) override;
+
+    /// Writes the buffer to the file
+    /// \throw InfluxDBException 	if writing fails, or a rotation or compression failed since the last report
+    void flush() override;
+
+    /// Rotates the file once it reaches the size, 0 disables rotation by size
+    void setMaxFileSize(std::size_t bytes);
+
+    /// Rotates the file once it is open for the interval, zero disables rotation by age;
+    /// the age is checked when messages are appended or flushed
+    void setRotateInterval(std::chrono::milliseconds interval);
+
+    /// Compresses rotated files with gzip
+    /// \throw InfluxDBException 	if built without zlib
+    void enableCompression();
+
+    void setSync(Sync sync);
+
+  private:
+    /// Appends data of the current message to the buffer
+    void append(std::string_view data);
+
+    /// Terminates the current message and rotates the file if due
+    void endMessage();
+
+    /// Writes the buffered data to the file
+    void writeBuffer();
+
+    /// Writes data to the file, synchronizing it if configured; opens the file if it is not open
+    void writeToFile(const char* data, std::size_t size);
+
+    /// \throw InfluxDBException 	if the file cannot be opened, it is not open then
+    void open();
+
+    /// Renames the file and opens a new one; the file is left closed if renaming or opening fails.
+    /// Errors after the buffer is written are recorded
+    void rotate();
+
+    /// Waits for the compression of the last rotated file, records its error
+    void finishCompression();
+
+    /// Keeps the error to be reported by flush(), unless an earlier one is not reported yet
+    void recordError(std::exception_ptr error);
+
+    /// Synchronizes the file to the storage device
+    void sync();
+
+    std::string mPath;
+
+    /// File descriptor, -1 if the file is not open
+    int mFd;
+
+    /// Size of the file including the buffered data
+    std::uint64_t mFileSize;
+
+    std::chrono::steady_clock::time_point mOpened;
+
+    std::unique_ptr<char[]> mBuffer;
+    std::size_t mBufferSize;
+    std::size_t mBuffered;
+
+    std::size_t mMaxFileSize;
+    std::chrono::milliseconds mRotateInterval;
+    bool mCompress;
+    Sync mSync;
+
+    /// Compression of the last rotated file, invalid if none was started
+    std::future<void> mCompression;
+
+    /// Error of a rotation or compression not reported yet
+    std::exception_ptr mError;
+};
+
+} // namespace influxdb::transports
+
+#endif // INFLUXDATA_TRANSPORTS_FILESINK_H
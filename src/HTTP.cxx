@@ -26,24 +26,357 @@
 
 #include "HTTP.h"
 #include "InfluxDBException.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <utility>
 
 
 namespace influxdb::transports
 {
     namespace
     {
+        constexpr std::size_t defaultChunkSize{10000};
+        constexpr std::chrono::milliseconds defaultTimeout{10000};
+
+        /// Hedge delay used until enough write latencies are known to estimate the p95 latency
+        constexpr std::chrono::milliseconds initialHedgeDelay{100};
+        constexpr std::size_t latencyWindowSize{100};
+        constexpr std::size_t minimumLatencySamples{20};
+        constexpr std::chrono::milliseconds maximumHedgeWait{100};
+
+        int CancellationCallback(void* userp, [[maybe_unused]] curl_off_t downloadTotal, [[maybe_unused]] curl_off_t downloaded,
+                                 [[maybe_unused]] curl_off_t uploadTotal, [[maybe_unused]] curl_off_t uploaded)
+        {
+            return (*static_cast<const std::function<bool()>*>(userp))() ? 1 : 0;
+        }
+
+        struct ChunkedResponse
+        {
+            CURL* handle;
+            const std::function<void(std::string_view)>& handler;
+            std::exception_ptr error;
+            bool checked;
+            bool successful;
+        };
+
         size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp)
         {
             static_cast<std::string*>(userp)->append(static_cast<char*>(contents), size * nmemb);
             return size * nmemb;
         }
 
+        size_t ChunkedWriteCallback(void* contents, size_t size, size_t nmemb, void* userp)
+        {
+            auto* response = static_cast<ChunkedResponse*>(userp);
+
+            // Error responses are left to treatCurlResponse() and not passed to the handler
+            if (!response->checked)
+            {
+                long responseCode{0};
+                curl_easy_getinfo(response->handle, CURLINFO_RESPONSE_CODE, &responseCode);
+                response->successful = (responseCode < 300);
+                response->checked = true;
+            }
+
+            if (response->successful)
+            {
+                try
+                {
+                    response->handler(std::string_view{static_cast<char*>(contents), size * nmemb});
+                }
+                catch (...)
+                {
+                    response->error = std::current_exception();
+                    return 0;
+                }
+            }
+            return size * nmemb;
+        }
+
+        struct BufferReader
+        {
+            const std::vector<std::string_view>& buffers;
+            std::size_t index;
+            std::size_t offset;
+        };
+
+        size_t ReadCallback(char* dest, size_t size, size_t nmemb, void* userp)
+        {
+            auto* reader = static_cast<BufferReader*>(userp);
+            const std::size_t capacity = size * nmemb;
+            std::size_t written{0};
+
+            while (written < capacity && reader->index < reader->buffers.size())
+            {
+                const auto buffer = reader->buffers[reader->index].substr(reader->offset);
+                const auto count = buffer.copy(dest + written, capacity - written);
+                written += count;
+                reader->offset += count;
+
+                if (reader->offset == reader->buffers[reader->index].size())
+                {
+                    ++reader->index;
+                    reader->offset = 0;
+                }
+            }
+            return written;
+        }
+
+        curl_off_t totalSize(const std::vector<std::string_view>& buffers)
+        {
+            curl_off_t size{0};
+            for (const auto& buffer : buffers)
+            {
+                size += static_cast<curl_off_t>(buffer.size());
+            }
+            return size;
+        }
+
+        void prepareUpload(CURL* handle, BufferReader& reader, curl_off_t size)
+        {
+            curl_easy_setopt(handle, CURLOPT_POSTFIELDS, nullptr);
+            curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE_LARGE, size);
+            curl_easy_setopt(handle, CURLOPT_READFUNCTION, ReadCallback);
+            curl_easy_setopt(handle, CURLOPT_READDATA, &reader);
+        }
+
+        /// Responses which are not improved by waiting for another endpoint
+        bool isDefinitive(CURLcode response, long responseCode)
+        {
+            return response == CURLE_OK && responseCode < 500;
+        }
+
+        struct StreamReader
+        {
+            const std::function<std::size_t(char*, std::size_t)>& producer;
+            std::exception_ptr error;
+        };
+
+        size_t StreamReadCallback(char* dest, size_t size, size_t nmemb, void* userp)
+        {
+            auto* reader = static_cast<StreamReader*>(userp);
+            try
+            {
+                return reader->producer(dest, size * nmemb);
+            }
+            catch (...)
+            {
+                reader->error = std::current_exception();
+                return CURL_READFUNC_ABORT;
+            }
+        }
+
         size_t noopWriteCallBack([[maybe_unused]] char* ptr, size_t size,
                                  size_t nmemb, [[maybe_unused]] void* userdata)
         {
             return size * nmemb;
         }
 
+        /// Whether four hex digits follow at offset
+        bool isHexEscape(const std::string& text, std::size_t offset)
+        {
+            return offset + 4 <= text.size() &&
+                   std::all_of(text.cbegin() + static_cast<std::ptrdiff_t>(offset), text.cbegin() + static_cast<std::ptrdiff_t>(offset + 4),
+                               [](unsigned char c) { return std::isxdigit(c) != 0; });
+        }
+
+        /// Appends the code point encoded as UTF-8
+        void appendUtf8(std::string& text, std::uint32_t codePoint)
+        {
+            if (codePoint < 0x80)
+            {
+                text.push_back(static_cast<char>(codePoint));
+            }
+            else if (codePoint < 0x800)
+            {
+                text.push_back(static_cast<char>(0xc0 | (codePoint >> 6)));
+                text.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+            }
+            else if (codePoint < 0x10000)
+            {
+                text.push_back(static_cast<char>(0xe0 | (codePoint >> 12)));
+                text.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+                text.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+            }
+            else
+            {
+                text.push_back(static_cast<char>(0xf0 | (codePoint >> 18)));
+                text.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f)));
+                text.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+                text.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+            }
+        }
+
+        /// Decodes the \uXXXX escape whose digits start at offset, a surrogate pair spans two escapes
+        /// \return code point and length of the digits consumed, or a length of 0 if the escape is invalid
+        std::pair<std::uint32_t, std::size_t> unicodeEscape(const std::string& text, std::size_t offset)
+        {
+            if (!isHexEscape(text, offset))
+            {
+                return {0, 0};
+            }
+            const auto unit = static_cast<std::uint32_t>(std::stoul(text.substr(offset, 4), nullptr, 16));
+            if (unit < 0xd800 || unit > 0xdfff)
+            {
+                return {unit, 4};
+            }
+            // A high surrogate must be followed by the escape of a low one
+            if (unit <= 0xdbff && text.compare(offset + 4, 2, "\\u") == 0 && isHexEscape(text, offset + 6))
+            {
+                const auto low = static_cast<std::uint32_t>(std::stoul(text.substr(offset + 6, 4), nullptr, 16));
+                if (low >= 0xdc00 && low <= 0xdfff)
+                {
+                    return {0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00), 10};
+                }
+            }
+            return {0, 0};
+        }
+
+        /// Extracts the unescaped message of an error response ({"error":"..."})
+        std::string errorMessage(const std::string& responseBody)
+        {
+            static constexpr std::string_view key{"\"error\":\""};
+            const auto begin = responseBody.find(key);
+            if (begin == std::string::npos)
+            {
+                return responseBody;
+            }
+
+            std::string message;
+            for (auto i = begin + key.size(); i < responseBody.size() && responseBody[i] != '"'; ++i)
+            {
+                if (responseBody[i] == '\\' && ++i < responseBody.size())
+                {
+                    switch (responseBody[i])
+                    {
+                        case 'n':
+                            message.push_back('\n');
+                            break;
+                        case 't':
+                            message.push_back('\t');
+                            break;
+                        case 'r':
+                            message.push_back('\r');
+                            break;
+                        case 'u':
+                            if (const auto [codePoint, length] = unicodeEscape(responseBody, i + 1); length > 0)
+                            {
+                                appendUtf8(message, codePoint);
+                                i += length;
+                            }
+                            else
+                            {
+                                // Truncated or invalid escape, kept as is
+                                message.append("\\u");
+                            }
+                            break;
+                        default:
+                            message.push_back(responseBody[i]);
+                            break;
+                    }
+                }
+                else
+                {
+                    message.push_back(responseBody[i]);
+                }
+            }
+            return message;
+        }
+
+        /// Extracts the lines and reasons of "unable to parse '<line>': <reason>" errors
+        std::vector<std::pair<std::string, std::string>> unparsableLines(const std::string& error)
+        {
+            static constexpr std::string_view prefix{"unable to parse '"};
+            static constexpr std::string_view separator{"': "};
+            std::vector<std::pair<std::string, std::string>> lines;
+
+            for (auto begin = error.find(prefix); begin != std::string::npos; begin = error.find(prefix, begin))
+            {
+                begin += prefix.size();
+                const auto end = error.find(separator, begin);
+                if (end == std::string::npos)
+                {
+                    break;
+                }
+                const auto reasonEnd = std::min(error.find('\n', end), error.size());
+                lines.emplace_back(error.substr(begin, end - begin), error.substr(end + separator.size(), reasonEnd - end - separator.size()));
+                begin = reasonEnd;
+            }
+            return lines;
+        }
+
+        std::vector<std::string_view> splitLines(std::string_view message)
+        {
+            std::vector<std::string_view> lines;
+            while (!message.empty())
+            {
+                const auto end = std::min(message.find('\n'), message.size());
+                if (end > 0)
+                {
+                    lines.push_back(message.substr(0, end));
+                }
+                message.remove_prefix(std::min(end + 1, message.size()));
+            }
+            return lines;
+        }
+
+        /// Whether the line carries a timestamp, i.e. a third section after the unescaped, unquoted spaces
+        /// separating measurement and tags, fields and timestamp
+        bool hasTimestamp(std::string_view line)
+        {
+            std::size_t sections{1};
+            bool quoted{false};
+            for (std::size_t i = 0; i < line.size(); ++i)
+            {
+                if (line[i] == '\\')
+                {
+                    ++i;
+                }
+                else if (line[i] == '"')
+                {
+                    quoted = !quoted;
+                }
+                else if (line[i] == ' ' && !quoted && i + 1 < line.size() && line[i + 1] != ' ')
+                {
+                    ++sections;
+                }
+            }
+            return sections > 2;
+        }
+
+        /// Whether every line of the message carries a timestamp, lines may span buffers
+        bool everyLineHasTimestamp(const std::vector<std::string_view>& buffers)
+        {
+            if (buffers.size() == 1)
+            {
+                const auto lines = splitLines(buffers.front());
+                return std::all_of(lines.begin(), lines.end(), hasTimestamp);
+            }
+            std::string message;
+            for (const auto buffer : buffers)
+            {
+                message.append(buffer);
+            }
+            const auto lines = splitLines(message);
+            return std::all_of(lines.begin(), lines.end(), hasTimestamp);
+        }
+
+        std::vector<std::string_view> lineBuffers(const std::vector<std::string_view>& lines)
+        {
+            static constexpr std::string_view separator{"\n"};
+            std::vector<std::string_view> buffers;
+            buffers.reserve(lines.size() * 2);
+            for (const auto& line : lines)
+            {
+                buffers.push_back(line);
+                buffers.push_back(separator);
+            }
+            return buffers;
+        }
+
         void setConnectionOptions(CURL* handle)
         {
             curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, 10);
@@ -80,6 +413,8 @@ namespace influxdb::transports
     }
 
 HTTP::HTTP(const std::string &url)
+    : hedgeHandle{nullptr}, multiHandle{nullptr}, mChunkSize{defaultChunkSize}, mQueryHeaders{nullptr},
+      mConnectTimeout{defaultTimeout}, mWriteTimeout{defaultTimeout}, mQueryTimeout{defaultTimeout}, mNextLatency{0}
 {
   initCurl(url);
   initCurlRead(url);
@@ -89,8 +424,24 @@ HTTP::HTTP(const std::string &url)
 
 HTTP::~HTTP()
 {
+  if (hedgeHandle != nullptr)
+  {
+    curl_easy_cleanup(hedgeHandle);
+    curl_multi_cleanup(multiHandle);
+  }
   curl_easy_cleanup(writeHandle);
-  curl_easy_cleanup(readHandle);
+  for (CURL* handle : mReadHandles)
+  {
+    curl_easy_cleanup(handle);
+  }
+  if (mQueryHeaders != nullptr)
+  {
+    curl_slist_free_all(mQueryHeaders);
+  }
+  for (curl_slist* headers : mRetiredQueryHeaders)
+  {
+    curl_slist_free_all(headers);
+  }
   curl_global_cleanup();
 }
 
@@ -101,6 +452,11 @@ void HTTP::initCurl(const std::string &url)
     throw InfluxDBException(__func__, curl_easy_strerror(globalInitResult));
   }
 
+  writeHandle = createWriteHandle(writeUrlOf(url));
+}
+
+std::string HTTP::writeUrlOf(const std::string &url)
+{
   std::string writeUrl = url;
   auto position = writeUrl.find('?');
   if (position == std::string::npos)
@@ -115,12 +471,12 @@ void HTTP::initCurl(const std::string &url)
   {
     writeUrl.insert(position, "write");
   }
-  writeHandle = createWriteHandle(writeUrl);
+  return writeUrl;
 }
 
 void HTTP::initCurlRead(const std::string &url)
 {
-  mReadUrl = url + "&q=";
+  mReadUrl = url + "&";
   const auto pos = mReadUrl.find('?');
   std::string cmd{"query"};
 
@@ -131,33 +487,289 @@ void HTTP::initCurlRead(const std::string &url)
 
   mReadUrl.insert(pos, cmd);
   readHandle = createReadHandle();
+  mReadHandles.push_back(readHandle);
+  mIdleReadHandles.push_back(readHandle);
+}
+
+class HTTP::ReadHandleLease
+{
+public:
+  explicit ReadHandleLease(HTTP &http) : owner(http), handle(http.acquireReadHandle())
+  {
+  }
+
+  ReadHandleLease(const ReadHandleLease &) = delete;
+  ReadHandleLease &operator=(const ReadHandleLease &) = delete;
+
+  ~ReadHandleLease()
+  {
+    owner.releaseReadHandle(handle);
+  }
+
+  HTTP &owner;
+  CURL *const handle;
+};
+
+CURL *HTTP::acquireReadHandle()
+{
+  std::lock_guard<std::mutex> lock{mReadHandlesMutex};
+  if (!mIdleReadHandles.empty())
+  {
+    CURL *handle = mIdleReadHandles.back();
+    mIdleReadHandles.pop_back();
+    return handle;
+  }
+
+  CURL *handle = createReadHandle();
+  mReadHandles.push_back(handle);
+  applyReadSettings(handle);
+  return handle;
+}
+
+void HTTP::releaseReadHandle(CURL *handle)
+{
+  std::lock_guard<std::mutex> lock{mReadHandlesMutex};
+  if (const auto stale = std::find(mStaleReadHandles.begin(), mStaleReadHandles.end(), handle); stale != mStaleReadHandles.end())
+  {
+    // The settings changed while the handle was leased
+    applyReadSettings(handle);
+    mStaleReadHandles.erase(stale);
+  }
+  mIdleReadHandles.push_back(handle);
+  freeRetiredQueryHeaders();
+}
+
+void HTTP::applyReadSettings(CURL *handle) const
+{
+  curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(mConnectTimeout.count()));
+  curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, static_cast<long>(mQueryTimeout.count()));
+  if (!mAuth.empty())
+  {
+    curl_easy_setopt(handle, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+    curl_easy_setopt(handle, CURLOPT_USERPWD, mAuth.c_str());
+  }
+  if (mQueryHeaders != nullptr)
+  {
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, mQueryHeaders);
+  }
+}
+
+void HTTP::updateReadHandles(const std::function<void(CURL *)> &apply)
+{
+  // curl handles must not be changed while a query uses them
+  for (CURL *handle : mReadHandles)
+  {
+    if (std::find(mIdleReadHandles.begin(), mIdleReadHandles.end(), handle) != mIdleReadHandles.end())
+    {
+      apply(handle);
+    }
+    else if (std::find(mStaleReadHandles.begin(), mStaleReadHandles.end(), handle) == mStaleReadHandles.end())
+    {
+      mStaleReadHandles.push_back(handle);
+    }
+  }
 }
 
 std::string HTTP::query(const std::string &query)
 {
+  ReadHandleLease lease{*this};
   long responseCode;
   std::string buffer;
-  char* encodedQuery = curl_easy_escape(readHandle, query.c_str(), static_cast<int>(query.size()));
-  auto fullUrl = mReadUrl + std::string(encodedQuery);
-  curl_free(encodedQuery);
-  curl_easy_setopt(readHandle, CURLOPT_URL, fullUrl.c_str());
-  curl_easy_setopt(readHandle, CURLOPT_WRITEDATA, &buffer);
-  const CURLcode response = curl_easy_perform(readHandle);
-  curl_easy_getinfo(readHandle, CURLINFO_RESPONSE_CODE, &responseCode);
+  curl_easy_setopt(lease.handle, CURLOPT_URL, queryUrl(lease.handle, query, mQueryParameters).c_str());
+  curl_easy_setopt(lease.handle, CURLOPT_WRITEDATA, &buffer);
+  const CURLcode response = curl_easy_perform(lease.handle);
+  curl_easy_getinfo(lease.handle, CURLINFO_RESPONSE_CODE, &responseCode);
   treatCurlResponse(response, responseCode);
   return buffer;
 }
 
+void HTTP::queryChunked(const std::string &query, const std::function<void(std::string_view)> &onChunk)
+{
+  runChunkedQuery(query, onChunk, nullptr);
+}
+
+void HTTP::queryCancellable(const std::string &query, const std::function<void(std::string_view)> &onChunk,
+                            const std::function<bool()> &isCancelled)
+{
+  runChunkedQuery(query, onChunk, &isCancelled);
+}
+
+void HTTP::runChunkedQuery(const std::string &query, const std::function<void(std::string_view)> &onChunk,
+                           const std::function<bool()> *isCancelled)
+{
+  ReadHandleLease lease{*this};
+  long responseCode;
+  ChunkedResponse chunkedResponse{lease.handle, onChunk, nullptr, false, false};
+  curl_easy_setopt(lease.handle, CURLOPT_URL, queryUrl(lease.handle, query, "chunked=true&chunk_size=" + std::to_string(mChunkSize) + "&" + mQueryParameters).c_str());
+  curl_easy_setopt(lease.handle, CURLOPT_WRITEFUNCTION, ChunkedWriteCallback);
+  curl_easy_setopt(lease.handle, CURLOPT_WRITEDATA, &chunkedResponse);
+  if (isCancelled != nullptr)
+  {
+    // The progress callback is also called while waiting for the response
+    curl_easy_setopt(lease.handle, CURLOPT_XFERINFOFUNCTION, CancellationCallback);
+    curl_easy_setopt(lease.handle, CURLOPT_XFERINFODATA, isCancelled);
+    curl_easy_setopt(lease.handle, CURLOPT_NOPROGRESS, 0L);
+  }
+  const CURLcode response = curl_easy_perform(lease.handle);
+  curl_easy_setopt(lease.handle, CURLOPT_WRITEFUNCTION, WriteCallback);
+  if (isCancelled != nullptr)
+  {
+    curl_easy_setopt(lease.handle, CURLOPT_NOPROGRESS, 1L);
+  }
+
+  if (chunkedResponse.error)
+  {
+    std::rethrow_exception(chunkedResponse.error);
+  }
+  if (response == CURLE_ABORTED_BY_CALLBACK && isCancelled != nullptr)
+  {
+    throw QueryCancelled{__func__, "Query cancelled"};
+  }
+  curl_easy_getinfo(lease.handle, CURLINFO_RESPONSE_CODE, &responseCode);
+  treatCurlResponse(response, responseCode);
+}
+
+std::string HTTP::queryUrl(CURL *handle, const std::string &query, const std::string &parameters)
+{
+  char* encodedQuery = curl_easy_escape(handle, query.c_str(), static_cast<int>(query.size()));
+  auto fullUrl = mReadUrl + parameters + "q=" + std::string(encodedQuery);
+  curl_free(encodedQuery);
+  return fullUrl;
+}
+
+void HTTP::setRejectedLinesHandler(RejectedLinesHandler handler)
+{
+  mRejectedLinesHandler = std::move(handler);
+}
+
+void HTTP::setConnectTimeout(std::chrono::milliseconds timeout)
+{
+  curl_easy_setopt(writeHandle, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(timeout.count()));
+  std::lock_guard<std::mutex> lock{mReadHandlesMutex};
+  mConnectTimeout = timeout;
+  updateReadHandles([timeout](CURL *handle) {
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(timeout.count()));
+  });
+  if (hedgeHandle != nullptr)
+  {
+    curl_easy_setopt(hedgeHandle, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(timeout.count()));
+  }
+}
+
+void HTTP::setWriteTimeout(std::chrono::milliseconds timeout)
+{
+  mWriteTimeout = timeout;
+  curl_easy_setopt(writeHandle, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count()));
+  if (hedgeHandle != nullptr)
+  {
+    curl_easy_setopt(hedgeHandle, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count()));
+  }
+}
+
+void HTTP::setQueryTimeout(std::chrono::milliseconds timeout)
+{
+  std::lock_guard<std::mutex> lock{mReadHandlesMutex};
+  mQueryTimeout = timeout;
+  updateReadHandles([timeout](CURL *handle) { curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count())); });
+}
+
+void HTTP::enableEpochTimestamps()
+{
+  mQueryParameters = "epoch=ns&";
+}
+
+void HTTP::setQueryFormat(QueryFormat format)
+{
+  const char* accept = "Accept: application/json";
+  if (format == QueryFormat::Csv)
+  {
+    accept = "Accept: application/csv";
+  }
+  else if (format == QueryFormat::MessagePack)
+  {
+    accept = "Accept: application/x-msgpack";
+  }
+
+  // Queries running on leased handles keep using the previous headers, which are freed once all handles are idle
+  curl_slist* headers = curl_slist_append(nullptr, accept);
+  std::lock_guard<std::mutex> lock{mReadHandlesMutex};
+  updateReadHandles([headers](CURL *handle) { curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers); });
+  if (mQueryHeaders != nullptr)
+  {
+    mRetiredQueryHeaders.push_back(mQueryHeaders);
+  }
+  mQueryHeaders = headers;
+  freeRetiredQueryHeaders();
+}
+
+void HTTP::freeRetiredQueryHeaders()
+{
+  if (mIdleReadHandles.size() < mReadHandles.size())
+  {
+    return;
+  }
+  for (curl_slist* headers : mRetiredQueryHeaders)
+  {
+    curl_slist_free_all(headers);
+  }
+  mRetiredQueryHeaders.clear();
+}
+
+void HTTP::enableHedgedWrites(const std::string &url)
+{
+  if (hedgeHandle != nullptr)
+  {
+    throw InfluxDBException{__func__, "Hedged writes already enabled"};
+  }
+
+  multiHandle = curl_multi_init();
+  if (multiHandle == nullptr)
+  {
+    throw InfluxDBException{__func__, "Failed to initialize multi handle"};
+  }
+  hedgeHandle = createWriteHandle(writeUrlOf(url));
+  curl_easy_setopt(hedgeHandle, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(mConnectTimeout.count()));
+  curl_easy_setopt(hedgeHandle, CURLOPT_TIMEOUT_MS, static_cast<long>(mWriteTimeout.count()));
+  if (!mAuth.empty())
+  {
+    curl_easy_setopt(hedgeHandle, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+    curl_easy_setopt(hedgeHandle, CURLOPT_USERPWD, mAuth.c_str());
+  }
+  mWriteLatencies.reserve(latencyWindowSize);
+}
+
 void HTTP::enableBasicAuth(const std::string &auth)
 {
   curl_easy_setopt(writeHandle, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
   curl_easy_setopt(writeHandle, CURLOPT_USERPWD, auth.c_str());
-  curl_easy_setopt(readHandle, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
-  curl_easy_setopt(readHandle, CURLOPT_USERPWD, auth.c_str());
+  {
+    std::lock_guard<std::mutex> lock{mReadHandlesMutex};
+    mAuth = auth;
+    updateReadHandles([&auth](CURL *handle) {
+      curl_easy_setopt(handle, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+      curl_easy_setopt(handle, CURLOPT_USERPWD, auth.c_str());
+    });
+  }
+  if (hedgeHandle != nullptr)
+  {
+    curl_easy_setopt(hedgeHandle, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+    curl_easy_setopt(hedgeHandle, CURLOPT_USERPWD, auth.c_str());
+  }
 }
 
 void HTTP::send(std::string &&lineprotocol)
 {
+  if (mRejectedLinesHandler)
+  {
+    sendResolvingRejectedLines({lineprotocol});
+    return;
+  }
+  if (hedgeHandle != nullptr && everyLineHasTimestamp({lineprotocol}))
+  {
+    sendHedged({lineprotocol});
+    return;
+  }
+
   long responseCode;
   curl_easy_setopt(writeHandle, CURLOPT_POSTFIELDS, lineprotocol.c_str());
   curl_easy_setopt(writeHandle, CURLOPT_POSTFIELDSIZE, static_cast<long>(lineprotocol.length()));
@@ -166,6 +778,265 @@ void HTTP::send(std::string &&lineprotocol)
   treatCurlResponse(response, responseCode);
 }
 
+void HTTP::sendBuffers(const std::vector<std::string_view> &buffers)
+{
+  if (mRejectedLinesHandler)
+  {
+    sendResolvingRejectedLines(buffers);
+    return;
+  }
+  if (hedgeHandle != nullptr && everyLineHasTimestamp(buffers))
+  {
+    sendHedged(buffers);
+    return;
+  }
+
+  long responseCode;
+  const CURLcode response = postBuffers(buffers, nullptr, responseCode);
+  treatCurlResponse(response, responseCode);
+}
+
+void HTTP::sendHedged(const std::vector<std::string_view> &buffers)
+{
+  const curl_off_t size = totalSize(buffers);
+  BufferReader primaryReader{buffers, 0, 0};
+  BufferReader hedgeReader{buffers, 0, 0};
+  prepareUpload(writeHandle, primaryReader, size);
+  prepareUpload(hedgeHandle, hedgeReader, size);
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto hedgeAt = start + hedgeDelay();
+  curl_multi_add_handle(multiHandle, writeHandle);
+  bool hedged{false};
+  int active{1};
+  CURLcode response{CURLE_OK};
+  long responseCode{0};
+  bool finished{false};
+
+  while (!finished)
+  {
+    int running;
+    curl_multi_perform(multiHandle, &running);
+
+    int queued;
+    while (CURLMsg* message = curl_multi_info_read(multiHandle, &queued))
+    {
+      if (message->msg != CURLMSG_DONE)
+      {
+        continue;
+      }
+      --active;
+      response = message->data.result;
+      curl_easy_getinfo(message->easy_handle, CURLINFO_RESPONSE_CODE, &responseCode);
+      finished = isDefinitive(response, responseCode);
+    }
+
+    if (!finished && !hedged && (active == 0 || std::chrono::steady_clock::now() >= hedgeAt))
+    {
+      // A failed request is retried on the other endpoint right away
+      curl_multi_add_handle(multiHandle, hedgeHandle);
+      hedged = true;
+      ++active;
+      continue;
+    }
+    finished = finished || active == 0;
+
+    if (!finished)
+    {
+      const auto wait = hedged ? maximumHedgeWait
+                               : std::min(maximumHedgeWait, std::chrono::duration_cast<std::chrono::milliseconds>(hedgeAt - std::chrono::steady_clock::now()));
+      curl_multi_wait(multiHandle, nullptr, 0, static_cast<int>(std::max(wait.count(), std::chrono::milliseconds::rep{1})), nullptr);
+    }
+  }
+
+  // Removing a running transfer cancels the slower request
+  curl_multi_remove_handle(multiHandle, writeHandle);
+  if (hedged)
+  {
+    curl_multi_remove_handle(multiHandle, hedgeHandle);
+  }
+
+  if (isDefinitive(response, responseCode))
+  {
+    recordWriteLatency(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+  }
+  treatCurlResponse(response, responseCode);
+}
+
+std::chrono::microseconds HTTP::hedgeDelay() const
+{
+  if (mWriteLatencies.size() < minimumLatencySamples)
+  {
+    return initialHedgeDelay;
+  }
+
+  auto latencies = mWriteLatencies;
+  const auto p95 = std::next(latencies.begin(), static_cast<std::ptrdiff_t>(latencies.size() * 95 / 100));
+  std::nth_element(latencies.begin(), p95, latencies.end());
+  return *p95;
+}
+
+void HTTP::recordWriteLatency(std::chrono::microseconds latency)
+{
+  if (mWriteLatencies.size() < latencyWindowSize)
+  {
+    mWriteLatencies.push_back(latency);
+  }
+  else
+  {
+    mWriteLatencies[mNextLatency] = latency;
+  }
+  mNextLatency = (mNextLatency + 1) % latencyWindowSize;
+}
+
+CURLcode HTTP::postBuffers(const std::vector<std::string_view> &buffers, std::string *responseBody, long &responseCode)
+{
+  BufferReader reader{buffers, 0, 0};
+  prepareUpload(writeHandle, reader, totalSize(buffers));
+
+  if (responseBody != nullptr)
+  {
+    curl_easy_setopt(writeHandle, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(writeHandle, CURLOPT_WRITEDATA, responseBody);
+  }
+
+  const CURLcode response = curl_easy_perform(writeHandle);
+  curl_easy_getinfo(writeHandle, CURLINFO_RESPONSE_CODE, &responseCode);
+
+  if (responseBody != nullptr)
+  {
+    curl_easy_setopt(writeHandle, CURLOPT_WRITEFUNCTION, noopWriteCallBack);
+  }
+  return response;
+}
+
+void HTTP::sendResolvingRejectedLines(const std::vector<std::string_view> &buffers)
+{
+  long responseCode;
+  std::string responseBody;
+  const CURLcode response = postBuffers(buffers, &responseBody, responseCode);
+
+  if (response == CURLE_OK && responseCode == 400)
+  {
+    // Lines are only needed to resolve the error, the batch is joined on this path only
+    std::string message;
+    for (const auto& buffer : buffers)
+    {
+      message.append(buffer);
+    }
+    resolveRejectedLines(splitLines(message), responseBody);
+    return;
+  }
+  treatCurlResponse(response, responseCode);
+}
+
+void HTTP::resolveRejectedLines(const std::vector<std::string_view> &lines, const std::string &responseBody)
+{
+  const std::string error = errorMessage(responseBody);
+
+  if (const auto unparsable = unparsableLines(error); !unparsable.empty())
+  {
+    // The server has written all other lines
+    for (const auto& [line, reason] : unparsable)
+    {
+      const auto match = std::find(lines.cbegin(), lines.cend(), line);
+      mRejectedLinesHandler(match != lines.cend() ? *match : std::string_view{line}, reason);
+    }
+    return;
+  }
+
+  if (error.find("partial write") == std::string::npos)
+  {
+    throw BadRequest(__func__, "Bad request: " + error);
+  }
+
+  if (lines.size() == 1)
+  {
+    mRejectedLinesHandler(lines.front(), error);
+    return;
+  }
+
+  // The rejected lines are not named, but the server has written the valid ones. Resending a line is
+  // idempotent only if it carries a timestamp, otherwise the server stamps it again and stores a duplicate.
+  // Thus only timestamped lines are bisected, the others are reported as possibly rejected.
+  std::vector<std::string_view> timestamped;
+  for (const auto line : lines)
+  {
+    if (hasTimestamp(line))
+    {
+      timestamped.push_back(line);
+    }
+    else
+    {
+      mRejectedLinesHandler(line, error + " (not resent as the line has no timestamp, it may have been written)");
+    }
+  }
+
+  if (timestamped.size() < lines.size())
+  {
+    resendRejectedLines(timestamped);
+    return;
+  }
+  const auto middle = std::next(timestamped.cbegin(), static_cast<std::ptrdiff_t>(timestamped.size() / 2));
+  resendRejectedLines({timestamped.cbegin(), middle});
+  resendRejectedLines({middle, timestamped.cend()});
+}
+
+void HTTP::resendRejectedLines(const std::vector<std::string_view> &lines)
+{
+  if (lines.empty())
+  {
+    return;
+  }
+
+  long responseCode;
+  std::string responseBody;
+  const CURLcode response = postBuffers(lineBuffers(lines), &responseBody, responseCode);
+
+  if (response == CURLE_OK && responseCode == 400)
+  {
+    resolveRejectedLines(lines, responseBody);
+  }
+  else
+  {
+    treatCurlResponse(response, responseCode);
+  }
+}
+
+void HTTP::sendStream(const std::function<std::size_t(char*, std::size_t)> &producer)
+{
+  long responseCode;
+  StreamReader reader{producer, nullptr};
+  curl_slist* headers = curl_slist_append(nullptr, "Transfer-Encoding: chunked");
+  curl_easy_setopt(writeHandle, CURLOPT_POSTFIELDS, nullptr);
+  curl_easy_setopt(writeHandle, CURLOPT_POSTFIELDSIZE, -1L);
+  curl_easy_setopt(writeHandle, CURLOPT_HTTPHEADER, headers);
+  curl_easy_setopt(writeHandle, CURLOPT_READFUNCTION, StreamReadCallback);
+  curl_easy_setopt(writeHandle, CURLOPT_READDATA, &reader);
+  const CURLcode response = curl_easy_perform(writeHandle);
+  curl_easy_setopt(writeHandle, CURLOPT_HTTPHEADER, nullptr);
+  curl_slist_free_all(headers);
+
+  if (reader.error)
+  {
+    std::rethrow_exception(reader.error);
+  }
+  curl_easy_getinfo(writeHandle, CURLINFO_RESPONSE_CODE, &responseCode);
+  treatCurlResponse(response, responseCode);
+}
+
+void HTTP::sendEncoded(std::string_view body, std::string_view contentEncoding)
+{
+  long responseCode;
+  const std::string header{"Content-Encoding: " + std::string{contentEncoding}};
+  curl_slist* headers = curl_slist_append(nullptr, header.c_str());
+  curl_easy_setopt(writeHandle, CURLOPT_HTTPHEADER, headers);
+  const CURLcode response = postBuffers({body}, nullptr, responseCode);
+  curl_easy_setopt(writeHandle, CURLOPT_HTTPHEADER, nullptr);
+  curl_slist_free_all(headers);
+  treatCurlResponse(response, responseCode);
+}
+
 void HTTP::treatCurlResponse(const CURLcode &response, long responseCode) const
 {
   if (response != CURLE_OK)
@@ -29,16 +29,26 @@
 
 #include "Transport.h"
 #include <curl/curl.h>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace influxdb::transports
 {
 
-/// \brief HTTP transport
+/// \brief HTTP transport; queries may run concurrently, each using a read handle of a pool
 class HTTP : public Transport
 {
 public:
+  /// Encodings of query responses
+  enum class QueryFormat {
+    Json,
+    Csv,
+    MessagePack
+  };
+
   /// Constructor
   explicit HTTP(const std::string &url);
 
@@ -49,14 +59,64 @@ public:
   ///  \throw InfluxDBException	when CURL fails on POSTing or response code != 200
   void send(std::string &&lineprotocol) override;
 
+  /// Sends buffers via HTTP POST, streaming them to CURL without joining
+  ///  \throw InfluxDBException	when CURL fails on POSTing or response code != 200
+  void sendBuffers(const std::vector<std::string_view> &buffers) override;
+
+  /// Sends data supplied by the producer via HTTP POST using chunked transfer encoding
+  ///  \throw InfluxDBException	when CURL fails on POSTing or response code != 200
+  void sendStream(const std::function<std::size_t(char*, std::size_t)> &producer) override;
+
+  /// Sends the encoded body via HTTP POST with a Content-Encoding header, e.g. gzip compressed line protocol;
+  /// rejected lines are not resolved and hedging is bypassed
+  ///  \throw InfluxDBException	when CURL fails on POSTing or response code != 200
+  void sendEncoded(std::string_view body, std::string_view contentEncoding) override;
+
   /// Queries database
   /// \throw InfluxDBException	when CURL GET fails
   std::string query(const std::string &query) override;
 
+  /// Queries database using chunked responses, each received part is passed to the handler
+  /// \throw InfluxDBException	when CURL GET fails
+  void queryChunked(const std::string &query, const std::function<void(std::string_view)> &onChunk) override;
+
+  /// Queries database using chunked responses, the request is aborted once isCancelled returns true
+  /// \throw QueryCancelled	if the request is aborted
+  /// \throw InfluxDBException	when CURL GET fails
+  void queryCancellable(const std::string &query, const std::function<void(std::string_view)> &onChunk,
+                        const std::function<bool()> &isCancelled) override;
+
   /// Creates database used at url if it does not exists
   /// \throw InfluxDBException	when CURL POST fails
   void createDatabase() override;
 
+  /// Sets the handler for lines rejected by the server, the remaining lines are written
+  void setRejectedLinesHandler(RejectedLinesHandler handler) override;
+
+  /// Sets the timeout for establishing connections
+  void setConnectTimeout(std::chrono::milliseconds timeout);
+
+  /// Sets the deadline of write requests
+  void setWriteTimeout(std::chrono::milliseconds timeout);
+
+  /// Sets the deadline of queries
+  void setQueryTimeout(std::chrono::milliseconds timeout);
+
+  /// Requests timestamps of query results as epoch nanoseconds (epoch=ns) instead of RFC3339 strings
+  void enableEpochTimestamps();
+
+  /// Requests query responses in the format (Accept header), JSON by default;
+  /// CSV and MessagePack responses are smaller and cheaper to decode
+  void setQueryFormat(QueryFormat format);
+
+  /// Enables hedged writes: a write not completed within the p95 write latency (or failed)
+  /// is duplicated to the second endpoint, the slower request is cancelled. Both requests may succeed,
+  /// so only writes whose lines all carry a timestamp are hedged; a server would assign its own time
+  /// to the others and store them twice
+  /// \param url url of the second endpoint
+  /// \throw InfluxDBException	if already enabled or CURL fails to initialize
+  void enableHedgedWrites(const std::string &url);
+
   /// Enable Basic Auth
   /// \param auth <username>:<password>
   void enableBasicAuth(const std::string &auth);
@@ -79,26 +139,121 @@ private:
   /// \throw InfluxDBException	if database (?db=) not specified
   void initCurl(const std::string &url);
 
+  /// Builds the write url from the url passed
+  static std::string writeUrlOf(const std::string &url);
+
   /// Initializes CURL for reading
   void initCurlRead(const std::string &url);
 
+  /// Read handle used by one query, returned to the pool on destruction
+  class ReadHandleLease;
+
+  /// Takes an idle read handle of the pool, a new one is created if all are in use
+  CURL *acquireReadHandle();
+
+  /// Returns the read handle to the pool
+  void releaseReadHandle(CURL *handle);
+
+  /// Frees the replaced query headers once no read handle is leased, mReadHandlesMutex must be held
+  void freeRetiredQueryHeaders();
+
+  /// Applies the timeouts, credentials and headers of queries to the read handle, mReadHandlesMutex must be held
+  void applyReadSettings(CURL *handle) const;
+
+  /// Applies a changed setting to the idle read handles, leased ones get all settings once released;
+  /// mReadHandlesMutex must be held
+  void updateReadHandles(const std::function<void(CURL *)> &apply);
+
+  /// Queries using chunked responses, aborted once isCancelled returns true if not nullptr
+  void runChunkedQuery(const std::string &query, const std::function<void(std::string_view)> &onChunk,
+                       const std::function<bool()> *isCancelled);
+
+  /// Builds the query url including the encoded query
+  std::string queryUrl(CURL *handle, const std::string &query, const std::string &parameters);
+
+  /// POSTs the buffers, the response body is stored if responseBody is not nullptr
+  CURLcode postBuffers(const std::vector<std::string_view> &buffers, std::string *responseBody, long &responseCode);
+
+  /// Sends the buffers to the write and hedge endpoint, the first definitive response is used
+  void sendHedged(const std::vector<std::string_view> &buffers);
+
+  /// Delay after which a write is hedged
+  std::chrono::microseconds hedgeDelay() const;
+
+  /// Adds the latency of a completed write to the latency window
+  void recordWriteLatency(std::chrono::microseconds latency);
+
+  /// Sends the buffers, lines rejected by the server are passed to the rejected lines handler
+  void sendResolvingRejectedLines(const std::vector<std::string_view> &buffers);
+
+  /// Finds the lines rejected by a bad request response, bisecting the timestamped lines if they are not named
+  void resolveRejectedLines(const std::vector<std::string_view> &lines, const std::string &responseBody);
+
+  /// Sends the lines again, resolving the rejected ones if the request fails
+  void resendRejectedLines(const std::vector<std::string_view> &lines);
+
   /// treats responses of CURL requests
   void treatCurlResponse(const CURLcode &response, long responseCode) const;
 
   /// CURL pointer configured for writing points
   CURL *writeHandle;
 
-  /// CURL pointer configured for querying
+  /// CURL pointer configured for querying, first handle of the read pool
   CURL *readHandle;
 
+  /// All read handles, including readHandle
+  std::vector<CURL *> mReadHandles;
+
+  /// Read handles not used by a running query
+  std::vector<CURL *> mIdleReadHandles;
+
+  /// Leased read handles whose settings changed while they were leased
+  std::vector<CURL *> mStaleReadHandles;
+
+  /// Guards the read handle pool and the settings of queries
+  std::mutex mReadHandlesMutex;
+
+  /// CURL pointer configured for writing to the hedge endpoint, nullptr if hedging is disabled
+  CURL *hedgeHandle;
+
+  /// CURL multi handle running hedged writes
+  CURLM *multiHandle;
+
   /// InfluxDB read URL
   std::string mReadUrl;
 
+  /// Number of rows per chunk requested for chunked queries
+  std::size_t mChunkSize;
+
+  /// Additional parameters of query urls, each terminated by '&'
+  std::string mQueryParameters;
+
+  /// Headers of queries, nullptr if not set
+  curl_slist *mQueryHeaders;
+
+  /// Replaced headers of queries, still referred to by leased read handles; guarded by mReadHandlesMutex
+  std::vector<curl_slist *> mRetiredQueryHeaders;
+
   /// InfluxDB service URL
   std::string mInfluxDbServiceUrl;
 
   /// Database name used
   std::string mDatabaseName;
+
+  /// Handler for lines rejected by the server, if not set bad requests throw
+  RejectedLinesHandler mRejectedLinesHandler;
+
+  /// Timeouts applied to the hedge endpoint and read handles; the connect and query timeouts are guarded by mReadHandlesMutex
+  std::chrono::milliseconds mConnectTimeout;
+  std::chrono::milliseconds mWriteTimeout;
+  std::chrono::milliseconds mQueryTimeout;
+
+  /// Basic Auth credentials applied to the hedge endpoint and read handles; guarded by mReadHandlesMutex
+  std::string mAuth;
+
+  /// Latencies of recent writes, used as ring buffer
+  std::vector<std::chrono::microseconds> mWriteLatencies;
+  std::size_t mNextLatency;
 };
 
 } // namespace influxdb
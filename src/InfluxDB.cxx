@@ -27,7 +27,9 @@
 #include "InfluxDB.h"
 #include "InfluxDBException.h"
 #include "LineProtocol.h"
-#include "BoostSupport.h"
+#include "Query.h"
+#include "QueryCache.h"
+#include "SchemaCache.h"
 #include <iostream>
 #include <memory>
 #include <string>
@@ -35,11 +37,20 @@
 namespace influxdb
 {
 
+namespace
+{
+  const internal::ColumnSchemaLookup* schemaLookupOf(const std::unique_ptr<internal::SchemaCache>& schema)
+  {
+    return schema != nullptr ? &schema->lookup() : nullptr;
+  }
+}
+
 InfluxDB::InfluxDB(std::unique_ptr<Transport> transport) :
   mLineProtocolBatch{},
   mIsBatchingActivated{false},
   mBatchSize{0},
   mTransport(std::move(transport)),
+  mUncachedTransport(mTransport.get()),
   mGlobalTags{}
 {
   if (mTransport == nullptr)
@@ -58,21 +69,30 @@ void InfluxDB::flushBatch()
 {
   if (mIsBatchingActivated && !mLineProtocolBatch.empty())
   {
-    transmit(joinLineProtocolBatch());
+    mTransport->sendBuffers(lineProtocolBatchBuffers());
     mLineProtocolBatch.clear();
   }
 }
 
-std::string InfluxDB::joinLineProtocolBatch() const
+void InfluxDB::flushTransport()
+{
+  flushBatch();
+  mTransport->flush();
+}
+
+std::vector<std::string_view> InfluxDB::lineProtocolBatchBuffers() const
 {
-  std::string joinedBatch;
+  static constexpr std::string_view separator{"\n"};
+  std::vector<std::string_view> buffers;
+  buffers.reserve(mLineProtocolBatch.size() * 2);
   for (const auto &line : mLineProtocolBatch)
   {
-    joinedBatch += line + "\n";
+    buffers.emplace_back(line);
+    buffers.emplace_back(separator);
   }
 
-  joinedBatch.erase(std::prev(joinedBatch.cend()));
-  return joinedBatch;
+  buffers.pop_back();
+  return buffers;
 }
 
 
@@ -92,8 +112,15 @@ void InfluxDB::transmit(std::string &&point)
   mTransport->send(std::move(point));
 }
 
+InfluxDB::~InfluxDB() = default;
+
 void InfluxDB::write(Point &&point)
 {
+  if (mSchemaCache != nullptr)
+  {
+    mSchemaCache->check(point);
+  }
+
   if (mIsBatchingActivated)
   {
     addPointToBatch(point);
@@ -107,6 +134,11 @@ void InfluxDB::write(Point &&point)
 
 void InfluxDB::write(std::vector<Point> &&points)
 {
+  if (mSchemaCache != nullptr)
+  {
+    mSchemaCache->check(points);
+  }
+
   if (mIsBatchingActivated)
   {
     for (const auto &point : points)
@@ -129,6 +161,43 @@ void InfluxDB::write(std::vector<Point> &&points)
   }
 }
 
+void InfluxDB::writeStream(const std::function<std::optional<Point>()>& nextPoint)
+{
+  LineProtocol formatter{mGlobalTags};
+  std::string line;
+  std::size_t offset{0};
+  bool first{true};
+  bool finished{false};
+
+  mTransport->sendStream([&](char* buffer, std::size_t size) {
+    std::size_t written{0};
+    while (written < size && !finished)
+    {
+      if (offset == line.size())
+      {
+        auto point = nextPoint();
+        if (!point)
+        {
+          finished = true;
+          break;
+        }
+        if (mSchemaCache != nullptr)
+        {
+          mSchemaCache->check(*point);
+        }
+        line = (first ? "" : "\n") + formatter.format(*point);
+        offset = 0;
+        first = false;
+      }
+
+      const auto count = line.copy(buffer + written, size - written, offset);
+      offset += count;
+      written += count;
+    }
+    return written;
+  });
+}
+
 void InfluxDB::addPointToBatch(const Point &point)
 {
   LineProtocol formatter{mGlobalTags};
@@ -140,9 +209,79 @@ void InfluxDB::addPointToBatch(const Point &point)
   }
 }
 
+void InfluxDB::setRejectedLinesHandler(RejectedLinesHandler handler)
+{
+  mTransport->setRejectedLinesHandler(std::move(handler));
+}
+
+TransportStatistics InfluxDB::transportStatistics() const
+{
+  return mTransport->sendStatistics();
+}
+
 std::vector<Point> InfluxDB::query(const std::string &query)
 {
-    return internal::queryImpl(mTransport.get(), query);
+    return internal::queryImpl(mTransport.get(), query, nullptr, schemaLookupOf(mSchemaCache));
+}
+
+std::vector<StatementPoints> InfluxDB::queryStatements(const std::string& query)
+{
+    return internal::queryStatementsImpl(mTransport.get(), query, nullptr, schemaLookupOf(mSchemaCache));
+}
+
+QueryResult InfluxDB::execute(const std::string& query)
+{
+    return internal::queryResultImpl(mTransport.get(), query, nullptr, schemaLookupOf(mSchemaCache));
+}
+
+std::future<std::vector<Point>> InfluxDB::queryAsync(const std::string& query, CancellationToken cancellation)
+{
+    return std::async(std::launch::async, [this, query, cancellation] {
+        return internal::queryImpl(mTransport.get(), query, &cancellation, schemaLookupOf(mSchemaCache));
+    });
+}
+
+std::future<QueryResult> InfluxDB::executeAsync(const std::string& query, CancellationToken cancellation)
+{
+    return std::async(std::launch::async, [this, query, cancellation] {
+        return internal::queryResultImpl(mTransport.get(), query, &cancellation, schemaLookupOf(mSchemaCache));
+    });
+}
+
+std::vector<Point> InfluxDB::querySplit(const std::string& query, std::chrono::system_clock::time_point from,
+                                        std::chrono::system_clock::time_point to, std::size_t windows, std::size_t maxConcurrency)
+{
+    std::vector<Point> points;
+    querySplit(query, from, to, windows, [&points](Point&& point) { points.push_back(std::move(point)); }, maxConcurrency);
+    return points;
+}
+
+void InfluxDB::querySplit(const std::string& query, std::chrono::system_clock::time_point from,
+                          std::chrono::system_clock::time_point to, std::size_t windows, const std::function<void(Point&&)>& onPoint,
+                          std::size_t maxConcurrency)
+{
+    internal::querySplitImpl(mTransport.get(), internal::splitTimeRange(query, from, to, windows), onPoint, schemaLookupOf(mSchemaCache),
+                             maxConcurrency);
+}
+
+void InfluxDB::queryStream(const std::string& query, const std::function<void(const QueryRow&)>& onRow)
+{
+    internal::queryStreamImpl(mTransport.get(), query, onRow, nullptr, schemaLookupOf(mSchemaCache));
+}
+
+void InfluxDB::enableQueryCache(std::chrono::milliseconds ttl, std::size_t maxBytes)
+{
+    if (mTransport.get() != mUncachedTransport)
+    {
+        throw InfluxDBException{__func__, "Query cache is already enabled"};
+    }
+    mTransport = std::make_unique<internal::QueryCache>(std::move(mTransport), ttl, maxBytes);
+}
+
+void InfluxDB::enableSchemaCache(std::chrono::milliseconds refreshInterval)
+{
+    // Schema queries bypass the query cache, reloads would return the cached response otherwise
+    mSchemaCache = std::make_unique<internal::SchemaCache>(*mUncachedTransport, refreshInterval);
 }
 
 void InfluxDB::createDatabaseIfNotExists()
@@ -25,12 +25,20 @@
 ///
 
 #include "InfluxDBFactory.h"
+#include <algorithm>
+#include <chrono>
 #include <functional>
+#include <optional>
 #include <string>
 #include <memory>
 #include <map>
 #include "UriParser.h"
+#include "UrlOptions.h"
 #include "HTTP.h"
+#include "SharedMemory.h"
+#include "FileSink.h"
+#include "Tee.h"
+#include "TransportDecorators.h"
 #include "InfluxDBException.h"
 #include "BoostSupport.h"
 
@@ -38,9 +46,66 @@ namespace influxdb
 {
     namespace internal
     {
+        /// Replaces the host (and port) of the url
+        std::string withHost(const std::string& url, const std::string& host)
+        {
+            auto begin = url.find("://") + 3;
+            const auto end = std::min(url.find_first_of("/?", begin), url.size());
+            if (const auto userinfo = url.find('@', begin); userinfo < end)
+            {
+                begin = userinfo + 1;
+            }
+            return url.substr(0, begin) + host + url.substr(end);
+        }
+
         std::unique_ptr<Transport> withHttpTransport(const http::url& uri)
         {
-            auto transport = std::make_unique<transports::HTTP>(uri.url);
+            auto options = uri;
+            const auto connectTimeout = takeDurationOption(options, "connect_timeout_ms");
+            const auto writeTimeout = takeDurationOption(options, "write_timeout_ms");
+            const auto queryTimeout = takeDurationOption(options, "query_timeout_ms");
+            const auto hedgeHost = takeUrlOption(options, "hedge");
+            const auto epoch = takeUrlOption(options, "epoch");
+            if (epoch && *epoch != "ns")
+            {
+                throw InfluxDBException{__func__, "Unsupported epoch precision: " + *epoch};
+            }
+            const auto format = takeUrlOption(options, "format");
+            static const std::map<std::string, transports::HTTP::QueryFormat> formats = {
+                {"json", transports::HTTP::QueryFormat::Json},
+                {"csv", transports::HTTP::QueryFormat::Csv},
+                {"msgpack", transports::HTTP::QueryFormat::MessagePack},
+            };
+            if (format && formats.count(*format) == 0)
+            {
+                throw InfluxDBException{__func__, "Unsupported query format: " + *format};
+            }
+
+            auto transport = std::make_unique<transports::HTTP>(options.url);
+            if (hedgeHost)
+            {
+                transport->enableHedgedWrites(withHost(options.url, *hedgeHost));
+            }
+            if (epoch)
+            {
+                transport->enableEpochTimestamps();
+            }
+            if (format)
+            {
+                transport->setQueryFormat(formats.at(*format));
+            }
+            if (connectTimeout)
+            {
+                transport->setConnectTimeout(*connectTimeout);
+            }
+            if (writeTimeout)
+            {
+                transport->setWriteTimeout(*writeTimeout);
+            }
+            if (queryTimeout)
+            {
+                transport->setQueryTimeout(*queryTimeout);
+            }
             if (!uri.user.empty())
             {
                 transport->enableBasicAuth(uri.user + ":" + uri.password);
@@ -48,6 +113,151 @@ namespace influxdb
             return transport;
         }
 
+        std::unique_ptr<Transport> withSharedMemoryTransport(const http::url& uri)
+        {
+            auto options = uri;
+            const auto capacity = takeSizeOption(options, "size").value_or(transports::SharedMemory::defaultCapacity);
+            const auto singleProducer = takeBoolOption(options, "single_producer").value_or(false);
+            if (options.host.empty())
+            {
+                throw InfluxDBException{__func__, "Missing name of the shared memory segment"};
+            }
+            return std::make_unique<transports::SharedMemory>(options.host, capacity, singleProducer);
+        }
+
+        std::unique_ptr<Transport> withFileTransport(const http::url& uri)
+        {
+            auto options = uri;
+            const auto bufferSize = takeSizeOption(options, "buffer_size").value_or(transports::FileSink::defaultBufferSize);
+            const auto maxFileSize = takeSizeOption(options, "max_file_size");
+            const auto rotateInterval = takeDurationOption(options, "rotate_interval_ms");
+            const auto compress = takeBoolOption(options, "gzip").value_or(false);
+            const auto sync = takeUrlOption(options, "fsync");
+            static const std::map<std::string, transports::FileSink::Sync> syncModes = {
+                {"none", transports::FileSink::Sync::None},
+                {"rotate", transports::FileSink::Sync::Rotate},
+                {"flush", transports::FileSink::Sync::Flush},
+                {"write", transports::FileSink::Sync::Write},
+            };
+            if (sync && syncModes.count(*sync) == 0)
+            {
+                throw InfluxDBException{__func__, "Invalid value of fsync: " + *sync};
+            }
+            if (bufferSize == 0)
+            {
+                throw InfluxDBException{__func__, "Invalid value of buffer_size: 0"};
+            }
+            // file:///absolute/path has an empty host, file://relative/path does not
+            const auto path = options.host + options.path;
+            if (path.empty())
+            {
+                throw InfluxDBException{__func__, "Missing path of the file"};
+            }
+
+            auto transport = std::make_unique<transports::FileSink>(path, bufferSize);
+            if (maxFileSize)
+            {
+                transport->setMaxFileSize(*maxFileSize);
+            }
+            if (rotateInterval)
+            {
+                transport->setRotateInterval(*rotateInterval);
+            }
+            if (compress)
+            {
+                transport->enableCompression();
+            }
+            if (sync)
+            {
+                transport->setSync(syncModes.at(*sync));
+            }
+            return transport;
+        }
+
+
+        /// Capabilities added to a transport by decorators, taken from the url before the transport is created
+        struct DecoratorOptions
+        {
+            std::optional<std::size_t> maxRetries;
+            std::chrono::milliseconds retryBackoff{100};
+            bool metrics{false};
+            std::optional<std::size_t> rateLimit;
+            std::optional<std::size_t> maxMessageSize;
+            std::optional<std::string> spoolPath;
+            std::size_t spoolMaxBytes{transports::Spool::defaultMaxBytes};
+            std::chrono::milliseconds spoolRetryInterval{transports::Spool::defaultRetryInterval};
+            std::optional<int> compressionLevel;
+        };
+
+        DecoratorOptions takeDecoratorOptions(http::url& options)
+        {
+            DecoratorOptions decorators;
+            decorators.maxRetries = takeSizeOption(options, "retry");
+            decorators.retryBackoff = takeDurationOption(options, "retry_backoff_ms").value_or(decorators.retryBackoff);
+            decorators.metrics = takeBoolOption(options, "metrics").value_or(false);
+            decorators.rateLimit = takeSizeOption(options, "rate_limit");
+            decorators.maxMessageSize = takeSizeOption(options, "max_message_size");
+            decorators.spoolPath = takeUrlOption(options, "spool");
+            decorators.spoolMaxBytes = takeSizeOption(options, "spool_max_bytes").value_or(decorators.spoolMaxBytes);
+            decorators.spoolRetryInterval = takeDurationOption(options, "spool_retry_ms").value_or(decorators.spoolRetryInterval);
+
+            const auto compression = takeUrlOption(options, "compression");
+            const auto compressionLevel = takeSizeOption(options, "compression_level");
+            if (compression && *compression != "gzip")
+            {
+                throw InfluxDBException{__func__, "Unsupported compression: " + *compression};
+            }
+            if (compressionLevel && (*compressionLevel < 1 || *compressionLevel > 9))
+            {
+                throw InfluxDBException{__func__, "Invalid value of compression_level: " + std::to_string(*compressionLevel)};
+            }
+            if (compressionLevel && !compression)
+            {
+                throw InfluxDBException{__func__, "compression_level requires compression"};
+            }
+            // Only the HTTP transport sends the encoded body with its Content-Encoding
+            if (compression && options.protocol != "http" && options.protocol != "https")
+            {
+                throw InfluxDBException{__func__, "Compression is not supported by the " + options.protocol + " transport"};
+            }
+            if (compression)
+            {
+                decorators.compressionLevel = static_cast<int>(compressionLevel.value_or(1));
+            }
+            return decorators;
+        }
+
+        /// Stacks the configured decorators onto the transport, the outermost sees the messages as written:
+        /// metrics, rate limit, spool, splitter, retry, compression
+        std::unique_ptr<Transport> withDecorators(std::unique_ptr<Transport> transport, const DecoratorOptions& decorators)
+        {
+            if (decorators.compressionLevel)
+            {
+                transport = std::make_unique<transports::Compression>(std::move(transport), *decorators.compressionLevel);
+            }
+            if (decorators.maxRetries)
+            {
+                transport = std::make_unique<transports::Retry>(std::move(transport), *decorators.maxRetries, decorators.retryBackoff);
+            }
+            if (decorators.maxMessageSize)
+            {
+                transport = std::make_unique<transports::Splitter>(std::move(transport), *decorators.maxMessageSize);
+            }
+            if (decorators.spoolPath)
+            {
+                transport = std::make_unique<transports::Spool>(std::move(transport), *decorators.spoolPath, decorators.spoolMaxBytes,
+                                                                decorators.spoolRetryInterval);
+            }
+            if (decorators.rateLimit)
+            {
+                transport = std::make_unique<transports::RateLimit>(std::move(transport), *decorators.rateLimit);
+            }
+            if (decorators.metrics)
+            {
+                transport = std::make_unique<transports::Metrics>(std::move(transport));
+            }
+            return transport;
+        }
     }
 
     std::unique_ptr<Transport> InfluxDBFactory::GetTransport(const std::string& url)
@@ -57,6 +267,9 @@ namespace influxdb
             {"http", internal::withHttpTransport},
             {"https", internal::withHttpTransport},
             {"unix", internal::withUnixSocketTransport},
+            {"tcp", internal::withTcpTransport},
+            {"shm", internal::withSharedMemoryTransport},
+            {"file", internal::withFileTransport},
         };
 
         auto urlCopy = url;
@@ -72,7 +285,8 @@ namespace influxdb
             throw InfluxDBException(__func__, "Unrecognized backend " + parsedUrl.protocol);
         }
 
-        return iterator->second(parsedUrl);
+        const auto decorators = internal::takeDecoratorOptions(parsedUrl);
+        return internal::withDecorators(iterator->second(parsedUrl), decorators);
     }
 
     std::unique_ptr<InfluxDB> InfluxDBFactory::Get(const std::string& url)
@@ -80,4 +294,29 @@ namespace influxdb
         return std::make_unique<InfluxDB>(InfluxDBFactory::GetTransport(url));
     }
 
+    std::unique_ptr<InfluxDB> InfluxDBFactory::GetTee(const std::vector<std::string>& urls)
+    {
+        if (urls.empty())
+        {
+            throw InfluxDBException(__func__, "No transport URLs");
+        }
+
+        auto tee = std::make_unique<transports::Tee>();
+        for (const auto& url : urls)
+        {
+            auto urlCopy = url;
+            http::url options = http::ParseHttpUrl(urlCopy);
+            transports::Tee::ChildOptions childOptions;
+            childOptions.queueSize = internal::takeSizeOption(options, "tee_queue_size").value_or(childOptions.queueSize);
+            childOptions.maxRetries = internal::takeSizeOption(options, "tee_max_retries").value_or(childOptions.maxRetries);
+            childOptions.retryBackoff = internal::takeDurationOption(options, "tee_retry_backoff_ms").value_or(childOptions.retryBackoff);
+            if (childOptions.queueSize == 0)
+            {
+                throw InfluxDBException(__func__, "Invalid value of tee_queue_size: 0");
+            }
+            tee->add(InfluxDBFactory::GetTransport(options.url), childOptions);
+        }
+        return std::make_unique<InfluxDB>(std::move(tee));
+    }
+
 } // namespace influxdb
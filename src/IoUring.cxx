@@ -0,0 +1,324 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "IoUring.h"
+#include "InfluxDBException.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#ifdef INFLUXCXX_WITH_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace influxdb::internal
+{
+#ifdef INFLUXCXX_WITH_IO_URING
+
+    namespace
+    {
+        std::string systemError(const std::string& what, int error)
+        {
+            return what + ": " + std::strerror(error);
+        }
+
+        int setup(unsigned entries, io_uring_params& params)
+        {
+            return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        }
+
+        int enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+        {
+            return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+        }
+
+        int registerBuffers(int fd, const iovec* buffers, unsigned count)
+        {
+            return static_cast<int>(::syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, buffers, count));
+        }
+
+        template <class T>
+        T* at(void* ring, std::uint32_t offset)
+        {
+            return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+        }
+
+        /// Ring indices are shared with the kernel, which reads the submission tail and writes the completion tail
+        unsigned loadAcquire(const unsigned* index)
+        {
+            return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+        }
+
+        void storeRelease(unsigned* index, unsigned value)
+        {
+            __atomic_store_n(index, value, __ATOMIC_RELEASE);
+        }
+    }
+
+    /// Mappings of the submission and completion queues shared with the kernel
+    struct IoUring::Ring
+    {
+        int fd{-1};
+        void* sqRing{MAP_FAILED};
+        std::size_t sqRingSize{0};
+        void* cqRing{MAP_FAILED};
+        std::size_t cqRingSize{0};
+        io_uring_sqe* sqes{static_cast<io_uring_sqe*>(MAP_FAILED)};
+        std::size_t sqesSize{0};
+
+        unsigned* sqTail{nullptr};
+        unsigned sqMask{0};
+        unsigned* sqArray{nullptr};
+        unsigned* cqHead{nullptr};
+        unsigned* cqTail{nullptr};
+        unsigned cqMask{0};
+        io_uring_cqe* cqes{nullptr};
+        unsigned entries{0};
+
+        /// Writes queued but not submitted yet
+        unsigned queued{0};
+
+        std::unique_ptr<char[]> buffer;
+        std::size_t bufferSize{0};
+
+        ~Ring()
+        {
+            if (sqes != MAP_FAILED)
+            {
+                ::munmap(sqes, sqesSize);
+            }
+            if (cqRing != MAP_FAILED && cqRing != sqRing)
+            {
+                ::munmap(cqRing, cqRingSize);
+            }
+            if (sqRing != MAP_FAILED)
+            {
+                ::munmap(sqRing, sqRingSize);
+            }
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    };
+
+    IoUring::IoUring(unsigned entries, std::size_t bufferSize)
+        : mRing(std::make_unique<Ring>())
+    {
+        io_uring_params params{};
+        mRing->fd = setup(entries, params);
+        if (mRing->fd < 0)
+        {
+            throw InfluxDBException(__func__, systemError("Cannot set up io_uring", errno));
+        }
+
+        mRing->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        mRing->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMapping)
+        {
+            mRing->sqRingSize = std::max(mRing->sqRingSize, mRing->cqRingSize);
+        }
+
+        mRing->sqRing = ::mmap(nullptr, mRing->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing->fd, IORING_OFF_SQ_RING);
+        if (mRing->sqRing == MAP_FAILED)
+        {
+            throw InfluxDBException(__func__, systemError("Cannot map io_uring submission queue", errno));
+        }
+        if (singleMapping)
+        {
+            mRing->cqRing = mRing->sqRing;
+        }
+        else
+        {
+            mRing->cqRing = ::mmap(nullptr, mRing->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing->fd, IORING_OFF_CQ_RING);
+            if (mRing->cqRing == MAP_FAILED)
+            {
+                throw InfluxDBException(__func__, systemError("Cannot map io_uring completion queue", errno));
+            }
+        }
+        mRing->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        mRing->sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, mRing->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing->fd, IORING_OFF_SQES));
+        if (mRing->sqes == MAP_FAILED)
+        {
+            throw InfluxDBException(__func__, systemError("Cannot map io_uring submission entries", errno));
+        }
+
+        mRing->sqTail = at<unsigned>(mRing->sqRing, params.sq_off.tail);
+        mRing->sqMask = *at<unsigned>(mRing->sqRing, params.sq_off.ring_mask);
+        mRing->sqArray = at<unsigned>(mRing->sqRing, params.sq_off.array);
+        mRing->cqHead = at<unsigned>(mRing->cqRing, params.cq_off.head);
+        mRing->cqTail = at<unsigned>(mRing->cqRing, params.cq_off.tail);
+        mRing->cqMask = *at<unsigned>(mRing->cqRing, params.cq_off.ring_mask);
+        mRing->cqes = at<io_uring_cqe>(mRing->cqRing, params.cq_off.cqes);
+        mRing->entries = params.sq_entries;
+
+        // The kernel pins the pages of a registered buffer once instead of mapping them on every write
+        mRing->buffer = std::make_unique<char[]>(bufferSize);
+        mRing->bufferSize = bufferSize;
+        const iovec registered{mRing->buffer.get(), bufferSize};
+        if (registerBuffers(mRing->fd, &registered, 1) != 0)
+        {
+            throw InfluxDBException(__func__, systemError("Cannot register io_uring buffer", errno));
+        }
+    }
+
+    IoUring::~IoUring() = default;
+
+    bool IoUring::available()
+    {
+        static const bool supported = []
+        {
+            io_uring_params params{};
+            const int fd = setup(1, params);
+            if (fd < 0)
+            {
+                return false;
+            }
+            ::close(fd);
+            return true;
+        }();
+        return supported;
+    }
+
+    char* IoUring::buffer() const
+    {
+        return mRing->buffer.get();
+    }
+
+    std::size_t IoUring::bufferSize() const
+    {
+        return mRing->bufferSize;
+    }
+
+    unsigned IoUring::entries() const
+    {
+        return mRing->entries;
+    }
+
+    bool IoUring::write(int fd, const char* data, std::size_t size, std::uint64_t tag)
+    {
+        if (mRing->queued == mRing->entries)
+        {
+            return false;
+        }
+        const unsigned tail = *mRing->sqTail + mRing->queued;
+        const unsigned index = tail & mRing->sqMask;
+        io_uring_sqe& entry = mRing->sqes[index];
+        std::memset(&entry, 0, sizeof(entry));
+        entry.opcode = IORING_OP_WRITE_FIXED;
+        entry.fd = fd;
+        entry.addr = reinterpret_cast<std::uint64_t>(data);
+        entry.len = static_cast<std::uint32_t>(size);
+        entry.buf_index = 0;
+        entry.user_data = tag;
+        mRing->sqArray[index] = index;
+        ++mRing->queued;
+        return true;
+    }
+
+    void IoUring::submit(const std::function<void(std::uint64_t tag, int result)>& onCompletion)
+    {
+        const unsigned count = mRing->queued;
+        if (count == 0)
+        {
+            return;
+        }
+        storeRelease(mRing->sqTail, *mRing->sqTail + count);
+        mRing->queued = 0;
+
+        unsigned submitted{0};
+        unsigned completed{0};
+        while (completed < count)
+        {
+            const int result = enter(mRing->fd, count - submitted, count - completed, IORING_ENTER_GETEVENTS);
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw InfluxDBException(__func__, systemError("Cannot submit to io_uring", errno));
+            }
+            submitted += static_cast<unsigned>(result);
+
+            unsigned head = *mRing->cqHead;
+            const unsigned tail = loadAcquire(mRing->cqTail);
+            for (; head != tail; ++head, ++completed)
+            {
+                const io_uring_cqe& completion = mRing->cqes[head & mRing->cqMask];
+                onCompletion(completion.user_data, completion.res);
+            }
+            storeRelease(mRing->cqHead, head);
+        }
+    }
+
+#else
+
+    struct IoUring::Ring
+    {
+    };
+
+    IoUring::IoUring([[maybe_unused]] unsigned entries, [[maybe_unused]] std::size_t bufferSize)
+    {
+        throw InfluxDBException(__func__, "io_uring is not supported by this build");
+    }
+
+    IoUring::~IoUring() = default;
+
+    bool IoUring::available()
+    {
+        return false;
+    }
+
+    char* IoUring::buffer() const
+    {
+        return nullptr;
+    }
+
+    std::size_t IoUring::bufferSize() const
+    {
+        return 0;
+    }
+
+    unsigned IoUring::entries() const
+    {
+        return 0;
+    }
+
+    bool IoUring::write([[maybe_unused]] int fd, [[maybe_unused]] const char* data, [[maybe_unused]] std::size_t size, [[maybe_unused]] std::uint64_t tag)
+    {
+        return false;
+    }
+
+    void IoUring::submit([[maybe_unused]] const std::function<void(std::uint64_t tag, int result)>& onCompletion)
+    {
+    }
+
+#endif
+}
@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace influxdb::internal
+{
+    /// \brief Minimal io_uring instance submitting writes of a registered buffer, without liburing;
+    /// all writes queued are submitted by a single io_uring_enter system call
+    class IoUring
+    {
+    public:
+        /// Sets up a ring and registers a buffer of the given size
+        /// \param entries 	maximum number of writes per submission
+        /// \throw InfluxDBException 	if io_uring is not supported by the kernel or build
+        IoUring(unsigned entries, std::size_t bufferSize);
+
+        ~IoUring();
+
+        IoUring(const IoUring&) = delete;
+        IoUring& operator=(const IoUring&) = delete;
+
+        /// Checks whether io_uring can be used, i.e. is supported by the build and the kernel
+        static bool available();
+
+        /// Registered buffer, data written must be located within
+        char* buffer() const;
+
+        std::size_t bufferSize() const;
+
+        /// Maximum number of writes queued
+        unsigned entries() const;
+
+        /// Queues a write of data within the registered buffer to the file descriptor
+        /// \return false if the submission queue is full
+        bool write(int fd, const char* data, std::size_t size, std::uint64_t tag);
+
+        /// Submits the queued writes and waits until all completed
+        /// \param onCompletion 	called with the tag and result (bytes written or -errno) of each write
+        /// \throw InfluxDBException 	if submitting fails
+        void submit(const std::function<void(std::uint64_t tag, int result)>& onCompletion);
+
+    private:
+        struct Ring;
+        std::unique_ptr<Ring> mRing;
+    };
+}
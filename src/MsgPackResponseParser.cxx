@@ -0,0 +1,613 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "MsgPackResponseParser.h"
+#include "InfluxDBException.h"
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+
+namespace influxdb::internal
+{
+    namespace
+    {
+        constexpr std::size_t maxNestingDepth{64};
+
+        enum class Kind
+        {
+            Nil,
+            Bool,
+            UnsignedInt,
+            SignedInt,
+            Float,
+            String,
+            Binary,
+            Extension,
+            Array,
+            Map
+        };
+
+        struct Header
+        {
+            Kind kind;
+
+            /// Size of the header, including the type of extensions
+            std::size_t size;
+
+            /// Elements of arrays, entries of maps, bytes of strings, binaries and extensions;
+            /// the bits of the value for all other kinds
+            std::uint64_t value;
+        };
+
+        std::uint64_t bigEndian(std::string_view data, std::size_t offset, std::size_t bytes)
+        {
+            std::uint64_t value{0};
+            for (std::size_t i = 0; i < bytes; ++i)
+            {
+                value = (value << 8) | static_cast<unsigned char>(data[offset + i]);
+            }
+            return value;
+        }
+
+        template <class Signed>
+        std::uint64_t signExtended(std::uint64_t value)
+        {
+            return static_cast<std::uint64_t>(static_cast<std::int64_t>(static_cast<Signed>(value)));
+        }
+
+        /// Reads the header of the element at the offset, nullopt if the data ends within the header
+        /// \throw InfluxDBException	if the type is invalid
+        std::optional<Header> headerAt(std::string_view data, std::size_t offset)
+        {
+            if (offset >= data.size())
+            {
+                return std::nullopt;
+            }
+
+            const auto type = static_cast<unsigned char>(data[offset]);
+            if (type <= 0x7f)
+            {
+                return Header{Kind::UnsignedInt, 1, type};
+            }
+            if (type <= 0x8f)
+            {
+                return Header{Kind::Map, 1, type & 0x0fu};
+            }
+            if (type <= 0x9f)
+            {
+                return Header{Kind::Array, 1, type & 0x0fu};
+            }
+            if (type <= 0xbf)
+            {
+                return Header{Kind::String, 1, type & 0x1fu};
+            }
+            if (type >= 0xe0)
+            {
+                return Header{Kind::SignedInt, 1, signExtended<std::int8_t>(type)};
+            }
+
+            const auto sized = [&](Kind kind, std::size_t bytes) -> std::optional<Header> {
+                if (data.size() - offset < 1 + bytes)
+                {
+                    return std::nullopt;
+                }
+                return Header{kind, 1 + bytes, bigEndian(data, offset + 1, bytes)};
+            };
+            const auto extension = [&](std::size_t lengthBytes, std::optional<std::uint64_t> length) -> std::optional<Header> {
+                const auto size = 2 + lengthBytes;
+                if (data.size() - offset < size)
+                {
+                    return std::nullopt;
+                }
+                return Header{Kind::Extension, size, length ? *length : bigEndian(data, offset + 1, lengthBytes)};
+            };
+
+            switch (type)
+            {
+                case 0xc0:
+                    return Header{Kind::Nil, 1, 0};
+                case 0xc2:
+                    return Header{Kind::Bool, 1, 0};
+                case 0xc3:
+                    return Header{Kind::Bool, 1, 1};
+                case 0xc4:
+                    return sized(Kind::Binary, 1);
+                case 0xc5:
+                    return sized(Kind::Binary, 2);
+                case 0xc6:
+                    return sized(Kind::Binary, 4);
+                case 0xc7:
+                    return extension(1, std::nullopt);
+                case 0xc8:
+                    return extension(2, std::nullopt);
+                case 0xc9:
+                    return extension(4, std::nullopt);
+                case 0xca:
+                    return sized(Kind::Float, 4);
+                case 0xcb:
+                    return sized(Kind::Float, 8);
+                case 0xcc:
+                    return sized(Kind::UnsignedInt, 1);
+                case 0xcd:
+                    return sized(Kind::UnsignedInt, 2);
+                case 0xce:
+                    return sized(Kind::UnsignedInt, 4);
+                case 0xcf:
+                    return sized(Kind::UnsignedInt, 8);
+                case 0xd0:
+                {
+                    auto header = sized(Kind::SignedInt, 1);
+                    return header ? Header{header->kind, header->size, signExtended<std::int8_t>(header->value)} : header;
+                }
+                case 0xd1:
+                {
+                    auto header = sized(Kind::SignedInt, 2);
+                    return header ? Header{header->kind, header->size, signExtended<std::int16_t>(header->value)} : header;
+                }
+                case 0xd2:
+                {
+                    auto header = sized(Kind::SignedInt, 4);
+                    return header ? Header{header->kind, header->size, signExtended<std::int32_t>(header->value)} : header;
+                }
+                case 0xd3:
+                    return sized(Kind::SignedInt, 8);
+                case 0xd4:
+                    return extension(0, 1);
+                case 0xd5:
+                    return extension(0, 2);
+                case 0xd6:
+                    return extension(0, 4);
+                case 0xd7:
+                    return extension(0, 8);
+                case 0xd8:
+                    return extension(0, 16);
+                case 0xd9:
+                    return sized(Kind::String, 1);
+                case 0xda:
+                    return sized(Kind::String, 2);
+                case 0xdb:
+                    return sized(Kind::String, 4);
+                case 0xdc:
+                    return sized(Kind::Array, 2);
+                case 0xdd:
+                    return sized(Kind::Array, 4);
+                case 0xde:
+                    return sized(Kind::Map, 2);
+                case 0xdf:
+                    return sized(Kind::Map, 4);
+                default:
+                    throw InfluxDBException{"InfluxDB", "Malformed query response at offset " + std::to_string(offset) + ": invalid type"};
+            }
+        }
+
+        /// Bytes following the header
+        std::uint64_t payloadOf(const Header& header)
+        {
+            return (header.kind == Kind::String || header.kind == Kind::Binary || header.kind == Kind::Extension) ? header.value : 0;
+        }
+
+        /// Elements following the header
+        std::uint64_t childrenOf(const Header& header)
+        {
+            switch (header.kind)
+            {
+                case Kind::Array:
+                    return header.value;
+                case Kind::Map:
+                    return header.value * 2;
+                default:
+                    return 0;
+            }
+        }
+    }
+
+    std::size_t MsgPackScanner::scan(std::string_view data)
+    {
+        for (;;)
+        {
+            const auto header = headerAt(data, offset);
+            if (!header || payloadOf(*header) > data.size() - offset - header->size)
+            {
+                return 0;
+            }
+            offset += header->size + payloadOf(*header);
+
+            if (const auto children = childrenOf(*header); children > 0)
+            {
+                if (open.size() == maxNestingDepth)
+                {
+                    throw InfluxDBException{"InfluxDB", "Malformed query response at offset " + std::to_string(offset) + ": nesting too deep"};
+                }
+                open.push_back(children);
+                continue;
+            }
+
+            while (!open.empty() && --open.back() == 0)
+            {
+                open.pop_back();
+            }
+            if (open.empty())
+            {
+                const auto size = offset;
+                offset = 0;
+                return size;
+            }
+        }
+    }
+
+
+    /// Reader over a complete MessagePack document
+    class MsgPackReader
+    {
+    public:
+        explicit MsgPackReader(std::string_view document)
+            : data(document)
+        {
+        }
+
+        std::size_t position() const
+        {
+            return offset;
+        }
+
+        void seek(std::size_t position)
+        {
+            offset = position;
+        }
+
+        bool atEnd() const
+        {
+            return offset == data.size();
+        }
+
+        /// Reads the header of a map, returns the number of entries
+        std::uint64_t map()
+        {
+            return expect(Kind::Map, "expected map").value;
+        }
+
+        /// Reads the header of an array, returns the number of elements
+        std::uint64_t array()
+        {
+            return expect(Kind::Array, "expected array").value;
+        }
+
+        std::string_view string()
+        {
+            return payload(expect(Kind::String, "expected string").value);
+        }
+
+        ResponseValue scalar()
+        {
+            const auto header = next();
+            switch (header.kind)
+            {
+                case Kind::Nil:
+                    return {ResponseValue::Type::Null, "null"};
+                case Kind::Bool:
+                    return {ResponseValue::Type::Bool, header.value != 0 ? "true" : "false"};
+                case Kind::UnsignedInt:
+                    if (header.value > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+                    {
+                        return {ResponseValue::Type::Float, {}, 0, static_cast<double>(header.value)};
+                    }
+                    return {ResponseValue::Type::Integer, {}, static_cast<std::int64_t>(header.value)};
+                case Kind::SignedInt:
+                    return {ResponseValue::Type::Integer, {}, static_cast<std::int64_t>(header.value)};
+                case Kind::Float:
+                    return {ResponseValue::Type::Float, {}, 0, header.size == 5 ? floatOf(header.value) : doubleOf(header.value)};
+                case Kind::String:
+                case Kind::Binary:
+                    return {ResponseValue::Type::String, payload(header.value)};
+                case Kind::Extension:
+                    return time(header);
+                default:
+                    fail("expected value");
+            }
+        }
+
+        void skip(std::size_t depth = 0)
+        {
+            if (depth > maxNestingDepth)
+            {
+                fail("nesting too deep");
+            }
+
+            const auto header = next();
+            payload(payloadOf(header));
+            for (auto children = childrenOf(header); children > 0; --children)
+            {
+                skip(depth + 1);
+            }
+        }
+
+        [[noreturn]] void fail(const std::string& reason) const
+        {
+            throw InfluxDBException{"InfluxDB", "Malformed query response at offset " + std::to_string(offset) + ": " + reason};
+        }
+
+    private:
+        Header next()
+        {
+            const auto header = headerAt(data, offset);
+            if (!header)
+            {
+                fail("unexpected end");
+            }
+            offset += header->size;
+            return *header;
+        }
+
+        Header expect(Kind kind, const std::string& reason)
+        {
+            const auto header = next();
+            if (header.kind != kind)
+            {
+                fail(reason);
+            }
+            return header;
+        }
+
+        std::string_view payload(std::uint64_t size)
+        {
+            if (size > data.size() - offset)
+            {
+                fail("unexpected end");
+            }
+            const auto begin = offset;
+            offset += static_cast<std::size_t>(size);
+            return data.substr(begin, static_cast<std::size_t>(size));
+        }
+
+        static double floatOf(std::uint64_t bits)
+        {
+            const auto narrow = static_cast<std::uint32_t>(bits);
+            float value;
+            std::memcpy(&value, &narrow, sizeof(value));
+            return value;
+        }
+
+        static double doubleOf(std::uint64_t bits)
+        {
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        /// Decodes a timestamp extension: MessagePack timestamps (type -1) and msgp times (type 5, used by InfluxDB)
+        ResponseValue time(const Header& header)
+        {
+            const auto type = static_cast<signed char>(data[offset - 1]);
+            const auto bytes = payload(header.value);
+            std::int64_t seconds{0};
+            std::int64_t nanoseconds{0};
+
+            if (type == -1 && bytes.size() == 4)
+            {
+                seconds = static_cast<std::int64_t>(bigEndian(bytes, 0, 4));
+            }
+            else if (type == -1 && bytes.size() == 8)
+            {
+                const auto value = bigEndian(bytes, 0, 8);
+                nanoseconds = static_cast<std::int64_t>(value >> 34);
+                seconds = static_cast<std::int64_t>(value & 0x3ffffffffu);
+            }
+            else if (type == -1 && bytes.size() == 12)
+            {
+                nanoseconds = static_cast<std::int64_t>(bigEndian(bytes, 0, 4));
+                seconds = static_cast<std::int64_t>(bigEndian(bytes, 4, 8));
+            }
+            else if (type == 5 && bytes.size() == 12)
+            {
+                seconds = static_cast<std::int64_t>(bigEndian(bytes, 0, 8));
+                nanoseconds = static_cast<std::int32_t>(bigEndian(bytes, 8, 4));
+            }
+            else
+            {
+                fail("unsupported extension");
+            }
+            return {ResponseValue::Type::Time, {}, seconds * 1000000000 + nanoseconds};
+        }
+
+        std::string_view data;
+        std::size_t offset{0};
+    };
+
+
+    void MsgPackResponseParser::parse(std::string_view document, QueryResponseHandler& handler)
+    {
+        MsgPackReader reader{document};
+        bool hasResults{false};
+
+        for (auto members = reader.map(); members > 0; --members)
+        {
+            const auto key = reader.string();
+            if (key == "results")
+            {
+                hasResults = true;
+                for (auto results = reader.array(); results > 0; --results)
+                {
+                    parseResult(reader, handler);
+                }
+            }
+            else if (key == "error")
+            {
+                throw InfluxDBException{"InfluxDB", std::string{reader.string()}};
+            }
+            else
+            {
+                reader.skip();
+            }
+        }
+
+        if (!reader.atEnd())
+        {
+            reader.fail("unexpected data after document");
+        }
+        if (!hasResults)
+        {
+            throw InfluxDBException{"InfluxDB", "Query response without results"};
+        }
+    }
+
+    void MsgPackResponseParser::parseResult(MsgPackReader& reader, QueryResponseHandler& handler)
+    {
+        std::size_t statementId{0};
+        bool idKnown{false};
+        bool announced{false};
+        std::optional<std::size_t> deferredSeries;
+        std::optional<std::string_view> error;
+
+        const auto announce = [&] {
+            if (!announced)
+            {
+                handler.onStatement(statementId);
+                announced = true;
+            }
+        };
+
+        // InfluxDB sends the statement id first, series are only deferred if it follows them
+        for (auto members = reader.map(); members > 0; --members)
+        {
+            const auto key = reader.string();
+            if (key == "statement_id")
+            {
+                statementId = static_cast<std::size_t>(reader.scalar().integer);
+                idKnown = true;
+            }
+            else if (key == "series" && idKnown)
+            {
+                announce();
+                for (auto series = reader.array(); series > 0; --series)
+                {
+                    parseSeries(reader, handler);
+                }
+            }
+            else if (key == "series")
+            {
+                deferredSeries = reader.position();
+                reader.skip();
+            }
+            else if (key == "error")
+            {
+                error = reader.string();
+            }
+            else
+            {
+                reader.skip();
+            }
+        }
+
+        announce();
+        if (error)
+        {
+            handler.onStatementError(*error);
+        }
+        if (deferredSeries)
+        {
+            const auto end = reader.position();
+            reader.seek(*deferredSeries);
+            for (auto series = reader.array(); series > 0; --series)
+            {
+                parseSeries(reader, handler);
+            }
+            reader.seek(end);
+        }
+        handler.onStatementEnd();
+    }
+
+    void MsgPackResponseParser::parseSeries(MsgPackReader& reader, QueryResponseHandler& handler)
+    {
+        std::string_view name;
+        bool announced{false};
+        std::optional<std::size_t> deferredValues;
+        tags.clear();
+        columns.clear();
+
+        // InfluxDB sends name and tags before the columns, values are only deferred if they precede the columns
+        for (auto members = reader.map(); members > 0; --members)
+        {
+            const auto key = reader.string();
+            if (key == "name")
+            {
+                name = reader.string();
+            }
+            else if (key == "tags")
+            {
+                for (auto entries = reader.map(); entries > 0; --entries)
+                {
+                    const auto tag = reader.string();
+                    tags.emplace_back(tag, reader.string());
+                }
+            }
+            else if (key == "columns")
+            {
+                for (auto elements = reader.array(); elements > 0; --elements)
+                {
+                    columns.push_back(reader.string());
+                }
+            }
+            else if (key == "values" && !columns.empty())
+            {
+                handler.onSeries(name, tags, columns);
+                announced = true;
+                parseRows(reader, handler);
+            }
+            else if (key == "values")
+            {
+                deferredValues = reader.position();
+                reader.skip();
+            }
+            else
+            {
+                reader.skip();
+            }
+        }
+
+        if (!announced)
+        {
+            handler.onSeries(name, tags, columns);
+        }
+        if (deferredValues)
+        {
+            const auto end = reader.position();
+            reader.seek(*deferredValues);
+            parseRows(reader, handler);
+            reader.seek(end);
+        }
+    }
+
+    void MsgPackResponseParser::parseRows(MsgPackReader& reader, QueryResponseHandler& handler)
+    {
+        for (auto rows = reader.array(); rows > 0; --rows)
+        {
+            row.clear();
+            for (auto values = reader.array(); values > 0; --values)
+            {
+                row.push_back(reader.scalar());
+            }
+            handler.onRow(row);
+        }
+    }
+}
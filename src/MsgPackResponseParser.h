@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "QueryResponseParser.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace influxdb::internal
+{
+    /// Finds the ends of concatenated MessagePack documents received in parts
+    class MsgPackScanner
+    {
+    public:
+        /// Continues scanning the data, which has to start with the data passed before
+        /// \return size of the document completed at the beginning of the data, 0 if it is incomplete;
+        ///         the document has to be removed from the data before scanning again
+        /// \throw InfluxDBException	if the data is no MessagePack
+        std::size_t scan(std::string_view data);
+
+    private:
+        std::size_t offset{0};
+
+        /// Number of elements missing in each open map or array
+        std::vector<std::uint64_t> open;
+    };
+
+    class MsgPackReader;
+
+    /// Parses the MessagePack responses of InfluxDB queries (Accept: application/x-msgpack), which
+    /// have the structure of the JSON responses; numbers and timestamps are passed as binary values
+    class MsgPackResponseParser
+    {
+    public:
+        /// Parses a complete response document
+        /// \throw InfluxDBException	if the document is malformed or reports an error
+        void parse(std::string_view document, QueryResponseHandler& handler);
+
+    private:
+        void parseResult(MsgPackReader& reader, QueryResponseHandler& handler);
+        void parseSeries(MsgPackReader& reader, QueryResponseHandler& handler);
+        void parseRows(MsgPackReader& reader, QueryResponseHandler& handler);
+
+        std::vector<std::pair<std::string_view, std::string_view>> tags;
+        std::vector<std::string_view> columns;
+        std::vector<ResponseValue> row;
+    };
+}
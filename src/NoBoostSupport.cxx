@@ -26,11 +26,6 @@
 
 namespace influxdb::internal
 {
-    std::vector<Point> queryImpl([[maybe_unused]] Transport* transport, [[maybe_unused]] const std::string& query)
-    {
-        throw InfluxDBException("InfluxDB", "Qeury requires Boost");
-    }
-
     std::unique_ptr<Transport> withUdpTransport([[maybe_unused]] const http::url& uri)
     {
         throw InfluxDBException("InfluxDBFactory", "UDP transport requires Boost");
@@ -40,4 +35,9 @@ namespace influxdb::internal
     {
         throw InfluxDBException("InfluxDBFactory", "Unix socket transport requires Boost");
     }
+
+    std::unique_ptr<Transport> withTcpTransport([[maybe_unused]] const http::url& uri)
+    {
+        throw InfluxDBException("InfluxDBFactory", "TCP transport requires Boost");
+    }
 }
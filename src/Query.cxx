@@ -0,0 +1,1013 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Query.h"
+#include "QueryResponseParser.h"
+#include "CsvResponseParser.h"
+#include "MsgPackResponseParser.h"
+#include "InfluxDBException.h"
+#include "Timestamp.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+namespace influxdb::internal
+{
+    namespace
+    {
+        enum class ResponseFormat
+        {
+            Json,
+            Csv,
+            MessagePack
+        };
+
+        /// Reads responses in any of the formats, the format is detected from the first character.
+        /// The response is split into parts which are parsed on their own: the documents of (chunked)
+        /// JSON and MessagePack responses, complete records of CSV responses
+        class ResponseReader
+        {
+        public:
+            explicit ResponseReader(QueryResponseHandler& responseHandler)
+                : handler(responseHandler)
+            {
+            }
+
+            /// Appends data and passes each completed part to the callback, which has to parse() it
+            template <class Callback>
+            void append(std::string_view data, Callback&& onPart)
+            {
+                pending.append(data);
+
+                if (!format && !detectFormat())
+                {
+                    return;
+                }
+                switch (*format)
+                {
+                    case ResponseFormat::Json:
+                        splitDocuments(onPart);
+                        break;
+                    case ResponseFormat::Csv:
+                        splitRecords(onPart);
+                        break;
+                    case ResponseFormat::MessagePack:
+                        splitMessagePack(onPart);
+                        break;
+                }
+            }
+
+            /// Passes the remaining part to the callback and ends the response
+            /// \throw InfluxDBException	if the response is incomplete
+            template <class Callback>
+            void finish(Callback&& onPart)
+            {
+                if (format == ResponseFormat::Csv && !pending.empty())
+                {
+                    onPart(std::string_view{pending});
+                    pending.clear();
+                }
+                if (pending.find_first_not_of(" \t\r\n") != std::string::npos)
+                {
+                    throw InfluxDBException{"InfluxDB", "Incomplete query response"};
+                }
+                if (format == ResponseFormat::Csv)
+                {
+                    csv.finish(handler);
+                }
+            }
+
+            void parse(std::string_view part)
+            {
+                switch (format.value_or(ResponseFormat::Json))
+                {
+                    case ResponseFormat::Json:
+                        json.parse(part, handler);
+                        break;
+                    case ResponseFormat::Csv:
+                        csv.parse(part, handler);
+                        break;
+                    case ResponseFormat::MessagePack:
+                        msgPack.parse(part, handler);
+                        break;
+                }
+            }
+
+        private:
+            bool detectFormat()
+            {
+                const auto begin = pending.find_first_not_of(" \t\r\n");
+                if (begin == std::string::npos)
+                {
+                    return false;
+                }
+
+                // MessagePack responses start with a map
+                const auto first = static_cast<unsigned char>(pending[begin]);
+                if (first == '{')
+                {
+                    format = ResponseFormat::Json;
+                }
+                else if ((first >= 0x80 && first <= 0x8f) || first == 0xde || first == 0xdf)
+                {
+                    format = ResponseFormat::MessagePack;
+                    pending.erase(0, begin);
+                }
+                else
+                {
+                    format = ResponseFormat::Csv;
+                }
+                return true;
+            }
+
+            /// Splits concatenated JSON documents
+            template <class Callback>
+            void splitDocuments(Callback&& onPart)
+            {
+                for (; scanned < pending.size(); ++scanned)
+                {
+                    const char c = pending[scanned];
+
+                    if (inString)
+                    {
+                        if (escaped)
+                        {
+                            escaped = false;
+                        }
+                        else if (c == '\\')
+                        {
+                            escaped = true;
+                        }
+                        else if (c == '"')
+                        {
+                            inString = false;
+                        }
+                    }
+                    else if (c == '"')
+                    {
+                        inString = true;
+                    }
+                    else if (c == '{' || c == '[')
+                    {
+                        ++depth;
+                    }
+                    else if ((c == '}' || c == ']') && (depth > 0) && (--depth == 0))
+                    {
+                        onPart(std::string_view{pending}.substr(0, scanned + 1));
+                        pending.erase(0, scanned + 1);
+                        scanned = static_cast<std::size_t>(-1);
+                    }
+                }
+            }
+
+            /// Splits off the complete records, line breaks within quoted values do not end records
+            template <class Callback>
+            void splitRecords(Callback&& onPart)
+            {
+                std::size_t complete{0};
+                for (; scanned < pending.size(); ++scanned)
+                {
+                    if (pending[scanned] == '"')
+                    {
+                        inString = !inString;
+                    }
+                    else if (pending[scanned] == '\n' && !inString)
+                    {
+                        complete = scanned + 1;
+                    }
+                }
+                if (complete > 0)
+                {
+                    onPart(std::string_view{pending}.substr(0, complete));
+                    pending.erase(0, complete);
+                    scanned = pending.size();
+                }
+            }
+
+            template <class Callback>
+            void splitMessagePack(Callback&& onPart)
+            {
+                while (const auto size = msgPackScanner.scan(pending))
+                {
+                    onPart(std::string_view{pending}.substr(0, size));
+                    pending.erase(0, size);
+                }
+            }
+
+            QueryResponseHandler& handler;
+            std::optional<ResponseFormat> format;
+            std::string pending;
+            std::size_t scanned{0};
+            std::size_t depth{0};
+            bool inString{false};
+            bool escaped{false};
+            MsgPackScanner msgPackScanner;
+            QueryResponseParser json;
+            CsvResponseParser csv;
+            MsgPackResponseParser msgPack;
+        };
+
+        /// Type of a value, numbers without fraction or exponent are integers
+        ColumnType typeOf(std::string_view column, const ResponseValue& value)
+        {
+            if (column == "time")
+            {
+                return ColumnType::Time;
+            }
+            switch (value.type)
+            {
+                case ResponseValue::Type::Null:
+                    return ColumnType::Null;
+                case ResponseValue::Type::Bool:
+                    return ColumnType::Bool;
+                case ResponseValue::Type::String:
+                    return ColumnType::String;
+                case ResponseValue::Type::Integer:
+                    return ColumnType::Int64;
+                case ResponseValue::Type::Float:
+                    return ColumnType::Double;
+                case ResponseValue::Type::Time:
+                    return ColumnType::Time;
+                default:
+                    return value.text.find_first_of(".eE") == std::string_view::npos ? ColumnType::Int64 : ColumnType::Double;
+            }
+        }
+
+        /// Integer of the value, nullopt if it is no integer or out of range for int64
+        std::optional<std::int64_t> integerOf(const ResponseValue& value)
+        {
+            if (value.type == ResponseValue::Type::Integer || value.type == ResponseValue::Type::Time)
+            {
+                return value.integer;
+            }
+
+            if (value.type != ResponseValue::Type::Number)
+            {
+                return std::nullopt;
+            }
+
+            std::int64_t number{0};
+            const auto end = value.text.data() + value.text.size();
+            if (const auto [ptr, ec] = std::from_chars(value.text.data(), end, number); ptr != end || ec != std::errc{})
+            {
+                return std::nullopt;
+            }
+            return number;
+        }
+
+        /// Number of the value, nullopt if it is no number
+        std::optional<double> doubleOf(const ResponseValue& value)
+        {
+            switch (value.type)
+            {
+                case ResponseValue::Type::Float:
+                    return value.real;
+                case ResponseValue::Type::Integer:
+                case ResponseValue::Type::Time:
+                    return static_cast<double>(value.integer);
+                case ResponseValue::Type::Number:
+                {
+                    double number{0.0};
+                    const auto end = value.text.data() + value.text.size();
+                    if (std::from_chars(value.text.data(), end, number).ptr == end)
+                    {
+                        return number;
+                    }
+                    return std::nullopt;
+                }
+                default:
+                    return std::nullopt;
+            }
+        }
+
+        std::string formatDouble(double value)
+        {
+            char buffer[32];
+            const auto end = std::to_chars(std::begin(buffer), std::end(buffer), value).ptr;
+            return std::string(std::begin(buffer), end);
+        }
+
+        /// Text of a binary value
+        std::string formatBinary(const ResponseValue& value)
+        {
+            return value.type == ResponseValue::Type::Float ? formatDouble(value.real) : std::to_string(value.integer);
+        }
+
+        bool isBinary(const ResponseValue& value)
+        {
+            return value.type == ResponseValue::Type::Integer || value.type == ResponseValue::Type::Float || value.type == ResponseValue::Type::Time;
+        }
+
+        std::chrono::system_clock::time_point toTime(const ResponseValue& value)
+        {
+            if (value.type == ResponseValue::Type::Number || isBinary(value))
+            {
+                const auto nanoseconds = integerOf(value).value_or(static_cast<std::int64_t>(doubleOf(value).value_or(0.0)));
+                return std::chrono::system_clock::time_point{std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds{nanoseconds})};
+            }
+            if (const auto time = parseRfc3339(value.text); time)
+            {
+                return *time;
+            }
+            throw InfluxDBException{"InfluxDB", "Invalid timestamp: " + std::string{value.text}};
+        }
+
+        /// Schemas of the columns of the current series as declared in the database, if known
+        class SeriesSchema
+        {
+        public:
+            explicit SeriesSchema(const ColumnSchemaLookup* schemaLookup)
+                : lookup(schemaLookup)
+            {
+            }
+
+            void reset(std::string_view measurement, const std::vector<std::string_view>& columns)
+            {
+                schemas.clear();
+                if (lookup != nullptr)
+                {
+                    for (const auto column : columns)
+                    {
+                        schemas.push_back((*lookup)(measurement, column));
+                    }
+                }
+            }
+
+            std::optional<ColumnSchema> at(std::size_t index) const
+            {
+                return index < schemas.size() ? schemas[index] : std::nullopt;
+            }
+
+            /// Declared type of the column, the type guessed from the value if unknown or if the value
+            /// does not fit, e.g. for an aggregate named like a field
+            ColumnType typeOf(std::size_t index, std::string_view column, const ResponseValue& value) const
+            {
+                const auto guessed = internal::typeOf(column, value);
+                const auto declared = at(index);
+                if (!declared)
+                {
+                    return guessed;
+                }
+
+                const auto isNumeric = [](ColumnType type) { return type == ColumnType::Int64 || type == ColumnType::Double; };
+                return declared->type == guessed || (isNumeric(declared->type) && isNumeric(guessed)) ? declared->type : guessed;
+            }
+
+        private:
+            const ColumnSchemaLookup* lookup;
+            std::vector<std::optional<ColumnSchema>> schemas;
+        };
+
+        /// Builds points of the rows: numbers become fields, all other values tags; with a schema
+        /// tags, integer and string fields are told apart by their declaration instead
+        class PointBuilder : public QueryResponseHandler
+        {
+        public:
+            PointBuilder(const std::function<void(Point&&)>& handler, const ColumnSchemaLookup* schemaLookup)
+                : onPoint(handler), schema(schemaLookup)
+            {
+            }
+
+            void onSeries(std::string_view name,
+                          [[maybe_unused]] const std::vector<std::pair<std::string_view, std::string_view>>& tags,
+                          const std::vector<std::string_view>& seriesColumns) override
+            {
+                seriesName = name;
+                columns = &seriesColumns;
+                schema.reset(name, seriesColumns);
+            }
+
+            void onRow(const std::vector<ResponseValue>& values) override
+            {
+                Point point{seriesName};
+                for (std::size_t i = 0; i < values.size() && i < columns->size(); ++i)
+                {
+                    const auto column = (*columns)[i];
+                    const auto& value = values[i];
+
+                    if (column == "time")
+                    {
+                        point.setTimestamp(toTime(value));
+                        continue;
+                    }
+                    if (addDeclared(point, i, column, value))
+                    {
+                        continue;
+                    }
+
+                    if (const auto number = doubleOf(value); number)
+                    {
+                        point.addField(column, *number);
+                    }
+                    else
+                    {
+                        point.addTag(column, value.text);
+                    }
+                }
+                onPoint(std::move(point));
+            }
+
+        private:
+            /// Adds the value as declared by the schema
+            /// \return false if the column is unknown or of a type added as by default
+            bool addDeclared(Point& point, std::size_t index, std::string_view column, const ResponseValue& value) const
+            {
+                const auto declared = schema.at(index);
+                if (!declared)
+                {
+                    return false;
+                }
+                if (value.type == ResponseValue::Type::Null)
+                {
+                    return true;
+                }
+                if (declared->tag)
+                {
+                    point.addTag(column, value.text);
+                    return true;
+                }
+
+                switch (schema.typeOf(index, column, value))
+                {
+                    case ColumnType::Int64:
+                        if (const auto number = integerOf(value); number)
+                        {
+                            point.addField(column, static_cast<long long int>(*number));
+                            return true;
+                        }
+                        return false;
+                    case ColumnType::String:
+                        point.addField(column, isBinary(value) ? formatBinary(value) : std::string{value.text});
+                        return true;
+                    default:
+                        return false;
+                }
+            }
+
+            const std::function<void(Point&&)>& onPoint;
+            std::string seriesName;
+            const std::vector<std::string_view>* columns{nullptr};
+            SeriesSchema schema;
+        };
+
+        /// Groups the points by statement, keeping the error of each statement
+        class StatementPointsBuilder : public PointBuilder
+        {
+        public:
+            StatementPointsBuilder(const std::function<void(Point&&)>& handler, const ColumnSchemaLookup* schemaLookup,
+                                   std::vector<StatementPoints>& result)
+                : PointBuilder(handler, schemaLookup), statements(result)
+            {
+            }
+
+            void onStatement(std::size_t statementId) override
+            {
+                // Chunked responses repeat the statement for each chunk
+                if (statements.empty() || statements.back().statementId != statementId)
+                {
+                    statements.push_back(StatementPoints{statementId, std::nullopt, {}});
+                }
+            }
+
+            void onStatementError(std::string_view error) override
+            {
+                statements.back().error = std::string{error};
+            }
+
+        private:
+            std::vector<StatementPoints>& statements;
+        };
+
+        QueryValue toQueryValue(ColumnType type, const ResponseValue& value)
+        {
+            switch (value.type == ResponseValue::Type::Null ? ColumnType::Null : type)
+            {
+                case ColumnType::Null:
+                    return std::monostate{};
+                case ColumnType::Int64:
+                    if (const auto number = integerOf(value); number)
+                    {
+                        return *number;
+                    }
+                    [[fallthrough]];
+                case ColumnType::Double:
+                    return doubleOf(value).value_or(0.0);
+                case ColumnType::Bool:
+                    return value.text == "true";
+                case ColumnType::Time:
+                    return toTime(value);
+                default:
+                    return value.text;
+            }
+        }
+
+        /// Passes rows with typed values to the handler, statement errors are thrown
+        class RowStreamer : public QueryResponseHandler
+        {
+        public:
+            RowStreamer(const std::function<void(const QueryRow&)>& handler, const ColumnSchemaLookup* schemaLookup)
+                : onQueryRow(handler), schema(schemaLookup)
+            {
+            }
+
+            void onStatement(std::size_t id) override
+            {
+                statementId = id;
+            }
+
+            void onStatementError(std::string_view error) override
+            {
+                throw InfluxDBException{"InfluxDB", "Statement " + std::to_string(statementId) + " failed: " + std::string{error}};
+            }
+
+            void onSeries(std::string_view name, const std::vector<std::pair<std::string_view, std::string_view>>& tags,
+                          const std::vector<std::string_view>& columns) override
+            {
+                seriesName = name;
+                seriesTags = &tags;
+                seriesColumns = &columns;
+                schema.reset(name, columns);
+            }
+
+            void onRow(const std::vector<ResponseValue>& values) override
+            {
+                row.clear();
+                for (std::size_t i = 0; i < seriesColumns->size(); ++i)
+                {
+                    const auto column = (*seriesColumns)[i];
+                    row.push_back(i < values.size() ? toQueryValue(schema.typeOf(i, column, values[i]), values[i]) : QueryValue{});
+                }
+                onQueryRow(QueryRow{statementId, seriesName, *seriesTags, *seriesColumns, row});
+            }
+
+        private:
+            const std::function<void(const QueryRow&)>& onQueryRow;
+            std::size_t statementId{0};
+            std::string_view seriesName;
+            const std::vector<std::pair<std::string_view, std::string_view>>* seriesTags{nullptr};
+            const std::vector<std::string_view>* seriesColumns{nullptr};
+            std::vector<QueryValue> row;
+            SeriesSchema schema;
+        };
+
+        /// Builds the typed columns of a query result; series split over chunks are merged
+        class ResultBuilder : public QueryResponseHandler
+        {
+        public:
+            ResultBuilder(QueryResult& queryResult, const ColumnSchemaLookup* schemaLookup)
+                : result(queryResult), schema(schemaLookup)
+            {
+            }
+
+            /// Sets the document being parsed, string values are referred to instead of copied
+            void setDocument(std::string_view storedDocument)
+            {
+                document = storedDocument;
+            }
+
+            void onStatement(std::size_t statementId) override
+            {
+                if (result.statements.empty() || result.statements.back().statementId != statementId)
+                {
+                    result.statements.push_back(StatementResult{statementId, std::nullopt, {}});
+                }
+            }
+
+            void onStatementError(std::string_view error) override
+            {
+                result.statements.back().error = std::string{error};
+            }
+
+            void onSeries(std::string_view name, const std::vector<std::pair<std::string_view, std::string_view>>& tags,
+                          const std::vector<std::string_view>& columns) override
+            {
+                auto& series = result.statements.back().series;
+                if (series.empty() || !continues(series.back(), name, tags, columns))
+                {
+                    Series next{std::string{name}, {}, {}};
+                    for (const auto& [key, value] : tags)
+                    {
+                        next.tags.emplace_back(key, value);
+                    }
+                    for (const auto& column : columns)
+                    {
+                        next.columns.push_back(Column{std::string{column}, {}, {}});
+                    }
+                    series.push_back(std::move(next));
+                }
+                schema.reset(name, columns);
+            }
+
+            void onRow(const std::vector<ResponseValue>& values) override
+            {
+                auto& columns = result.statements.back().series.back().columns;
+                for (std::size_t i = 0; i < columns.size(); ++i)
+                {
+                    append(columns[i], i, i < values.size() ? values[i] : ResponseValue{ResponseValue::Type::Null, "null"});
+                }
+            }
+
+        private:
+            static bool continues(const Series& series, std::string_view name,
+                                  const std::vector<std::pair<std::string_view, std::string_view>>& tags,
+                                  const std::vector<std::string_view>& columns)
+            {
+                return series.name == name &&
+                       std::equal(series.tags.cbegin(), series.tags.cend(), tags.cbegin(), tags.cend(),
+                                  [](const auto& lhs, const auto& rhs) { return lhs.first == rhs.first && lhs.second == rhs.second; }) &&
+                       std::equal(series.columns.cbegin(), series.columns.cend(), columns.cbegin(), columns.cend(),
+                                  [](const auto& lhs, const auto& rhs) { return lhs.name == rhs; });
+            }
+
+            /// Returns a view which stays valid for the lifetime of the result
+            std::string_view stable(std::string_view text)
+            {
+                const auto inDocument = text.data() >= document.data() && text.data() + text.size() <= document.data() + document.size();
+                return inDocument ? text : result.store(text);
+            }
+
+            void append(Column& column, std::size_t index, const ResponseValue& value)
+            {
+                if (value.type == ResponseValue::Type::Null)
+                {
+                    column.nulls.push_back(true);
+                    std::visit([](auto& values) {
+                        if constexpr (!std::is_same_v<std::decay_t<decltype(values)>, std::monostate>)
+                        {
+                            values.emplace_back();
+                        }
+                    }, column.values);
+                    return;
+                }
+
+                switch (convert(column, schema.typeOf(index, column.name, value)))
+                {
+                    case ColumnType::Int64:
+                    {
+                        const auto number = integerOf(value);
+                        if (!number)
+                        {
+                            // Out of range for int64
+                            convert(column, ColumnType::Double);
+                            append(column, index, value);
+                            return;
+                        }
+                        std::get<std::vector<std::int64_t>>(column.values).push_back(*number);
+                        break;
+                    }
+                    case ColumnType::Double:
+                        std::get<std::vector<double>>(column.values).push_back(doubleOf(value).value_or(0.0));
+                        break;
+                    case ColumnType::Bool:
+                        std::get<std::vector<bool>>(column.values).push_back(value.text == "true");
+                        break;
+                    case ColumnType::Time:
+                        std::get<std::vector<std::chrono::system_clock::time_point>>(column.values).push_back(toTime(value));
+                        break;
+                    default:
+                        std::get<std::vector<std::string_view>>(column.values).push_back(isBinary(value) ? result.store(formatBinary(value)) : stable(value.text));
+                        break;
+                }
+                column.nulls.push_back(false);
+            }
+
+            /// Converts the column to hold values of the type, columns of mixed types become string columns
+            /// \return type of the column
+            ColumnType convert(Column& column, ColumnType type)
+            {
+                const auto current = column.type();
+                const auto rows = column.nulls.size();
+
+                if (current == type || (current == ColumnType::Double && type == ColumnType::Int64))
+                {
+                    return current;
+                }
+                if (current == ColumnType::Null)
+                {
+                    initialize(column, type, rows);
+                    return type;
+                }
+                if (current == ColumnType::Int64 && type == ColumnType::Double)
+                {
+                    const auto& integers = column.get<std::int64_t>();
+                    column.values = std::vector<double>(integers.cbegin(), integers.cend());
+                    return type;
+                }
+
+                std::vector<std::string_view> texts;
+                texts.reserve(rows + 1);
+                for (std::size_t row = 0; row < rows; ++row)
+                {
+                    texts.push_back(column.nulls[row] ? std::string_view{} : result.store(format(column, row)));
+                }
+                column.values = std::move(texts);
+                return ColumnType::String;
+            }
+
+            static void initialize(Column& column, ColumnType type, std::size_t rows)
+            {
+                switch (type)
+                {
+                    case ColumnType::Int64:
+                        column.values = std::vector<std::int64_t>(rows);
+                        break;
+                    case ColumnType::Double:
+                        column.values = std::vector<double>(rows);
+                        break;
+                    case ColumnType::Bool:
+                        column.values = std::vector<bool>(rows);
+                        break;
+                    case ColumnType::Time:
+                        column.values = std::vector<std::chrono::system_clock::time_point>(rows);
+                        break;
+                    default:
+                        column.values = std::vector<std::string_view>(rows);
+                        break;
+                }
+            }
+
+            static std::string format(const Column& column, std::size_t row)
+            {
+                switch (column.type())
+                {
+                    case ColumnType::Int64:
+                        return std::to_string(column.get<std::int64_t>()[row]);
+                    case ColumnType::Double:
+                        return formatDouble(column.get<double>()[row]);
+                    case ColumnType::Bool:
+                        return column.get<bool>()[row] ? "true" : "false";
+                    case ColumnType::Time:
+                        return std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(column.get<std::chrono::system_clock::time_point>()[row].time_since_epoch()).count());
+                    default:
+                        return std::string{column.get<std::string_view>()[row]};
+                }
+            }
+
+            QueryResult& result;
+            std::string_view document;
+            SeriesSchema schema;
+        };
+    }
+
+    namespace
+    {
+        void throwIfCancelled(const CancellationToken* cancellation)
+        {
+            if (cancellation != nullptr && cancellation->isCancelled())
+            {
+                throw QueryCancelled{"read", "Query cancelled"};
+            }
+        }
+
+        /// Runs the query, each completed part of the response is passed to the callback which parses it
+        template <class Callback>
+        void read(Transport* transport, const std::string& query, ResponseReader& reader, Callback&& onPart,
+                  const CancellationToken* cancellation)
+        {
+            throwIfCancelled(cancellation);
+            const auto onChunk = [&](std::string_view chunk) {
+                throwIfCancelled(cancellation);
+                reader.append(chunk, onPart);
+            };
+
+            if (cancellation != nullptr)
+            {
+                transport->queryCancellable(query, onChunk, [cancellation] { return cancellation->isCancelled(); });
+            }
+            else
+            {
+                transport->queryChunked(query, onChunk);
+            }
+            reader.finish(onPart);
+        }
+    }
+
+    std::vector<Point> queryImpl(Transport* transport, const std::string& query, const CancellationToken* cancellation,
+                                 const ColumnSchemaLookup* schema)
+    {
+        std::vector<Point> points;
+        queryImpl(transport, query, [&points](Point&& point) { points.push_back(std::move(point)); }, cancellation, schema);
+        return points;
+    }
+
+    void queryImpl(Transport* transport, const std::string& query, const std::function<void(Point&&)>& onPoint,
+                   const CancellationToken* cancellation, const ColumnSchemaLookup* schema)
+    {
+        PointBuilder builder{onPoint, schema};
+        ResponseReader reader{builder};
+
+        read(transport, query, reader, [&](std::string_view part) { reader.parse(part); }, cancellation);
+    }
+
+    std::vector<StatementPoints> queryStatementsImpl(Transport* transport, const std::string& query, const CancellationToken* cancellation,
+                                                     const ColumnSchemaLookup* schema)
+    {
+        std::vector<StatementPoints> statements;
+        const std::function<void(Point&&)> onPoint = [&statements](Point&& point) { statements.back().points.push_back(std::move(point)); };
+        StatementPointsBuilder builder{onPoint, schema, statements};
+        ResponseReader reader{builder};
+
+        read(transport, query, reader, [&](std::string_view part) { reader.parse(part); }, cancellation);
+        return statements;
+    }
+
+    void queryStreamImpl(Transport* transport, const std::string& query, const std::function<void(const QueryRow&)>& onRow,
+                         const CancellationToken* cancellation, const ColumnSchemaLookup* schema)
+    {
+        RowStreamer streamer{onRow, schema};
+        ResponseReader reader{streamer};
+
+        read(transport, query, reader, [&](std::string_view part) { reader.parse(part); }, cancellation);
+    }
+
+    QueryResult queryResultImpl(Transport* transport, const std::string& query, const CancellationToken* cancellation,
+                                const ColumnSchemaLookup* schema)
+    {
+        QueryResult result;
+        ResultBuilder builder{result, schema};
+        ResponseReader reader{builder};
+
+        read(transport, query, reader, [&](std::string_view part) {
+            // String columns refer to the stored part
+            const auto stored = result.store(part);
+            builder.setDocument(stored);
+            reader.parse(stored);
+        }, cancellation);
+        return result;
+    }
+
+    std::optional<std::string> unsplittableClause(std::string_view query)
+    {
+        // Limits and descending order apply per window, not to the whole range
+        static constexpr std::string_view keywords[]{"LIMIT", "OFFSET", "SLIMIT", "SOFFSET", "DESC"};
+
+        std::optional<char> quote;
+        std::string word;
+        for (std::size_t i = 0; i <= query.size(); ++i)
+        {
+            const char c = i < query.size() ? query[i] : ' ';
+            if (quote)
+            {
+                if (c == '\\')
+                {
+                    ++i;
+                }
+                else if (c == *quote)
+                {
+                    quote.reset();
+                }
+                continue;
+            }
+            if (c == '\'' || c == '"')
+            {
+                quote = c;
+                word.clear();
+            }
+            else if (std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_')
+            {
+                word.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+            }
+            else
+            {
+                if (std::find(std::cbegin(keywords), std::cend(keywords), word) != std::cend(keywords))
+                {
+                    return word;
+                }
+                word.clear();
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::vector<std::string> splitTimeRange(const std::string& query, std::chrono::system_clock::time_point from,
+                                            std::chrono::system_clock::time_point to, std::size_t windows)
+    {
+        static constexpr std::string_view placeholder{"$timeFilter"};
+
+        if (query.find(placeholder) == std::string::npos)
+        {
+            throw InfluxDBException{__func__, "Query has no $timeFilter"};
+        }
+        if (windows == 0 || from >= to)
+        {
+            throw InfluxDBException{__func__, "Empty time range"};
+        }
+        if (const auto clause = unsplittableClause(query))
+        {
+            throw InfluxDBException{__func__, "Query with " + *clause + " cannot be split into windows"};
+        }
+
+        using std::chrono::nanoseconds;
+        const auto begin = std::chrono::duration_cast<nanoseconds>(from.time_since_epoch()).count();
+        const auto end = std::chrono::duration_cast<nanoseconds>(to.time_since_epoch()).count();
+        const auto length = end - begin;
+        const auto count = static_cast<std::int64_t>(std::min<std::uint64_t>(windows, static_cast<std::uint64_t>(length)));
+
+        // Splits as evenly as possible without overflowing for ranges of centuries
+        const auto boundary = [&](std::int64_t i) { return begin + length / count * i + length % count * i / count; };
+
+        std::vector<std::string> queries;
+        queries.reserve(static_cast<std::size_t>(count));
+        for (std::int64_t i = 0; i < count; ++i)
+        {
+            // Integer time literals are nanoseconds since epoch in InfluxQL
+            const std::string filter{"time >= " + std::to_string(boundary(i)) + " AND time < " + std::to_string(boundary(i + 1))};
+
+            std::string windowQuery{query};
+            for (auto pos = windowQuery.find(placeholder); pos != std::string::npos; pos = windowQuery.find(placeholder, pos + filter.size()))
+            {
+                windowQuery.replace(pos, placeholder.size(), filter);
+            }
+            queries.push_back(std::move(windowQuery));
+        }
+        return queries;
+    }
+
+    void querySplitImpl(Transport* transport, const std::vector<std::string>& queries, const std::function<void(Point&&)>& onPoint,
+                        const ColumnSchemaLookup* schema, std::size_t maxConcurrency)
+    {
+        if (maxConcurrency == 0)
+        {
+            throw InfluxDBException{__func__, "Concurrency of split queries must not be 0"};
+        }
+        if (queries.empty())
+        {
+            return;
+        }
+
+        // Aborts the remaining queries if one fails
+        const CancellationToken cancellation;
+        std::deque<std::future<std::vector<Point>>> pending;
+        auto next = std::next(queries.cbegin());
+        const auto launch = [&] {
+            pending.push_back(std::async(std::launch::async, [transport, query = next, &cancellation, schema] {
+                return queryImpl(transport, *query, &cancellation, schema);
+            }));
+            ++next;
+        };
+
+        try
+        {
+            // At most maxConcurrency windows are queried at once, the streamed one included
+            while (next != queries.cend() && pending.size() + 1 < maxConcurrency)
+            {
+                launch();
+            }
+            queryImpl(transport, queries.front(), onPoint, &cancellation, schema);
+
+            for (auto query = std::next(queries.cbegin()); query != queries.cend(); ++query)
+            {
+                if (pending.empty())
+                {
+                    // Sequential, the window is streamed
+                    queryImpl(transport, *query, onPoint, &cancellation, schema);
+                    ++next;
+                    continue;
+                }
+                auto points = pending.front().get();
+                pending.pop_front();
+                if (next != queries.cend())
+                {
+                    launch();
+                }
+                for (auto& point : points)
+                {
+                    onPoint(std::move(point));
+                }
+            }
+        }
+        catch (...)
+        {
+            cancellation.cancel();
+            throw;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "CancellationToken.h"
+#include "Point.h"
+#include "QueryResult.h"
+#include "Transport.h"
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace influxdb::internal
+{
+    /// Declaration of a column in the database
+    struct ColumnSchema
+    {
+        /// Type of the field, String for tags
+        ColumnType type;
+        /// Whether the column is a tag
+        bool tag;
+    };
+
+    /// Returns the declaration of a column of a measurement, std::nullopt if unknown
+    using ColumnSchemaLookup = std::function<std::optional<ColumnSchema>(std::string_view measurement, std::string_view column)>;
+
+    /// Query functions, values are typed as declared by the schema lookup if it is given and
+    /// knows the column, else by the value
+    std::vector<Point> queryImpl(Transport* transport, const std::string& query, const CancellationToken* cancellation = nullptr,
+                                 const ColumnSchemaLookup* schema = nullptr);
+    void queryImpl(Transport* transport, const std::string& query, const std::function<void(Point&&)>& onPoint,
+                   const CancellationToken* cancellation = nullptr, const ColumnSchemaLookup* schema = nullptr);
+    std::vector<StatementPoints> queryStatementsImpl(Transport* transport, const std::string& query,
+                                                     const CancellationToken* cancellation = nullptr,
+                                                     const ColumnSchemaLookup* schema = nullptr);
+    QueryResult queryResultImpl(Transport* transport, const std::string& query, const CancellationToken* cancellation = nullptr,
+                                const ColumnSchemaLookup* schema = nullptr);
+    void queryStreamImpl(Transport* transport, const std::string& query, const std::function<void(const QueryRow&)>& onRow,
+                         const CancellationToken* cancellation = nullptr, const ColumnSchemaLookup* schema = nullptr);
+
+    /// Creates a query per window of the time range by replacing each `$timeFilter` of the query
+    /// with the time condition of the window; windows have equal length and do not overlap
+    /// \throw InfluxDBException 	if the query has no `$timeFilter`, the range is empty, windows is 0 or
+    /// the query has a clause which is not applied to the whole range (see \ref unsplittableClause())
+    /// First clause of the query which gives wrong results if the query is split into windows
+    /// (LIMIT, OFFSET, SLIMIT, SOFFSET or DESC), std::nullopt if there is none
+    std::optional<std::string> unsplittableClause(std::string_view query);
+
+    std::vector<std::string> splitTimeRange(const std::string& query, std::chrono::system_clock::time_point from,
+                                            std::chrono::system_clock::time_point to, std::size_t windows);
+
+    /// Runs the queries concurrently, the points are passed in order of the queries; the points of the
+    /// first query are streamed, those of the others are buffered until the preceding queries are done
+    /// \param maxConcurrency 	queries running at once, each further query starts once the oldest is passed
+    /// \throw InfluxDBException 	if a query fails or maxConcurrency is 0
+    void querySplitImpl(Transport* transport, const std::vector<std::string>& queries, const std::function<void(Point&&)>& onPoint,
+                        const ColumnSchemaLookup* schema = nullptr, std::size_t maxConcurrency = 8);
+}
@@ -0,0 +1,303 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "QueryCache.h"
+#include "InfluxDBException.h"
+#include <utility>
+
+namespace influxdb::internal
+{
+    namespace
+    {
+        /// Approximate memory used by an entry besides the key and response
+        constexpr std::size_t entryOverhead{128};
+
+        /// Interval a call waiting for the request of a concurrent call checks whether it is cancelled
+        constexpr std::chrono::milliseconds cancellationPollInterval{10};
+
+        bool isSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+    }
+
+    QueryCache::QueryCache(std::unique_ptr<Transport> transport, std::chrono::milliseconds ttl, std::size_t maxBytes)
+        : TransportDecorator(std::move(transport)), mTtl(ttl), mMaxBytes(maxBytes), mBytes{0}, mStatistics{0, 0, 0}
+    {
+    }
+
+    std::string QueryCache::query(const std::string& query)
+    {
+        std::string response;
+        queryChunked(query, [&response](std::string_view chunk) { response.append(chunk); });
+        return response;
+    }
+
+    void QueryCache::queryChunked(const std::string& query, const std::function<void(std::string_view)>& onChunk)
+    {
+        queryCached(query, onChunk, nullptr);
+    }
+
+    void QueryCache::queryCancellable(const std::string& query, const std::function<void(std::string_view)>& onChunk,
+                                      const std::function<bool()>& isCancelled)
+    {
+        queryCached(query, onChunk, &isCancelled);
+    }
+
+    void QueryCache::queryCached(const std::string& query, const std::function<void(std::string_view)>& onChunk,
+                                 const std::function<bool()>* isCancelled)
+    {
+        const auto key = normalize(query);
+        std::shared_ptr<Flight> flight;
+        Response response;
+        std::exception_ptr error;
+
+        {
+            std::unique_lock<std::mutex> lock{mMutex};
+            if (response = lookup(key); response)
+            {
+                ++mStatistics.hits;
+            }
+            else if (const auto running = mFlights.find(key); running != mFlights.end())
+            {
+                ++mStatistics.coalesced;
+                const auto shared = running->second;
+                const auto done = [&shared] { return shared->done; };
+                if (isCancelled == nullptr)
+                {
+                    mFlightDone.wait(lock, done);
+                }
+                else
+                {
+                    while (!mFlightDone.wait_for(lock, cancellationPollInterval, done))
+                    {
+                        if ((*isCancelled)())
+                        {
+                            throw QueryCancelled{__func__, "Query cancelled"};
+                        }
+                    }
+                }
+                response = shared->response;
+                error = shared->error;
+            }
+            else
+            {
+                ++mStatistics.misses;
+                flight = std::make_shared<Flight>();
+                mFlights.emplace(key, flight);
+            }
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        if (response)
+        {
+            onChunk(*response);
+        }
+        else if (flight)
+        {
+            fetch(query, key, flight, onChunk, isCancelled);
+        }
+        else
+        {
+            // The shared request was not cacheable or aborted by its caller
+            request(query, onChunk, isCancelled);
+        }
+    }
+
+    QueryCache::Statistics QueryCache::statistics() const
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        return mStatistics;
+    }
+
+    std::string QueryCache::normalize(std::string_view query)
+    {
+        std::string normalized;
+        normalized.reserve(query.size());
+        char quote{'\0'};
+        bool space{false};
+
+        for (std::size_t i = 0; i < query.size(); ++i)
+        {
+            const char c = query[i];
+            if (quote != '\0')
+            {
+                normalized.push_back(c);
+                if (c == '\\' && i + 1 < query.size())
+                {
+                    normalized.push_back(query[++i]);
+                }
+                else if (c == quote)
+                {
+                    quote = '\0';
+                }
+            }
+            else if (isSpace(c))
+            {
+                space = true;
+            }
+            else
+            {
+                if (space && !normalized.empty())
+                {
+                    normalized.push_back(' ');
+                }
+                space = false;
+                quote = (c == '\'' || c == '"') ? c : '\0';
+                normalized.push_back(c);
+            }
+        }
+
+        while (quote == '\0' && !normalized.empty() && (normalized.back() == ';' || normalized.back() == ' '))
+        {
+            normalized.pop_back();
+        }
+        return normalized;
+    }
+
+    QueryCache::Response QueryCache::lookup(const std::string& key)
+    {
+        const auto entry = mEntries.find(key);
+        if (entry == mEntries.end())
+        {
+            return nullptr;
+        }
+        if (entry->second.expiry <= std::chrono::steady_clock::now())
+        {
+            mBytes -= sizeOf(key, *entry->second.response);
+            mUsage.erase(entry->second.usage);
+            mEntries.erase(entry);
+            return nullptr;
+        }
+        mUsage.splice(mUsage.begin(), mUsage, entry->second.usage);
+        return entry->second.response;
+    }
+
+    void QueryCache::insert(const std::string& key, Response response)
+    {
+        const auto size = sizeOf(key, *response);
+        if (mTtl.count() <= 0 || size > mMaxBytes || mEntries.count(key) > 0)
+        {
+            return;
+        }
+
+        while (mBytes + size > mMaxBytes)
+        {
+            const auto evicted = mEntries.find(mUsage.back());
+            mBytes -= sizeOf(evicted->first, *evicted->second.response);
+            mEntries.erase(evicted);
+            mUsage.pop_back();
+        }
+
+        mUsage.push_front(key);
+        mEntries.emplace(key, Entry{std::move(response), std::chrono::steady_clock::now() + mTtl, mUsage.begin()});
+        mBytes += size;
+    }
+
+    void QueryCache::fetch(const std::string& query, const std::string& key, const std::shared_ptr<Flight>& flight,
+                           const std::function<void(std::string_view)>& onChunk, const std::function<bool()>* isCancelled)
+    {
+        auto response = std::make_shared<std::string>();
+        bool cacheable{true};
+        bool handlerFailed{false};
+
+        const auto complete = [&](Response result, std::exception_ptr error) {
+            {
+                std::lock_guard<std::mutex> lock{mMutex};
+                flight->done = true;
+                flight->response = result;
+                flight->error = error;
+                mFlights.erase(key);
+                if (result)
+                {
+                    insert(key, result);
+                }
+            }
+            mFlightDone.notify_all();
+        };
+
+        try
+        {
+            // A failing handler aborts the request, e.g. if the caller stops reading
+            request(
+                query,
+                [&](std::string_view chunk) {
+                    if (cacheable && response->size() + chunk.size() > mMaxBytes)
+                    {
+                        cacheable = false;
+                        std::string{}.swap(*response);
+                    }
+                    if (cacheable)
+                    {
+                        response->append(chunk);
+                    }
+
+                    try
+                    {
+                        onChunk(chunk);
+                    }
+                    catch (...)
+                    {
+                        handlerFailed = true;
+                        throw;
+                    }
+                },
+                isCancelled);
+        }
+        catch (const QueryCancelled&)
+        {
+            // Cancellation of this call is not passed to waiting calls, which send their own requests
+            complete(nullptr, nullptr);
+            throw;
+        }
+        catch (...)
+        {
+            // Neither are errors of the handler
+            complete(nullptr, handlerFailed ? nullptr : std::current_exception());
+            throw;
+        }
+
+        complete(cacheable ? std::move(response) : nullptr, nullptr);
+    }
+
+    void QueryCache::request(const std::string& query, const std::function<void(std::string_view)>& onChunk,
+                             const std::function<bool()>* isCancelled)
+    {
+        if (isCancelled != nullptr)
+        {
+            next().queryCancellable(query, onChunk, *isCancelled);
+        }
+        else
+        {
+            next().queryChunked(query, onChunk);
+        }
+    }
+
+    std::size_t QueryCache::sizeOf(const std::string& key, const std::string& response)
+    {
+        return 2 * key.size() + response.size() + entryOverhead;
+    }
+}
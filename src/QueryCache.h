@@ -0,0 +1,133 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "TransportDecorator.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace influxdb::internal
+{
+    /// Caches the responses of queries sent through a transport, keyed by the normalized query text.
+    /// Entries expire after the TTL, least recently used entries are evicted to stay within the memory cap.
+    /// Concurrent calls of a query which is not cached share a single request (single-flight).
+    /// Calls other than queries are passed to the wrapped transport.
+    class QueryCache : public transports::TransportDecorator
+    {
+    public:
+        struct Statistics
+        {
+            std::size_t hits;
+            std::size_t misses;
+
+            /// Calls which waited for the request of a concurrent call
+            std::size_t coalesced;
+        };
+
+        /// \param transport 	transport used for queries
+        /// \param ttl 	time entries are used after being received
+        /// \param maxBytes 	memory cap of the cached responses
+        /// \throw InfluxDBException 	if transport is nullptr
+        QueryCache(std::unique_ptr<Transport> transport, std::chrono::milliseconds ttl, std::size_t maxBytes);
+
+        std::string query(const std::string& query) override;
+
+        /// Passes the cached response as one chunk; otherwise the response of the transport is passed while received.
+        /// The request is aborted if the handler throws, calls sharing it send their own request then.
+        /// \throw InfluxDBException	if the query fails, the error is passed to all calls sharing the request
+        void queryChunked(const std::string& query, const std::function<void(std::string_view)>& onChunk) override;
+
+        /// Like queryChunked(), a call waiting for the request of a concurrent call stops waiting once cancelled
+        /// \throw QueryCancelled 	if the request is aborted, calls sharing it send their own request then
+        void queryCancellable(const std::string& query, const std::function<void(std::string_view)>& onChunk,
+                              const std::function<bool()>& isCancelled) override;
+
+        Statistics statistics() const;
+
+        /// Collapses whitespace outside of quotes and removes trailing semicolons
+        static std::string normalize(std::string_view query);
+
+    private:
+        using Response = std::shared_ptr<const std::string>;
+
+        struct Entry
+        {
+            Response response;
+            std::chrono::steady_clock::time_point expiry;
+            std::list<std::string>::iterator usage;
+        };
+
+        /// Request shared by concurrent calls
+        struct Flight
+        {
+            bool done{false};
+
+            /// Response, nullptr if it was not cacheable or the request failed
+            Response response;
+            std::exception_ptr error;
+        };
+
+        /// Answers the query from the cache, the request of a concurrent call or a new request;
+        /// isCancelled is nullptr if the query can not be cancelled
+        void queryCached(const std::string& query, const std::function<void(std::string_view)>& onChunk,
+                         const std::function<bool()>* isCancelled);
+
+        /// Returns the cached response or nullptr; called with the lock held
+        Response lookup(const std::string& key);
+
+        /// Inserts the response, evicting entries as needed; called with the lock held
+        void insert(const std::string& key, Response response);
+
+        /// Runs the request, passes it to the handler and to waiting calls
+        void fetch(const std::string& query, const std::string& key, const std::shared_ptr<Flight>& flight,
+                   const std::function<void(std::string_view)>& onChunk, const std::function<bool()>* isCancelled);
+
+        /// Sends the query to the wrapped transport
+        void request(const std::string& query, const std::function<void(std::string_view)>& onChunk,
+                     const std::function<bool()>* isCancelled);
+
+        static std::size_t sizeOf(const std::string& key, const std::string& response);
+
+        const std::chrono::milliseconds mTtl;
+        const std::size_t mMaxBytes;
+
+        mutable std::mutex mMutex;
+        std::condition_variable mFlightDone;
+        std::unordered_map<std::string, Entry> mEntries;
+
+        /// Keys of the entries, most recently used first
+        std::list<std::string> mUsage;
+        std::size_t mBytes;
+        std::unordered_map<std::string, std::shared_ptr<Flight>> mFlights;
+        Statistics mStatistics;
+    };
+}
@@ -0,0 +1,458 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "QueryResponseParser.h"
+#include "InfluxDBException.h"
+#include <charconv>
+#include <optional>
+
+namespace influxdb::internal
+{
+    namespace
+    {
+        constexpr std::size_t maxNestingDepth{64};
+
+        void appendUtf8(std::string& dest, unsigned long codePoint)
+        {
+            if (codePoint < 0x80)
+            {
+                dest.push_back(static_cast<char>(codePoint));
+            }
+            else if (codePoint < 0x800)
+            {
+                dest.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+                dest.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else if (codePoint < 0x10000)
+            {
+                dest.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+                dest.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                dest.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else
+            {
+                dest.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+                dest.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+                dest.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                dest.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+        }
+
+        bool isNumberCharacter(char c)
+        {
+            return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+        }
+    }
+
+    /// Pull reader over a complete JSON document
+    class JsonReader
+    {
+    public:
+        JsonReader(std::string_view document, std::deque<std::string>& unescapedStorage)
+            : data(document), storage(unescapedStorage)
+        {
+        }
+
+        std::size_t position() const
+        {
+            return offset;
+        }
+
+        void seek(std::size_t position)
+        {
+            offset = position;
+        }
+
+        /// Returns the next non-whitespace character, '\0' at the end of the document
+        char peek()
+        {
+            while (offset < data.size() && (data[offset] == ' ' || data[offset] == '\n' || data[offset] == '\r' || data[offset] == '\t'))
+            {
+                ++offset;
+            }
+            return offset < data.size() ? data[offset] : '\0';
+        }
+
+        bool atEnd()
+        {
+            return peek() == '\0' && offset == data.size();
+        }
+
+        bool consume(char c)
+        {
+            if (peek() == c)
+            {
+                ++offset;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char c)
+        {
+            if (!consume(c))
+            {
+                fail(std::string{"expected '"} + c + "'");
+            }
+        }
+
+        /// Passes the key of each member to the handler, which has to read the value
+        template <class Handler>
+        void object(Handler&& onMember)
+        {
+            expect('{');
+            if (consume('}'))
+            {
+                return;
+            }
+            do
+            {
+                const auto key = string();
+                expect(':');
+                onMember(key);
+            } while (consume(','));
+            expect('}');
+        }
+
+        /// Calls the handler for each element, which has to read the element
+        template <class Handler>
+        void array(Handler&& onElement)
+        {
+            expect('[');
+            if (consume(']'))
+            {
+                return;
+            }
+            do
+            {
+                onElement();
+            } while (consume(','));
+            expect(']');
+        }
+
+        std::string_view string()
+        {
+            expect('"');
+            const auto begin = offset;
+            while (offset < data.size() && data[offset] != '"' && data[offset] != '\\')
+            {
+                ++offset;
+            }
+            if (offset < data.size() && data[offset] == '"')
+            {
+                return data.substr(begin, offset++ - begin);
+            }
+            return unescapeFrom(begin);
+        }
+
+        ResponseValue scalar()
+        {
+            switch (peek())
+            {
+                case '"':
+                    return {ResponseValue::Type::String, string()};
+                case 't':
+                    return {ResponseValue::Type::Bool, literal("true")};
+                case 'f':
+                    return {ResponseValue::Type::Bool, literal("false")};
+                case 'n':
+                    return {ResponseValue::Type::Null, literal("null")};
+                default:
+                    return {ResponseValue::Type::Number, number()};
+            }
+        }
+
+        void skip(std::size_t depth = 0)
+        {
+            if (depth > maxNestingDepth)
+            {
+                fail("nesting too deep");
+            }
+
+            switch (peek())
+            {
+                case '{':
+                    object([this, depth]([[maybe_unused]] std::string_view key) { skip(depth + 1); });
+                    break;
+                case '[':
+                    array([this, depth] { skip(depth + 1); });
+                    break;
+                default:
+                    scalar();
+                    break;
+            }
+        }
+
+        [[noreturn]] void fail(const std::string& reason) const
+        {
+            throw InfluxDBException{"InfluxDB", "Malformed query response at offset " + std::to_string(offset) + ": " + reason};
+        }
+
+    private:
+        std::string_view literal(std::string_view expected)
+        {
+            if (data.substr(offset, expected.size()) != expected)
+            {
+                fail("invalid literal");
+            }
+            offset += expected.size();
+            return expected;
+        }
+
+        std::string_view number()
+        {
+            const auto begin = offset;
+            while (offset < data.size() && isNumberCharacter(data[offset]))
+            {
+                ++offset;
+            }
+            if (offset == begin)
+            {
+                fail("expected value");
+            }
+            return data.substr(begin, offset - begin);
+        }
+
+        unsigned long hexCodeUnit()
+        {
+            unsigned long value{0};
+            const auto end = offset + 4;
+            if (end > data.size() || std::from_chars(data.data() + offset, data.data() + end, value, 16).ptr != data.data() + end)
+            {
+                fail("invalid unicode escape");
+            }
+            offset = end;
+            return value;
+        }
+
+        /// Unescapes a string containing escape sequences into the storage
+        std::string_view unescapeFrom(std::size_t begin)
+        {
+            std::string& value = storage.emplace_back(data.substr(begin, offset - begin));
+
+            while (offset < data.size() && data[offset] != '"')
+            {
+                if (data[offset] != '\\')
+                {
+                    value.push_back(data[offset++]);
+                    continue;
+                }
+                if (++offset == data.size())
+                {
+                    break;
+                }
+                switch (const char c = data[offset++]; c)
+                {
+                    case 'b':
+                        value.push_back('\b');
+                        break;
+                    case 'f':
+                        value.push_back('\f');
+                        break;
+                    case 'n':
+                        value.push_back('\n');
+                        break;
+                    case 'r':
+                        value.push_back('\r');
+                        break;
+                    case 't':
+                        value.push_back('\t');
+                        break;
+                    case 'u':
+                    {
+                        auto codePoint = hexCodeUnit();
+                        if (codePoint >= 0xD800 && codePoint < 0xDC00 && data.substr(offset, 2) == "\\u")
+                        {
+                            offset += 2;
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (hexCodeUnit() - 0xDC00);
+                        }
+                        appendUtf8(value, codePoint);
+                        break;
+                    }
+                    default:
+                        value.push_back(c);
+                        break;
+                }
+            }
+            expect('"');
+            return value;
+        }
+
+        std::string_view data;
+        std::deque<std::string>& storage;
+        std::size_t offset{0};
+    };
+
+
+    void QueryResponseParser::parse(std::string_view document, QueryResponseHandler& handler)
+    {
+        unescaped.clear();
+        JsonReader reader{document, unescaped};
+        bool hasResults{false};
+
+        reader.object([&](std::string_view key) {
+            if (key == "results")
+            {
+                hasResults = true;
+                reader.array([&] { parseResult(reader, handler); });
+            }
+            else if (key == "error")
+            {
+                throw InfluxDBException{"InfluxDB", std::string{reader.string()}};
+            }
+            else
+            {
+                reader.skip();
+            }
+        });
+
+        if (!reader.atEnd())
+        {
+            reader.fail("unexpected data after document");
+        }
+        if (!hasResults)
+        {
+            throw InfluxDBException{"InfluxDB", "Query response without results"};
+        }
+    }
+
+    void QueryResponseParser::parseResult(JsonReader& reader, QueryResponseHandler& handler)
+    {
+        std::size_t statementId{0};
+        bool idKnown{false};
+        bool announced{false};
+        std::optional<std::size_t> deferredSeries;
+        std::optional<std::string_view> error;
+
+        const auto announce = [&] {
+            if (!announced)
+            {
+                handler.onStatement(statementId);
+                announced = true;
+            }
+        };
+
+        // InfluxDB sends the statement id first, series are only deferred if it follows them
+        reader.object([&](std::string_view key) {
+            if (key == "statement_id")
+            {
+                const auto value = reader.scalar();
+                std::from_chars(value.text.data(), value.text.data() + value.text.size(), statementId);
+                idKnown = true;
+            }
+            else if (key == "series" && idKnown)
+            {
+                announce();
+                reader.array([&] { parseSeries(reader, handler); });
+            }
+            else if (key == "series")
+            {
+                deferredSeries = reader.position();
+                reader.skip();
+            }
+            else if (key == "error")
+            {
+                error = reader.string();
+            }
+            else
+            {
+                reader.skip();
+            }
+        });
+
+        announce();
+        if (error)
+        {
+            handler.onStatementError(*error);
+        }
+        if (deferredSeries)
+        {
+            const auto end = reader.position();
+            reader.seek(*deferredSeries);
+            reader.array([&] { parseSeries(reader, handler); });
+            reader.seek(end);
+        }
+        handler.onStatementEnd();
+    }
+
+    void QueryResponseParser::parseSeries(JsonReader& reader, QueryResponseHandler& handler)
+    {
+        std::string_view name;
+        bool announced{false};
+        std::optional<std::size_t> deferredValues;
+        tags.clear();
+        columns.clear();
+
+        // InfluxDB sends name and tags before the columns, values are only deferred if they precede the columns
+        reader.object([&](std::string_view key) {
+            if (key == "name")
+            {
+                name = reader.string();
+            }
+            else if (key == "tags")
+            {
+                reader.object([&](std::string_view tag) { tags.emplace_back(tag, reader.string()); });
+            }
+            else if (key == "columns")
+            {
+                reader.array([&] { columns.push_back(reader.string()); });
+            }
+            else if (key == "values" && !columns.empty())
+            {
+                handler.onSeries(name, tags, columns);
+                announced = true;
+                parseRows(reader, handler);
+            }
+            else if (key == "values")
+            {
+                deferredValues = reader.position();
+                reader.skip();
+            }
+            else
+            {
+                reader.skip();
+            }
+        });
+
+        if (!announced)
+        {
+            handler.onSeries(name, tags, columns);
+        }
+        if (deferredValues)
+        {
+            const auto end = reader.position();
+            reader.seek(*deferredValues);
+            parseRows(reader, handler);
+            reader.seek(end);
+        }
+    }
+
+    void QueryResponseParser::parseRows(JsonReader& reader, QueryResponseHandler& handler)
+    {
+        reader.array([&] {
+            row.clear();
+            reader.array([&] { row.push_back(reader.scalar()); });
+            handler.onRow(row);
+        });
+    }
+}
@@ -0,0 +1,120 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace influxdb::internal
+{
+    /// Scalar value of a query response; text formats (JSON, CSV) pass numbers as text,
+    /// binary formats (MessagePack) as Integer, Float or Time values
+    struct ResponseValue
+    {
+        enum class Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Integer,
+            Float,
+            Time
+        };
+
+        Type type;
+
+        /// Text of the value as sent, strings without quotes and unescaped; empty for binary values
+        std::string_view text;
+
+        /// Value of Integer values, nanoseconds since epoch for Time values
+        std::int64_t integer{0};
+
+        /// Value of Float values
+        double real{0.0};
+    };
+
+    /// Receives the parts of a query response while it is parsed;
+    /// views are valid until the callback returns
+    class QueryResponseHandler
+    {
+    public:
+        virtual ~QueryResponseHandler() = default;
+
+        /// Called at the beginning of a statement result
+        virtual void onStatement([[maybe_unused]] std::size_t statementId)
+        {
+        }
+
+        /// Called if the statement failed
+        virtual void onStatementError([[maybe_unused]] std::string_view error)
+        {
+        }
+
+        /// Called at the beginning of a series, before its rows
+        virtual void onSeries([[maybe_unused]] std::string_view name,
+                              [[maybe_unused]] const std::vector<std::pair<std::string_view, std::string_view>>& tags,
+                              [[maybe_unused]] const std::vector<std::string_view>& columns)
+        {
+        }
+
+        /// Called for each row of the current series, values are in column order
+        virtual void onRow([[maybe_unused]] const std::vector<ResponseValue>& values)
+        {
+        }
+
+        /// Called at the end of a statement result
+        virtual void onStatementEnd()
+        {
+        }
+    };
+
+    class JsonReader;
+
+    /// Parses the JSON responses of InfluxDB queries (results / series / columns / values)
+    /// without building a document tree; rows are passed to the handler as they are read
+    class QueryResponseParser
+    {
+    public:
+        /// Parses a complete response document
+        /// \throw InfluxDBException	if the document is malformed or reports an error
+        void parse(std::string_view document, QueryResponseHandler& handler);
+
+    private:
+        void parseResult(JsonReader& reader, QueryResponseHandler& handler);
+        void parseSeries(JsonReader& reader, QueryResponseHandler& handler);
+        void parseRows(JsonReader& reader, QueryResponseHandler& handler);
+
+        /// Storage of unescaped strings, only used for strings containing escape sequences
+        std::deque<std::string> unescaped;
+        std::vector<std::pair<std::string_view, std::string_view>> tags;
+        std::vector<std::string_view> columns;
+        std::vector<ResponseValue> row;
+    };
+}
@@ -0,0 +1,416 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "SchemaCache.h"
+#include "InfluxDBException.h"
+#include <utility>
+
+namespace influxdb::internal
+{
+    namespace
+    {
+        std::optional<ColumnType> typeOfFieldType(std::string_view fieldType)
+        {
+            if (fieldType == "float")
+            {
+                return ColumnType::Double;
+            }
+            if (fieldType == "integer" || fieldType == "unsigned")
+            {
+                return ColumnType::Int64;
+            }
+            if (fieldType == "string")
+            {
+                return ColumnType::String;
+            }
+            if (fieldType == "boolean")
+            {
+                return ColumnType::Bool;
+            }
+            return std::nullopt;
+        }
+
+        std::string_view nameOf(ColumnType type)
+        {
+            switch (type)
+            {
+                case ColumnType::Int64:
+                    return "integer";
+                case ColumnType::Double:
+                    return "float";
+                case ColumnType::Bool:
+                    return "boolean";
+                default:
+                    return "string";
+            }
+        }
+
+        /// Type of a line protocol field value
+        ColumnType typeOfValue(std::string_view value)
+        {
+            if (!value.empty() && (value.back() == 'i' || value.back() == 'u'))
+            {
+                return ColumnType::Int64;
+            }
+            for (const std::string_view boolean : {"t", "T", "true", "True", "TRUE", "f", "F", "false", "False", "FALSE"})
+            {
+                if (value == boolean)
+                {
+                    return ColumnType::Bool;
+                }
+            }
+            return ColumnType::Double;
+        }
+
+        /// Calls the handler with the unescaped name and the type of each field of a line protocol field set
+        template <class Handler>
+        void forEachField(std::string_view fields, Handler&& handler)
+        {
+            std::size_t pos{0};
+            while (pos < fields.size())
+            {
+                // Commas, equal signs and spaces of field keys are escaped by a backslash
+                std::string name;
+                for (; pos < fields.size() && fields[pos] != '='; ++pos)
+                {
+                    if (fields[pos] == '\\' && pos + 1 < fields.size())
+                    {
+                        ++pos;
+                    }
+                    name.push_back(fields[pos]);
+                }
+                if (pos == fields.size())
+                {
+                    return;
+                }
+                const auto equals = pos;
+
+                auto end = equals + 1;
+                if (end < fields.size() && fields[end] == '"')
+                {
+                    for (++end; end < fields.size() && fields[end] != '"'; ++end)
+                    {
+                        end += (fields[end] == '\\' ? 1 : 0);
+                    }
+                    handler(std::string_view{name}, ColumnType::String);
+                    ++end;
+                }
+                else
+                {
+                    end = std::min(fields.find(',', end), fields.size());
+                    handler(std::string_view{name}, typeOfValue(fields.substr(equals + 1, end - equals - 1)));
+                }
+                pos = end + 1;
+            }
+        }
+
+        std::string quoted(std::string_view identifier)
+        {
+            std::string result{"\""};
+            for (const char c : identifier)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    result += '\\';
+                }
+                result += c;
+            }
+            return result + "\"";
+        }
+
+        const std::vector<std::string_view>* stringsOf(const Series& series, std::string_view column)
+        {
+            const auto values = series.findColumn(column);
+            return values && values->get().type() == ColumnType::String ? &values->get().get<std::string_view>() : nullptr;
+        }
+    }
+
+    SchemaCache::SchemaCache(Transport& transport, std::chrono::milliseconds refreshInterval)
+        : mTransport(transport), mRefreshInterval(refreshInterval),
+          mLookup([this](std::string_view measurement, std::string_view name) { return column(measurement, name); }),
+          mMeasurements{}, mLoaded{false}, mLoading{false}, mStopped{false}
+    {
+        mRefresher = std::thread{[this] { refreshPeriodically(); }};
+    }
+
+    SchemaCache::~SchemaCache()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mMutex};
+            mStopped = true;
+        }
+        mWake.notify_all();
+        mRefresher.join();
+    }
+
+    std::vector<std::string> SchemaCache::measurements()
+    {
+        std::unique_lock<std::mutex> lock{mMutex};
+        loadOnce(lock);
+
+        std::vector<std::string> names;
+        for (const auto& [name, measurement] : mMeasurements)
+        {
+            names.push_back(name);
+        }
+        return names;
+    }
+
+    std::optional<ColumnSchema> SchemaCache::column(std::string_view measurement, std::string_view name)
+    {
+        std::unique_lock<std::mutex> lock{mMutex};
+        loadOnce(lock);
+        const auto& schema = find(measurement);
+        if (const auto field = schema.fields.find(name); field != schema.fields.cend())
+        {
+            return ColumnSchema{field->second, false};
+        }
+        for (const auto& tag : schema.tags)
+        {
+            if (tag == name)
+            {
+                return ColumnSchema{ColumnType::String, true};
+            }
+        }
+        return std::nullopt;
+    }
+
+    const ColumnSchemaLookup& SchemaCache::lookup() const
+    {
+        return mLookup;
+    }
+
+    void SchemaCache::check(const std::vector<Point>& points)
+    {
+        check(points.data(), points.data() + points.size());
+    }
+
+    void SchemaCache::check(const Point& point)
+    {
+        check(&point, &point + 1);
+    }
+
+    void SchemaCache::check(const Point* begin, const Point* end)
+    {
+        std::unique_lock<std::mutex> lock{mMutex};
+        loadOnce(lock);
+        std::map<std::pair<std::string, std::string>, ColumnType> written;
+        std::string conflicts;
+
+        for (const auto* point = begin; point != end; ++point)
+        {
+            const auto measurement = point->getName();
+            const auto& schema = find(measurement);
+
+            forEachField(point->getFields(), [&](std::string_view field, ColumnType type) {
+                auto declared = schema.fields.find(field);
+                const auto expected = declared != schema.fields.cend()
+                                          ? declared->second
+                                          : written.try_emplace({measurement, std::string{field}}, type).first->second;
+                if (type != expected)
+                {
+                    conflicts += (conflicts.empty() ? "" : ", ") + measurement + "." + std::string{field} + " is " +
+                                 std::string{nameOf(expected)} + ", written as " + std::string{nameOf(type)};
+                }
+            });
+        }
+
+        if (!conflicts.empty())
+        {
+            throw SchemaConflict{"SchemaCache", "Field type conflict: " + conflicts};
+        }
+        for (auto& [key, type] : written)
+        {
+            mMeasurements[key.first].fields.emplace(key.second, type);
+        }
+    }
+
+    void SchemaCache::refresh()
+    {
+        auto measurements = queryAll();
+        std::lock_guard<std::mutex> lock{mMutex};
+        if (measurements)
+        {
+            mMeasurements = std::move(*measurements);
+        }
+        mLoaded = true;
+        mWake.notify_all();
+    }
+
+    void SchemaCache::loadOnce(std::unique_lock<std::mutex>& lock)
+    {
+        if (mLoaded)
+        {
+            return;
+        }
+        if (mLoading)
+        {
+            mWake.wait(lock, [this] { return mLoaded; });
+            return;
+        }
+
+        mLoading = true;
+        lock.unlock();
+        auto measurements = queryAll();
+        lock.lock();
+        mLoading = false;
+        if (!mLoaded)
+        {
+            mMeasurements = std::move(measurements).value_or(Measurements{});
+            mLoaded = true;
+        }
+        mWake.notify_all();
+    }
+
+    const SchemaCache::Measurement& SchemaCache::find(std::string_view measurement)
+    {
+        if (const auto known = mMeasurements.find(measurement); known != mMeasurements.cend())
+        {
+            return known->second;
+        }
+        // Also records measurements which do not exist yet, they are looked up again after the next refresh
+        mRequested.emplace_back(measurement);
+        mWake.notify_all();
+        return mMeasurements.emplace(std::string{measurement}, Measurement{}).first->second;
+    }
+
+    std::optional<SchemaCache::Measurements> SchemaCache::query(const std::string& statements) const
+    {
+        try
+        {
+            Measurements measurements;
+            const auto result = queryResultImpl(&mTransport, statements);
+            for (const auto& statement : result.statements)
+            {
+                for (const auto& series : statement.series)
+                {
+                    // Series are told apart by their columns, CSV responses have no statement ids
+                    const auto* fieldKeys = stringsOf(series, "fieldKey");
+                    const auto* fieldTypes = stringsOf(series, "fieldType");
+                    const auto* tagKeys = stringsOf(series, "tagKey");
+                    const auto* names = stringsOf(series, "name");
+
+                    if (fieldKeys != nullptr && fieldTypes != nullptr)
+                    {
+                        auto& measurement = measurements[series.name];
+                        for (std::size_t i = 0; i < fieldKeys->size(); ++i)
+                        {
+                            if (const auto type = typeOfFieldType((*fieldTypes)[i]); type)
+                            {
+                                measurement.fields.emplace((*fieldKeys)[i], *type);
+                            }
+                        }
+                    }
+                    else if (tagKeys != nullptr)
+                    {
+                        measurements[series.name].tags.assign(tagKeys->cbegin(), tagKeys->cend());
+                    }
+                    else if (names != nullptr && series.name == "measurements")
+                    {
+                        for (const auto name : *names)
+                        {
+                            measurements.try_emplace(std::string{name});
+                        }
+                    }
+                }
+            }
+            return measurements;
+        }
+        catch (const InfluxDBException&)
+        {
+            return std::nullopt;
+        }
+    }
+
+    std::optional<SchemaCache::Measurements> SchemaCache::queryAll() const
+    {
+        return query("SHOW MEASUREMENTS; SHOW FIELD KEYS; SHOW TAG KEYS");
+    }
+
+    SchemaCache::Measurement SchemaCache::queryMeasurement(std::string_view measurement) const
+    {
+        const auto from = quoted(measurement);
+        auto result = query("SHOW FIELD KEYS FROM " + from + "; SHOW TAG KEYS FROM " + from);
+        if (!result)
+        {
+            // Columns are unknown until the next refresh
+            return {};
+        }
+        const auto found = result->find(measurement);
+        return found != result->cend() ? std::move(found->second) : Measurement{};
+    }
+
+    void SchemaCache::refreshPeriodically()
+    {
+        std::unique_lock<std::mutex> lock{mMutex};
+        auto refreshAt = std::chrono::steady_clock::now() + mRefreshInterval;
+        while (true)
+        {
+            mWake.wait_until(lock, refreshAt, [this] { return mStopped || !mRequested.empty(); });
+            if (mStopped)
+            {
+                return;
+            }
+
+            if (!mRequested.empty())
+            {
+                const auto requested = std::move(mRequested);
+                mRequested.clear();
+                lock.unlock();
+                std::vector<Measurement> loaded;
+                for (const auto& measurement : requested)
+                {
+                    loaded.push_back(queryMeasurement(measurement));
+                }
+                lock.lock();
+
+                // Fields recorded from writes in the meantime are kept unless declared otherwise
+                for (std::size_t i = 0; i < requested.size(); ++i)
+                {
+                    auto& measurement = mMeasurements[requested[i]];
+                    for (auto& [name, type] : loaded[i].fields)
+                    {
+                        measurement.fields.insert_or_assign(name, type);
+                    }
+                    measurement.tags = std::move(loaded[i].tags);
+                }
+                continue;
+            }
+
+            refreshAt = std::chrono::steady_clock::now() + mRefreshInterval;
+            // Nothing to refresh before the first use
+            if (!mLoaded)
+            {
+                continue;
+            }
+            lock.unlock();
+            auto measurements = queryAll();
+            lock.lock();
+            if (measurements)
+            {
+                mMeasurements = std::move(*measurements);
+            }
+        }
+    }
+}
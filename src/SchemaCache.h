@@ -0,0 +1,111 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Point.h"
+#include "Query.h"
+#include "Transport.h"
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace influxdb::internal
+{
+    /// Caches the measurements, tag keys and field types of the database of a transport.
+    /// The schema is loaded on first use and reloaded in the background, measurements unknown to the
+    /// cache are loaded in the background once looked up and are unknown until then. Schema queries run
+    /// without holding the lock, lookups never wait for the server after the first load. Failing schema
+    /// queries are not reported, the affected columns are unknown then.
+    class SchemaCache
+    {
+    public:
+        /// \param transport 	transport used for the schema queries, has to outlive the cache
+        /// \param refreshInterval 	interval of reloading the schema in the background
+        SchemaCache(Transport& transport, std::chrono::milliseconds refreshInterval);
+        ~SchemaCache();
+
+        SchemaCache(const SchemaCache&) = delete;
+        SchemaCache& operator=(const SchemaCache&) = delete;
+
+        std::vector<std::string> measurements();
+
+        /// Declaration of a tag or field of a measurement, std::nullopt if unknown
+        std::optional<ColumnSchema> column(std::string_view measurement, std::string_view name);
+
+        /// Lookup of \ref column() to be passed to the query functions
+        const ColumnSchemaLookup& lookup() const;
+
+        /// Checks the field types of the points against the schema. Fields unknown to the schema are
+        /// recorded with the type written, so conflicts between the points are detected too.
+        /// \throw SchemaConflict 	listing the fields of a type differing from the schema; no field is recorded then
+        void check(const std::vector<Point>& points);
+        void check(const Point& point);
+
+        /// Reloads the whole schema
+        void refresh();
+
+    private:
+        struct Measurement
+        {
+            std::map<std::string, ColumnType, std::less<>> fields;
+            std::vector<std::string> tags;
+        };
+
+        using Measurements = std::map<std::string, Measurement, std::less<>>;
+
+        void check(const Point* begin, const Point* end);
+
+        /// Loads the schema on first use, the lock is released while querying; concurrent callers wait for the load
+        void loadOnce(std::unique_lock<std::mutex>& lock);
+
+        /// Returns the measurement, an unknown one is recorded empty and requested from the refresher; requires the lock
+        const Measurement& find(std::string_view measurement);
+
+        /// Runs the SHOW statements, std::nullopt if they fail
+        std::optional<Measurements> query(const std::string& statements) const;
+        std::optional<Measurements> queryAll() const;
+        Measurement queryMeasurement(std::string_view measurement) const;
+        void refreshPeriodically();
+
+        Transport& mTransport;
+        std::chrono::milliseconds mRefreshInterval;
+        ColumnSchemaLookup mLookup;
+        Measurements mMeasurements;
+        bool mLoaded;
+        bool mLoading;
+        std::mutex mMutex;
+
+        /// Measurements to be loaded by the refresher
+        std::vector<std::string> mRequested;
+        bool mStopped;
+        std::condition_variable mWake;
+        std::thread mRefresher;
+    };
+}
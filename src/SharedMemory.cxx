@@ -0,0 +1,74 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SharedMemory.h"
+
+namespace influxdb::transports
+{
+
+SharedMemory::SharedMemory(const std::string& name, std::size_t capacity, bool singleProducer) :
+  mRing(name, capacity, singleProducer)
+{
+}
+
+void SharedMemory::send(std::string &&message)
+{
+  count(mRing.tryWrite(message), message.size());
+}
+
+void SharedMemory::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  std::size_t size{0};
+  for (const auto& buffer : buffers)
+  {
+    size += buffer.size();
+  }
+  count(mRing.tryWrite(buffers), size);
+}
+
+TransportStatistics SharedMemory::sendStatistics() const
+{
+  TransportStatistics statistics;
+  statistics.sentMessages = mSentMessages.load(std::memory_order_relaxed);
+  statistics.droppedMessages = mDroppedMessages.load(std::memory_order_relaxed);
+  statistics.failedMessages = mFailedMessages.load(std::memory_order_relaxed);
+  return statistics;
+}
+
+void SharedMemory::count(bool written, std::size_t size)
+{
+  if (written)
+  {
+    mSentMessages.fetch_add(1, std::memory_order_relaxed);
+  }
+  else if (size > mRing.maxMessageSize())
+  {
+    mFailedMessages.fetch_add(1, std::memory_order_relaxed);
+  }
+  else
+  {
+    mDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+} // namespace influxdb::transports
@@ -0,0 +1,76 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef INFLUXDATA_TRANSPORTS_SHAREDMEMORY_H
+#define INFLUXDATA_TRANSPORTS_SHAREDMEMORY_H
+
+#include "Transport.h"
+#include "SharedRing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace influxdb::transports
+{
+
+/// \brief Shared memory transport writing messages into a ring buffer drained by a co-located reader
+/// (see SharedMemoryReader); writes never block nor make system calls, messages which do not fit into
+/// the free space of the ring are dropped
+class SharedMemory : public Transport
+{
+  public:
+    /// Default size of a new ring
+    static constexpr std::size_t defaultCapacity{16 * 1024 * 1024};
+
+    /// Constructor
+    /// \param name 	name of the shared memory segment, created if it does not exist
+    /// \param capacity 	size of a new ring
+    /// \param singleProducer 	see internal::SharedRing
+    SharedMemory(const std::string& name, std::size_t capacity = defaultCapacity, bool singleProducer = false);
+
+    /// Writes the message into the ring, it is dropped if the ring is full
+    void send(std::string&& message) override;
+
+    /// Writes the buffers into the ring as one message, without joining them first
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    /// Returns the counters of the messages written and dropped; failed messages exceed half the ring size
+    TransportStatistics sendStatistics() const override;
+
+  private:
+    /// Counts the outcome of a write
+    void count(bool written, std::size_t size);
+
+    /// Ring buffer
+    internal::SharedRing mRing;
+
+    /// Counters
+    std::atomic<std::uint64_t> mSentMessages{0};
+    std::atomic<std::uint64_t> mDroppedMessages{0};
+    std::atomic<std::uint64_t> mFailedMessages{0};
+};
+
+} // namespace influxdb::transports
+
+#endif // INFLUXDATA_TRANSPORTS_SHAREDMEMORY_H
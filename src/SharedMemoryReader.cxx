@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SharedMemoryReader.h"
+#include "SharedRing.h"
+#include <algorithm>
+#include <thread>
+
+namespace influxdb
+{
+  namespace
+  {
+    /// Polls spinning before sleeping, a message is usually written soon after the previous one
+    constexpr int spinPolls{1000};
+    constexpr std::chrono::microseconds maxPollInterval{100};
+  }
+
+  SharedMemoryReader::SharedMemoryReader(const std::string& name, std::size_t capacity)
+    : mRing(std::make_unique<internal::SharedRing>(name, capacity))
+  {
+  }
+
+  SharedMemoryReader::~SharedMemoryReader() = default;
+
+  std::size_t SharedMemoryReader::read(const std::function<void(std::string_view)>& onMessage, std::size_t maxMessages)
+  {
+    return mRing->read(onMessage, maxMessages);
+  }
+
+  bool SharedMemoryReader::wait(std::chrono::microseconds timeout)
+  {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (int poll = 0; poll < spinPolls; ++poll)
+    {
+      if (mRing->readable())
+      {
+        return true;
+      }
+    }
+
+    std::chrono::microseconds interval{1};
+    while (!mRing->readable())
+    {
+      const auto now = std::chrono::steady_clock::now();
+      if (now >= deadline)
+      {
+        return false;
+      }
+      std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(interval, deadline - now));
+      interval = std::min(interval * 2, maxPollInterval);
+    }
+    return true;
+  }
+
+  void SharedMemoryReader::remove(const std::string& name)
+  {
+    internal::SharedRing::remove(name);
+  }
+
+} // namespace influxdb
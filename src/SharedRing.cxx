@@ -0,0 +1,394 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SharedRing.h"
+#include "InfluxDBException.h"
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace influxdb::internal
+{
+#ifndef _WIN32
+
+    namespace
+    {
+        /// Marks an initialized ring, "IFXRING" followed by the layout version
+        constexpr std::uint64_t ringMagic{0x49465852494e4701};
+
+        /// Kinds of records, stored in the lowest byte of the record header word
+        constexpr std::uint64_t messageRecord{1};
+        constexpr std::uint64_t paddingRecord{2};
+
+        constexpr std::size_t wordSize{sizeof(std::uint64_t)};
+        constexpr std::size_t minCapacity{4096};
+        constexpr std::uint64_t ringFull{UINT64_MAX};
+
+        /// Number of messages after which the reader frees their space
+        constexpr std::size_t releaseInterval{64};
+
+        /// Time the creator of a segment has to initialize it
+        constexpr std::chrono::seconds initializationTimeout{1};
+
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Atomics in shared memory must be lock-free");
+        static_assert(sizeof(std::atomic<std::uint64_t>) == wordSize);
+
+        std::string segmentName(const std::string& name)
+        {
+            return (!name.empty() && name.front() == '/') ? name : "/" + name;
+        }
+
+        std::size_t alignToWord(std::size_t size)
+        {
+            return (size + wordSize - 1) & ~(wordSize - 1);
+        }
+
+        std::uint64_t recordWord(std::uint64_t size, std::uint64_t kind)
+        {
+            return (size << 8) | kind;
+        }
+
+        std::string systemError(const std::string& what)
+        {
+            return what + ": " + std::strerror(errno);
+        }
+    }
+
+    /// Start of the segment, followed by the data area; positions grow monotonically and are taken
+    /// modulo the capacity, the free space of the data area is zeroed
+    struct SharedRing::Header
+    {
+        std::atomic<std::uint64_t> magic;
+        std::uint64_t capacity;
+
+        /// End of the space reserved by the producers
+        alignas(64) std::atomic<std::uint64_t> tail;
+
+        /// End of the space read by the reader
+        alignas(64) std::atomic<std::uint64_t> head;
+    };
+
+    SharedRing::SharedRing(const std::string& name, std::size_t capacity, bool singleProducer)
+        : mHeader(nullptr), mData(nullptr), mMappedSize(0), mMask(0), mSingleProducer(singleProducer)
+    {
+        const auto path = segmentName(name);
+        std::size_t dataSize{minCapacity};
+        while (dataSize < capacity)
+        {
+            dataSize <<= 1;
+        }
+
+        bool created{true};
+        int fd = ::shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+        if (fd < 0 && errno == EEXIST)
+        {
+            created = false;
+            fd = ::shm_open(path.c_str(), O_RDWR, 0);
+        }
+        if (fd < 0)
+        {
+            throw InfluxDBException(__func__, systemError("Cannot open shared memory " + path));
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + initializationTimeout;
+        if (created)
+        {
+            mMappedSize = sizeof(Header) + dataSize;
+            if (::ftruncate(fd, static_cast<off_t>(mMappedSize)) != 0)
+            {
+                const auto error = systemError("Cannot size shared memory " + path);
+                ::close(fd);
+                ::shm_unlink(path.c_str());
+                throw InfluxDBException(__func__, error);
+            }
+        }
+        else
+        {
+            // The creator may not have sized the segment yet
+            struct stat status{};
+            while (::fstat(fd, &status) == 0 && static_cast<std::size_t>(status.st_size) <= sizeof(Header) &&
+                   std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+            mMappedSize = static_cast<std::size_t>(status.st_size);
+            if (mMappedSize <= sizeof(Header))
+            {
+                ::close(fd);
+                throw InfluxDBException(__func__, "Shared memory " + path + " is not a ring buffer");
+            }
+        }
+
+        // Pages are mapped upfront, writes must not fault on first use of a page
+#ifdef MAP_POPULATE
+        constexpr int mapFlags{MAP_SHARED | MAP_POPULATE};
+#else
+        constexpr int mapFlags{MAP_SHARED};
+#endif
+        void* mapped = ::mmap(nullptr, mMappedSize, PROT_READ | PROT_WRITE, mapFlags, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            throw InfluxDBException(__func__, systemError("Cannot map shared memory " + path));
+        }
+
+        if (created)
+        {
+            mHeader = new (mapped) Header{};
+            mHeader->capacity = dataSize;
+            mHeader->magic.store(ringMagic, std::memory_order_release);
+        }
+        else
+        {
+            mHeader = static_cast<Header*>(mapped);
+            while (mHeader->magic.load(std::memory_order_acquire) != ringMagic && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+            const auto existingCapacity = mHeader->capacity;
+            if (mHeader->magic.load(std::memory_order_acquire) != ringMagic || existingCapacity < minCapacity ||
+                (existingCapacity & (existingCapacity - 1)) != 0 || sizeof(Header) + existingCapacity != mMappedSize)
+            {
+                ::munmap(mapped, mMappedSize);
+                throw InfluxDBException(__func__, "Shared memory " + path + " is not a ring buffer");
+            }
+        }
+        mData = static_cast<char*>(mapped) + sizeof(Header);
+        mMask = mHeader->capacity - 1;
+    }
+
+    SharedRing::~SharedRing()
+    {
+        ::munmap(mHeader, mMappedSize);
+    }
+
+    bool SharedRing::tryWrite(const std::vector<std::string_view>& parts)
+    {
+        std::size_t size{0};
+        for (const auto& part : parts)
+        {
+            size += part.size();
+        }
+        if (size > maxMessageSize())
+        {
+            return false;
+        }
+
+        const auto position = reserve(wordSize + alignToWord(size));
+        if (position == ringFull)
+        {
+            return false;
+        }
+        char* payload = mData + ((position + wordSize) & mMask);
+        for (const auto& part : parts)
+        {
+            std::memcpy(payload, part.data(), part.size());
+            payload += part.size();
+        }
+        word(position).store(recordWord(size, messageRecord), std::memory_order_release);
+        return true;
+    }
+
+    bool SharedRing::tryWrite(std::string_view message)
+    {
+        if (message.size() > maxMessageSize())
+        {
+            return false;
+        }
+
+        const auto position = reserve(wordSize + alignToWord(message.size()));
+        if (position == ringFull)
+        {
+            return false;
+        }
+        std::memcpy(mData + ((position + wordSize) & mMask), message.data(), message.size());
+        word(position).store(recordWord(message.size(), messageRecord), std::memory_order_release);
+        return true;
+    }
+
+    std::size_t SharedRing::read(const std::function<void(std::string_view)>& onMessage, std::size_t maxMessages)
+    {
+        auto head = mHeader->head.load(std::memory_order_relaxed);
+        std::size_t count{0};
+        while (count < maxMessages)
+        {
+            const auto value = word(head).load(std::memory_order_acquire);
+            if (value == 0)
+            {
+                break;
+            }
+
+            const auto size = value >> 8;
+            auto span = size;
+            if ((value & 0xff) == messageRecord)
+            {
+                onMessage(std::string_view{mData + ((head + wordSize) & mMask), size});
+                span = wordSize + alignToWord(size);
+                ++count;
+            }
+
+            // Free space has to be zeroed, a record header may start at any word of it
+            std::memset(mData + (head & mMask), 0, span);
+            head += span;
+            if (count % releaseInterval == 0)
+            {
+                mHeader->head.store(head, std::memory_order_release);
+            }
+        }
+        mHeader->head.store(head, std::memory_order_release);
+        return count;
+    }
+
+    bool SharedRing::readable() const
+    {
+        return word(mHeader->head.load(std::memory_order_relaxed)).load(std::memory_order_acquire) != 0;
+    }
+
+    std::size_t SharedRing::capacity() const
+    {
+        return mMask + 1;
+    }
+
+    std::size_t SharedRing::maxMessageSize() const
+    {
+        // A record and the padding preceding it always fit then
+        return capacity() / 2 - wordSize;
+    }
+
+    void SharedRing::remove(const std::string& name)
+    {
+        ::shm_unlink(segmentName(name).c_str());
+    }
+
+    std::uint64_t SharedRing::reserve(std::size_t recordSize)
+    {
+        const auto capacity = mMask + 1;
+        auto tail = mHeader->tail.load(std::memory_order_relaxed);
+        std::uint64_t padding{0};
+        while (true)
+        {
+            const auto offset = tail & mMask;
+            padding = (offset + recordSize > capacity) ? capacity - offset : 0;
+            const auto end = tail + padding + recordSize;
+            if (end - mCachedHead.load(std::memory_order_acquire) > capacity)
+            {
+                // The head is read only if needed, its cache line is written by the reader
+                const auto head = mHeader->head.load(std::memory_order_acquire);
+                mCachedHead.store(head, std::memory_order_release);
+                if (end - head > capacity)
+                {
+                    return ringFull;
+                }
+            }
+            if (mSingleProducer)
+            {
+                mHeader->tail.store(end, std::memory_order_relaxed);
+                break;
+            }
+            if (mHeader->tail.compare_exchange_weak(tail, end, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+
+        if (padding > 0)
+        {
+            word(tail).store(recordWord(padding, paddingRecord), std::memory_order_release);
+        }
+        return tail + padding;
+    }
+
+    std::atomic<std::uint64_t>& SharedRing::word(std::uint64_t position) const
+    {
+        return *reinterpret_cast<std::atomic<std::uint64_t>*>(mData + (position & mMask));
+    }
+
+#else
+
+    struct SharedRing::Header
+    {
+    };
+
+    SharedRing::SharedRing(const std::string&, std::size_t, bool)
+        : mHeader(nullptr), mData(nullptr), mMappedSize(0), mMask(0), mSingleProducer(false)
+    {
+        throw InfluxDBException(__func__, "Shared memory ring buffer not supported on this system");
+    }
+
+    SharedRing::~SharedRing() = default;
+
+    bool SharedRing::tryWrite(const std::vector<std::string_view>&)
+    {
+        return false;
+    }
+
+    bool SharedRing::tryWrite(std::string_view)
+    {
+        return false;
+    }
+
+    std::size_t SharedRing::read(const std::function<void(std::string_view)>&, std::size_t)
+    {
+        return 0;
+    }
+
+    bool SharedRing::readable() const
+    {
+        return false;
+    }
+
+    std::size_t SharedRing::capacity() const
+    {
+        return 0;
+    }
+
+    std::size_t SharedRing::maxMessageSize() const
+    {
+        return 0;
+    }
+
+    void SharedRing::remove(const std::string&)
+    {
+    }
+
+    std::uint64_t SharedRing::reserve(std::size_t)
+    {
+        return 0;
+    }
+
+    std::atomic<std::uint64_t>& SharedRing::word(std::uint64_t) const
+    {
+        throw InfluxDBException(__func__, "Shared memory ring buffer not supported on this system");
+    }
+
+#endif // _WIN32
+}
@@ -0,0 +1,99 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace influxdb::internal
+{
+    /// \brief Lock-free ring buffer of messages in a POSIX shared memory segment, written by any number
+    /// of producers (of any process) and read by a single reader. Producers never block nor make system
+    /// calls; a message which does not fit into the free space is rejected.
+    class SharedRing
+    {
+    public:
+        /// Opens the ring of the shared memory segment, creating it if it does not exist
+        /// \param name 	name of the segment, prefixed by `/` if missing
+        /// \param capacity 	size of the data area of a new ring, rounded up to a power of two
+        /// \param singleProducer 	reserves space without atomic read-modify-write operations;
+        ///                         the ring must be written by a single thread of a single process then
+        /// \throw InfluxDBException 	if the segment cannot be opened or is not a ring
+        SharedRing(const std::string& name, std::size_t capacity, bool singleProducer = false);
+
+        ~SharedRing();
+
+        SharedRing(const SharedRing&) = delete;
+        SharedRing& operator=(const SharedRing&) = delete;
+
+        /// Writes the parts as one message
+        /// \return false if the ring has not enough free space
+        bool tryWrite(const std::vector<std::string_view>& parts);
+
+        /// Writes a message
+        /// \return false if the ring has not enough free space
+        bool tryWrite(std::string_view message);
+
+        /// Passes the written messages to the handler in order of their reservation, up to the first one
+        /// still being written; each view is valid during the call only
+        /// \return number of messages read
+        std::size_t read(const std::function<void(std::string_view)>& onMessage, std::size_t maxMessages);
+
+        /// Checks whether a written message is ready to be read
+        bool readable() const;
+
+        /// Size of the data area
+        std::size_t capacity() const;
+
+        /// Largest message accepted
+        std::size_t maxMessageSize() const;
+
+        /// Removes the shared memory segment, mappings of it remain valid
+        static void remove(const std::string& name);
+
+    private:
+        struct Header;
+
+        /// Reserves space of a record, writing a padding record if wrapping around
+        /// \return position of the record or UINT64_MAX if full
+        std::uint64_t reserve(std::size_t recordSize);
+
+        /// Record header word at the position
+        std::atomic<std::uint64_t>& word(std::uint64_t position) const;
+
+        Header* mHeader;
+
+        /// Head last read by a producer of this process; the free space is at least as large
+        std::atomic<std::uint64_t> mCachedHead{0};
+
+        char* mData;
+        std::size_t mMappedSize;
+        std::uint64_t mMask;
+        const bool mSingleProducer;
+    };
+}
@@ -0,0 +1,285 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "StreamSocket.h"
+#include "InfluxDBException.h"
+#include <algorithm>
+#include <cerrno>
+#include <exception>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
+
+namespace influxdb::transports
+{
+namespace
+{
+  /// Size up to which messages are coalesced into a segment; larger messages are written without copying
+  constexpr std::size_t segmentSize{256 * 1024};
+
+  /// Maximum number of buffers kept for reuse
+  constexpr std::size_t maxSpareSegments{16};
+}
+
+StreamSocket::StreamSocket(Connector connector) :
+  mConnector(std::move(connector)),
+  mSocket(mIoService),
+  mWriter([this] { writeLoop(); })
+{
+}
+
+StreamSocket::~StreamSocket()
+{
+  {
+    std::lock_guard lock{mMutex};
+    mStopping = true;
+  }
+  mChanged.notify_all();
+  mWriter.join();
+}
+
+void StreamSocket::send(std::string &&message)
+{
+  const auto size = message.size() + 1;
+  std::unique_lock lock{mMutex};
+  waitForSpace(lock, size);
+
+  if (message.size() >= segmentSize)
+  {
+    // Written as is, the separator starts the next segment
+    mPending.push_back(std::move(message));
+    mPending.push_back(takeSegment());
+  }
+  else
+  {
+    segmentFor(size).append(message);
+  }
+  mPending.back().push_back('\n');
+  queued(size);
+}
+
+void StreamSocket::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  std::size_t size{1};
+  for (const auto& buffer : buffers)
+  {
+    size += buffer.size();
+  }
+
+  std::unique_lock lock{mMutex};
+  waitForSpace(lock, size);
+
+  auto& segment = segmentFor(size);
+  for (const auto& buffer : buffers)
+  {
+    segment.append(buffer);
+  }
+  segment.push_back('\n');
+  queued(size);
+}
+
+void StreamSocket::flush()
+{
+  std::unique_lock lock{mMutex};
+  mChanged.wait(lock, [this] { return (mPending.empty() && !mWriting) || mDisconnected; });
+  if (mPendingBytes > 0)
+  {
+    throw InfluxDBException(__func__, "Not connected, " + std::to_string(mPendingBytes) + " bytes pending");
+  }
+}
+
+void StreamSocket::setMaxPendingBytes(std::size_t bytes)
+{
+  std::lock_guard lock{mMutex};
+  mMaxPendingBytes = bytes;
+  mChanged.notify_all();
+}
+
+void StreamSocket::setReconnectBackoff(std::chrono::milliseconds backoff, std::chrono::milliseconds maxBackoff)
+{
+  std::lock_guard lock{mMutex};
+  mReconnectBackoff = backoff;
+  mMaxReconnectBackoff = std::max(backoff, maxBackoff);
+}
+
+void StreamSocket::waitForSpace(std::unique_lock<std::mutex>& lock, std::size_t size)
+{
+  const auto hasSpace = [this, size] { return mPendingBytes == 0 || mPendingBytes + size <= mMaxPendingBytes; };
+  mChanged.wait(lock, [this, &hasSpace] { return hasSpace() || mDisconnected; });
+  if (!hasSpace())
+  {
+    throw InfluxDBException(__func__, "Not connected, " + std::to_string(mPendingBytes) + " bytes pending");
+  }
+}
+
+std::string& StreamSocket::segmentFor(std::size_t size)
+{
+  if (mPending.empty() || mPending.back().size() + size > segmentSize)
+  {
+    mPending.push_back(takeSegment());
+  }
+  return mPending.back();
+}
+
+std::string StreamSocket::takeSegment()
+{
+  if (mSpareSegments.empty())
+  {
+    std::string segment;
+    segment.reserve(segmentSize);
+    return segment;
+  }
+  auto segment = std::move(mSpareSegments.back());
+  mSpareSegments.pop_back();
+  return segment;
+}
+
+void StreamSocket::queued(std::size_t size)
+{
+  mPendingBytes += size;
+  mChanged.notify_all();
+}
+
+void StreamSocket::writeLoop()
+{
+  std::unique_lock lock{mMutex};
+  while (true)
+  {
+    mChanged.wait(lock, [this] { return !mPending.empty() || mStopping; });
+    if (mPending.empty())
+    {
+      return;
+    }
+
+    std::deque<std::string> batch;
+    batch.swap(mPending);
+    const auto batchBytes = mPendingBytes;
+    mWriting = true;
+    const bool written = writeBatch(lock, batch);
+    mWriting = false;
+    mPendingBytes -= batchBytes;
+
+    for (auto& segment : batch)
+    {
+      if (mSpareSegments.size() < maxSpareSegments && segment.capacity() >= segmentSize && segment.capacity() <= 2 * segmentSize)
+      {
+        segment.clear();
+        mSpareSegments.push_back(std::move(segment));
+      }
+    }
+    if (!written)
+    {
+      // Stopped while the connection is down
+      mPending.clear();
+      mPendingBytes = 0;
+    }
+    mChanged.notify_all();
+  }
+}
+
+bool StreamSocket::writeBatch(std::unique_lock<std::mutex>& lock, const std::deque<std::string>& batch)
+{
+  std::vector<boost::asio::const_buffer> buffers;
+  buffers.reserve(batch.size());
+  for (const auto& segment : batch)
+  {
+    if (!segment.empty())
+    {
+      buffers.emplace_back(segment.data(), segment.size());
+    }
+  }
+
+  auto backoff = mReconnectBackoff;
+  while (true)
+  {
+    lock.unlock();
+    if (mSocket.is_open() && peerClosed())
+    {
+      boost::system::error_code ignored;
+      mSocket.close(ignored);
+    }
+    const bool reconnected = !mSocket.is_open();
+    boost::system::error_code error;
+    if (reconnected && !connect())
+    {
+      error = boost::asio::error::not_connected;
+    }
+    if (!error)
+    {
+      boost::asio::write(mSocket, buffers, error);
+    }
+    if (error)
+    {
+      boost::system::error_code ignored;
+      mSocket.close(ignored);
+    }
+    lock.lock();
+
+    if (!error)
+    {
+      mDisconnected = false;
+      return true;
+    }
+    if (!reconnected)
+    {
+      // The connection broke, reconnect immediately
+      continue;
+    }
+
+    mDisconnected = true;
+    mChanged.notify_all();
+    if (mChanged.wait_for(lock, backoff, [this] { return mStopping; }))
+    {
+      return false;
+    }
+    backoff = std::min(backoff * 2, mMaxReconnectBackoff);
+  }
+}
+
+bool StreamSocket::connect()
+{
+  try
+  {
+    mConnector(mSocket);
+    return true;
+  }
+  catch (const std::exception&)
+  {
+    return false;
+  }
+}
+
+bool StreamSocket::peerClosed()
+{
+#if defined(MSG_DONTWAIT)
+  char byte{0};
+  const auto result = ::recv(mSocket.native_handle(), &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+  return result == 0 || (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+#else
+  return false;
+#endif
+}
+
+} // namespace influxdb::transports
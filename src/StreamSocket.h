@@ -0,0 +1,162 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INFLUXDATA_TRANSPORTS_STREAMSOCKET_H
+#define INFLUXDATA_TRANSPORTS_STREAMSOCKET_H
+
+#include "Transport.h"
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace influxdb::transports
+{
+
+/// \brief Stream socket transport keeping a persistent connection, e.g. to a Telegraf socket_listener;
+/// messages are queued, terminated by a newline, and written by a writer thread in batches using
+/// scatter-gather I/O. Messages of a failed write are written again once reconnected (at least once).
+class StreamSocket : public Transport
+{
+  public:
+    /// Socket of any stream protocol
+    using Socket = boost::asio::generic::stream_protocol::socket;
+
+    /// Connects the socket, e.g. resolving the host and setting socket options
+    /// \throw boost::system::system_error 	if the connection fails
+    using Connector = std::function<void(Socket& socket)>;
+
+    /// Default maximum of queued bytes, senders wait once exceeded
+    static constexpr std::size_t defaultMaxPendingBytes{64 * 1024 * 1024};
+
+    /// Default delay of the first reconnection attempt, doubled per failed attempt
+    static constexpr std::chrono::milliseconds defaultReconnectBackoff{100};
+
+    /// Default maximum delay of reconnection attempts
+    static constexpr std::chrono::milliseconds defaultMaxReconnectBackoff{30000};
+
+    /// Constructor, the connection is established by the first write
+    explicit StreamSocket(Connector connector);
+
+    /// Writes the queued messages if connected and closes the connection
+    ~StreamSocket() override;
+
+    /// Queues the message; waits while the queue exceeds the maximum of pending bytes
+    /// \throw InfluxDBException 	if the queue is full and the connection is down
+    void send(std::string&& message) override;
+
+    /// Queues the buffers as one message, copying them into the batch buffer
+    /// \throw InfluxDBException 	if the queue is full and the connection is down
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    /// Waits until the queued messages are written
+    /// \throw InfluxDBException 	if the connection is down
+    void flush() override;
+
+    /// Sets the maximum of queued bytes, senders wait once exceeded (flow control)
+    void setMaxPendingBytes(std::size_t bytes);
+
+    /// Sets the delay of the first reconnection attempt, doubled per failed attempt up to the maximum
+    void setReconnectBackoff(std::chrono::milliseconds backoff, std::chrono::milliseconds maxBackoff);
+
+  private:
+    /// Waits until the queue has space for size bytes
+    /// \throw InfluxDBException 	if the queue is full and the connection is down
+    void waitForSpace(std::unique_lock<std::mutex>& lock, std::size_t size);
+
+    /// Returns the last segment if size bytes can be coalesced into it, a new segment otherwise
+    std::string& segmentFor(std::size_t size);
+
+    /// Takes a buffer for a new segment, reusing the capacity of written segments
+    std::string takeSegment();
+
+    /// Counts the bytes queued and wakes up the writer
+    void queued(std::size_t size);
+
+    /// Writes the queued segments until stopped
+    void writeLoop();
+
+    /// Writes a batch, reconnecting until written
+    /// \return false if stopped while the connection is down
+    bool writeBatch(std::unique_lock<std::mutex>& lock, const std::deque<std::string>& batch);
+
+    /// Connects the socket
+    /// \return false if the connection failed
+    bool connect();
+
+    /// Checks whether the peer closed the connection, which is reported by the first write only after
+    /// it is lost otherwise; receivers are not expected to send data
+    bool peerClosed();
+
+    /// Establishes the connection
+    Connector mConnector;
+
+    /// Boost Asio I/O functionality
+    boost::asio::io_service mIoService;
+
+    /// Stream socket, closed while not connected
+    Socket mSocket;
+
+    /// Guards the members below
+    std::mutex mMutex;
+
+    /// Signals changes of the queue and connection state
+    std::condition_variable mChanged;
+
+    /// Queued messages; small messages are coalesced into the last segment
+    std::deque<std::string> mPending;
+
+    /// Buffers of written segments, reused for new segments
+    std::vector<std::string> mSpareSegments;
+
+    /// Bytes queued or being written
+    std::size_t mPendingBytes{0};
+
+    /// Maximum of queued bytes
+    std::size_t mMaxPendingBytes{defaultMaxPendingBytes};
+
+    /// Reconnection delays
+    std::chrono::milliseconds mReconnectBackoff{defaultReconnectBackoff};
+    std::chrono::milliseconds mMaxReconnectBackoff{defaultMaxReconnectBackoff};
+
+    /// Flag stating whether a batch is being written
+    bool mWriting{false};
+
+    /// Flag stating whether the last connection attempt failed
+    bool mDisconnected{false};
+
+    /// Flag stating whether the writer thread has to stop
+    bool mStopping{false};
+
+    /// Writer thread
+    std::thread mWriter;
+};
+
+} // namespace influxdb::transports
+
+#endif // INFLUXDATA_TRANSPORTS_STREAMSOCKET_H
@@ -0,0 +1,263 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Tee.h"
+#include "DeliveryErrors.h"
+#include "InfluxDBException.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace influxdb::transports
+{
+
+/// \brief Child transport with its queue and sending thread
+class Tee::Child
+{
+  public:
+    Child(std::unique_ptr<Transport> transport, const ChildOptions& options) :
+      mTransport(std::move(transport)), mOptions(options), mThread([this] { run(); })
+    {
+    }
+
+    ~Child()
+    {
+      {
+        std::lock_guard<std::mutex> lock{mMutex};
+        mStopping = true;
+      }
+      mChanged.notify_all();
+      mThread.join();
+    }
+
+    Child(const Child&) = delete;
+    Child& operator=(const Child&) = delete;
+
+    void post(const std::shared_ptr<const std::string>& message)
+    {
+      {
+        std::lock_guard<std::mutex> lock{mMutex};
+        if (mQueue.size() >= mOptions.queueSize)
+        {
+          ++mDroppedMessages;
+          return;
+        }
+        mQueue.push_back(message);
+      }
+      mChanged.notify_all();
+    }
+
+    /// Waits until the queue is sent, the thread is idle then as long as nothing is posted
+    void waitUntilIdle()
+    {
+      std::unique_lock<std::mutex> lock{mMutex};
+      mChanged.wait(lock, [this] { return mQueue.empty() && !mBusy; });
+    }
+
+    Transport& transport() const
+    {
+      return *mTransport;
+    }
+
+    TransportStatistics statistics() const
+    {
+      TransportStatistics statistics;
+      statistics.sentMessages = mSentMessages.load(std::memory_order_relaxed);
+      statistics.droppedMessages = mDroppedMessages.load(std::memory_order_relaxed);
+      statistics.failedMessages = mFailedMessages.load(std::memory_order_relaxed);
+      return statistics;
+    }
+
+  private:
+    void run()
+    {
+      std::unique_lock<std::mutex> lock{mMutex};
+      for (;;)
+      {
+        mChanged.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+        if (mQueue.empty())
+        {
+          return;
+        }
+        const auto message = std::move(mQueue.front());
+        mQueue.pop_front();
+        mBusy = true;
+
+        lock.unlock();
+        send(*message);
+        lock.lock();
+
+        mBusy = false;
+        mChanged.notify_all();
+      }
+    }
+
+    /// Sends the message, retrying with exponential backoff unless stopping or the error is permanent
+    void send(std::string_view message)
+    {
+      auto backoff = mOptions.retryBackoff;
+      for (std::size_t attempt = 0;; ++attempt)
+      {
+        try
+        {
+          // Transports supporting it send the shared message without copying
+          mTransport->sendBuffers({message});
+          ++mSentMessages;
+          return;
+        }
+        catch (const std::exception& e)
+        {
+          // Resending a partially written message would duplicate the lines written
+          if (attempt == mOptions.maxRetries || internal::isPermanentError(e))
+          {
+            ++mFailedMessages;
+            return;
+          }
+        }
+
+        std::unique_lock<std::mutex> lock{mMutex};
+        if (mChanged.wait_for(lock, backoff, [this] { return mStopping; }))
+        {
+          // Retries must not delay the destruction
+          ++mFailedMessages;
+          return;
+        }
+        backoff *= 2;
+      }
+    }
+
+    std::unique_ptr<Transport> mTransport;
+    const ChildOptions mOptions;
+
+    std::deque<std::shared_ptr<const std::string>> mQueue;
+    bool mBusy{false};
+    bool mStopping{false};
+    mutable std::mutex mMutex;
+
+    /// Signals posted messages and stopping to the thread, idleness to waitUntilIdle()
+    std::condition_variable mChanged;
+
+    std::atomic<std::uint64_t> mSentMessages{0};
+    std::atomic<std::uint64_t> mDroppedMessages{0};
+    std::atomic<std::uint64_t> mFailedMessages{0};
+
+    std::thread mThread;
+};
+
+Tee::Tee() = default;
+
+Tee::~Tee() = default;
+
+void Tee::add(std::unique_ptr<Transport> transport, const ChildOptions& options)
+{
+  if (transport == nullptr)
+  {
+    throw InfluxDBException{__func__, "Transport must not be nullptr"};
+  }
+  mChildren.push_back(std::make_unique<Child>(std::move(transport), options));
+}
+
+void Tee::send(std::string&& message)
+{
+  const auto shared = std::make_shared<const std::string>(std::move(message));
+  for (const auto& child : mChildren)
+  {
+    child->post(shared);
+  }
+}
+
+std::string Tee::query(const std::string& query)
+{
+  return primary().query(query);
+}
+
+void Tee::queryChunked(const std::string& query, const std::function<void(std::string_view)>& onChunk)
+{
+  primary().queryChunked(query, onChunk);
+}
+
+void Tee::queryCancellable(const std::string& query, const std::function<void(std::string_view)>& onChunk,
+                           const std::function<bool()>& isCancelled)
+{
+  primary().queryCancellable(query, onChunk, isCancelled);
+}
+
+void Tee::setRejectedLinesHandler(RejectedLinesHandler handler)
+{
+  for (const auto& child : mChildren)
+  {
+    child->waitUntilIdle();
+    child->transport().setRejectedLinesHandler(handler);
+  }
+}
+
+void Tee::flush()
+{
+  for (const auto& child : mChildren)
+  {
+    child->waitUntilIdle();
+    child->transport().flush();
+  }
+}
+
+TransportStatistics Tee::sendStatistics() const
+{
+  TransportStatistics sum;
+  for (const auto& child : mChildren)
+  {
+    const auto statistics = child->statistics();
+    sum.sentMessages += statistics.sentMessages;
+    sum.droppedMessages += statistics.droppedMessages;
+    sum.failedMessages += statistics.failedMessages;
+  }
+  return sum;
+}
+
+TransportStatistics Tee::childStatistics(std::size_t index) const
+{
+  if (index >= mChildren.size())
+  {
+    throw InfluxDBException{__func__, "No child transport " + std::to_string(index)};
+  }
+  return mChildren[index]->statistics();
+}
+
+void Tee::createDatabase()
+{
+  primary().createDatabase();
+}
+
+Transport& Tee::primary() const
+{
+  if (mChildren.empty())
+  {
+    throw InfluxDBException{"Tee", "No child transport"};
+  }
+  return mChildren.front()->transport();
+}
+
+} // namespace influxdb::transports
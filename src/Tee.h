@@ -0,0 +1,104 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef INFLUXDATA_TRANSPORTS_TEE_H
+#define INFLUXDATA_TRANSPORTS_TEE_H
+
+#include "Transport.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace influxdb::transports
+{
+
+/// \brief Fan-out transport sending each message to all child transports, e.g. to dual-write during
+/// a migration; every child sends on its own thread from its own queue, retries failed sends unless
+/// the error is permanent (see internal::isPermanentError) and drops messages if its queue is full,
+/// so a slow or failing child never delays the others.
+/// Queries are sent to the first child.
+class Tee : public Transport
+{
+  public:
+    /// Sending of a child
+    struct ChildOptions
+    {
+        /// Maximum number of queued messages, further messages are dropped
+        std::size_t queueSize{8192};
+
+        /// Number of retries of a failed send
+        std::size_t maxRetries{3};
+
+        /// Delay of the first retry, doubled per retry
+        std::chrono::milliseconds retryBackoff{100};
+    };
+
+    Tee();
+
+    /// Sends the queued messages and stops the threads; retries are not delayed
+    ~Tee() override;
+
+    Tee(const Tee&) = delete;
+    Tee& operator=(const Tee&) = delete;
+
+    /// Adds a child, the first one added receives the queries
+    void add(std::unique_ptr<Transport> transport, const ChildOptions& options);
+
+    /// Queues the message for every child, it is shared and not copied per child
+    void send(std::string&& message) override;
+
+    /// Queries the first child
+    std::string query(const std::string& query) override;
+
+    void queryChunked(const std::string& query, const std::function<void(std::string_view)>& onChunk) override;
+
+    void queryCancellable(const std::string& query, const std::function<void(std::string_view)>& onChunk,
+                          const std::function<bool()>& isCancelled) override;
+
+    /// Sets the handler of all children, it is called on their threads
+    void setRejectedLinesHandler(RejectedLinesHandler handler) override;
+
+    /// Waits until every child sent its queue, then flushes the children
+    void flush() override;
+
+    /// Returns the counters summed over the children
+    TransportStatistics sendStatistics() const override;
+
+    /// Returns the counters of a child; failed messages exhausted their retries or failed permanently
+    TransportStatistics childStatistics(std::size_t index) const;
+
+    /// Creates the database via the first child
+    void createDatabase() override;
+
+  private:
+    class Child;
+
+    Transport& primary() const;
+
+    std::vector<std::unique_ptr<Child>> mChildren;
+};
+
+} // namespace influxdb::transports
+
+#endif // INFLUXDATA_TRANSPORTS_TEE_H
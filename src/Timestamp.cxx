@@ -0,0 +1,147 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Timestamp.h"
+
+namespace influxdb::internal
+{
+    namespace
+    {
+        /// Reads a fixed number of digits at the position
+        bool readDigits(std::string_view text, std::size_t position, std::size_t count, int& value)
+        {
+            if (position + count > text.size())
+            {
+                return false;
+            }
+            value = 0;
+            for (std::size_t i = position; i < position + count; ++i)
+            {
+                if (text[i] < '0' || text[i] > '9')
+                {
+                    return false;
+                }
+                value = value * 10 + (text[i] - '0');
+            }
+            return true;
+        }
+
+        bool isLeapYear(int year)
+        {
+            return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        }
+
+        int daysInMonth(int year, int month)
+        {
+            static constexpr int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+            return (month == 2 && isLeapYear(year)) ? 29 : days[month - 1];
+        }
+
+        /// Days since 1970-01-01 of a date of the proleptic Gregorian calendar
+        long long daysFromCivil(int year, int month, int day)
+        {
+            const int y = year - (month <= 2 ? 1 : 0);
+            const int era = (y >= 0 ? y : y - 399) / 400;
+            const int yearOfEra = y - era * 400;
+            const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+            return era * 146097LL + dayOfEra - 719468;
+        }
+    }
+
+    std::optional<std::chrono::system_clock::time_point> parseRfc3339(std::string_view text)
+    {
+        // YYYY-MM-DDTHH:MM:SS[.fraction](Z|+HH:MM|-HH:MM)
+        constexpr std::size_t minimumLength{20};
+        if (text.size() < minimumLength)
+        {
+            return std::nullopt;
+        }
+
+        int year{0};
+        int month{0};
+        int day{0};
+        int hour{0};
+        int minute{0};
+        int second{0};
+        if (!readDigits(text, 0, 4, year) || text[4] != '-' || !readDigits(text, 5, 2, month) || text[7] != '-' ||
+            !readDigits(text, 8, 2, day) || (text[10] != 'T' && text[10] != 't' && text[10] != ' ') ||
+            !readDigits(text, 11, 2, hour) || text[13] != ':' || !readDigits(text, 14, 2, minute) || text[16] != ':' ||
+            !readDigits(text, 17, 2, second))
+        {
+            return std::nullopt;
+        }
+        if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month) || hour > 23 || minute > 59 || second > 60)
+        {
+            return std::nullopt;
+        }
+
+        std::size_t position{19};
+        long long nanoseconds{0};
+        if (position < text.size() && text[position] == '.')
+        {
+            const auto begin = ++position;
+            long long scale{100000000};
+            for (; position < text.size() && text[position] >= '0' && text[position] <= '9'; ++position)
+            {
+                // Digits beyond nanoseconds are truncated
+                nanoseconds += (text[position] - '0') * scale;
+                scale /= 10;
+            }
+            if (position == begin)
+            {
+                return std::nullopt;
+            }
+        }
+
+        int offsetMinutes{0};
+        if (position < text.size() && (text[position] == 'Z' || text[position] == 'z'))
+        {
+            ++position;
+        }
+        else if (position < text.size() && (text[position] == '+' || text[position] == '-'))
+        {
+            int offsetHours{0};
+            int offsetRemainder{0};
+            if (!readDigits(text, position + 1, 2, offsetHours) || position + 3 >= text.size() || text[position + 3] != ':' ||
+                !readDigits(text, position + 4, 2, offsetRemainder) || offsetHours > 23 || offsetRemainder > 59)
+            {
+                return std::nullopt;
+            }
+            offsetMinutes = (text[position] == '+' ? 1 : -1) * (offsetHours * 60 + offsetRemainder);
+            position += 6;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+        if (position != text.size())
+        {
+            return std::nullopt;
+        }
+
+        const auto seconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + (minute - offsetMinutes) * 60 + second;
+        return std::chrono::system_clock::time_point{
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::seconds{seconds} + std::chrono::nanoseconds{nanoseconds})};
+    }
+}
@@ -0,0 +1,101 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "TransportDecorator.h"
+#include "InfluxDBException.h"
+#include <utility>
+
+namespace influxdb::transports
+{
+
+TransportDecorator::TransportDecorator(std::unique_ptr<Transport> next) :
+  mNext(std::move(next))
+{
+  if (mNext == nullptr)
+  {
+    throw InfluxDBException{__func__, "Transport must not be nullptr"};
+  }
+}
+
+void TransportDecorator::send(std::string&& message)
+{
+  mNext->send(std::move(message));
+}
+
+void TransportDecorator::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  mNext->sendBuffers(buffers);
+}
+
+void TransportDecorator::sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer)
+{
+  mNext->sendStream(producer);
+}
+
+void TransportDecorator::sendEncoded(std::string_view body, std::string_view contentEncoding)
+{
+  mNext->sendEncoded(body, contentEncoding);
+}
+
+std::string TransportDecorator::query(const std::string& query)
+{
+  return mNext->query(query);
+}
+
+void TransportDecorator::queryChunked(const std::string& query, const std::function<void(std::string_view)>& onChunk)
+{
+  mNext->queryChunked(query, onChunk);
+}
+
+void TransportDecorator::queryCancellable(const std::string& query, const std::function<void(std::string_view)>& onChunk,
+                                          const std::function<bool()>& isCancelled)
+{
+  mNext->queryCancellable(query, onChunk, isCancelled);
+}
+
+void TransportDecorator::setRejectedLinesHandler(RejectedLinesHandler handler)
+{
+  mNext->setRejectedLinesHandler(std::move(handler));
+}
+
+void TransportDecorator::flush()
+{
+  mNext->flush();
+}
+
+TransportStatistics TransportDecorator::sendStatistics() const
+{
+  return mNext->sendStatistics();
+}
+
+void TransportDecorator::createDatabase()
+{
+  mNext->createDatabase();
+}
+
+Transport& TransportDecorator::next() const
+{
+  return *mNext;
+}
+
+} // namespace influxdb::transports
@@ -0,0 +1,75 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef INFLUXDATA_TRANSPORTS_TRANSPORTDECORATOR_H
+#define INFLUXDATA_TRANSPORTS_TRANSPORTDECORATOR_H
+
+#include "Transport.h"
+
+#include <memory>
+
+namespace influxdb::transports
+{
+
+/// \brief Transport adding a capability to the transport it wraps, forwarding all calls by default;
+/// InfluxDBFactory stacks decorators for the options given only, a capability not configured costs nothing
+class TransportDecorator : public Transport
+{
+  public:
+    /// \throw InfluxDBException 	if next is nullptr
+    explicit TransportDecorator(std::unique_ptr<Transport> next);
+
+    void send(std::string&& message) override;
+
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    void sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer) override;
+
+    void sendEncoded(std::string_view body, std::string_view contentEncoding) override;
+
+    std::string query(const std::string& query) override;
+
+    void queryChunked(const std::string& query, const std::function<void(std::string_view)>& onChunk) override;
+
+    void queryCancellable(const std::string& query, const std::function<void(std::string_view)>& onChunk,
+                          const std::function<bool()>& isCancelled) override;
+
+    void setRejectedLinesHandler(RejectedLinesHandler handler) override;
+
+    void flush() override;
+
+    TransportStatistics sendStatistics() const override;
+
+    void createDatabase() override;
+
+  protected:
+    /// Wrapped transport
+    Transport& next() const;
+
+  private:
+    std::unique_ptr<Transport> mNext;
+};
+
+} // namespace influxdb::transports
+
+#endif // INFLUXDATA_TRANSPORTS_TRANSPORTDECORATOR_H
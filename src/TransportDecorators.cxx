@@ -0,0 +1,578 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "TransportDecorators.h"
+#include "DeliveryErrors.h"
+#include "InfluxDBException.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <utility>
+
+#ifdef INFLUXCXX_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace influxdb::transports
+{
+
+namespace
+{
+  std::size_t totalSize(const std::vector<std::string_view>& buffers)
+  {
+    std::size_t size{0};
+    for (const auto& buffer : buffers)
+    {
+      size += buffer.size();
+    }
+    return size;
+  }
+
+  std::string join(const std::vector<std::string_view>& buffers)
+  {
+    std::string message;
+    message.reserve(totalSize(buffers));
+    for (const auto& buffer : buffers)
+    {
+      message.append(buffer);
+    }
+    return message;
+  }
+}
+
+
+Retry::Retry(std::unique_ptr<Transport> next, std::size_t maxRetries, std::chrono::milliseconds backoff) :
+  TransportDecorator(std::move(next)), mMaxRetries(maxRetries), mBackoff(backoff)
+{
+}
+
+template <class Send>
+void Retry::retried(Send&& send)
+{
+  auto backoff = mBackoff;
+  for (std::size_t attempt = 0;; ++attempt)
+  {
+    try
+    {
+      send();
+      return;
+    }
+    catch (const InfluxDBException& e)
+    {
+      if (attempt == mMaxRetries || internal::isPermanentError(e))
+      {
+        throw;
+      }
+    }
+    std::this_thread::sleep_for(backoff);
+    backoff *= 2;
+  }
+}
+
+void Retry::send(std::string&& message)
+{
+  // The message is kept for retries, transports gathering buffers send it without copying
+  retried([this, &message] { next().sendBuffers({message}); });
+}
+
+void Retry::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  retried([this, &buffers] { next().sendBuffers(buffers); });
+}
+
+void Retry::sendEncoded(std::string_view body, std::string_view contentEncoding)
+{
+  retried([this, body, contentEncoding] { next().sendEncoded(body, contentEncoding); });
+}
+
+
+Metrics::Metrics(std::unique_ptr<Transport> next) :
+  TransportDecorator(std::move(next))
+{
+}
+
+template <class Send>
+void Metrics::counted(std::size_t bytes, Send&& send)
+{
+  try
+  {
+    send();
+  }
+  catch (...)
+  {
+    mFailedWrites.fetch_add(1, std::memory_order_relaxed);
+    throw;
+  }
+  mWrittenMessages.fetch_add(1, std::memory_order_relaxed);
+  mSentBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Metrics::send(std::string&& message)
+{
+  const auto size = message.size();
+  counted(size, [this, &message] { next().send(std::move(message)); });
+}
+
+void Metrics::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  counted(totalSize(buffers), [this, &buffers] { next().sendBuffers(buffers); });
+}
+
+void Metrics::sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer)
+{
+  std::size_t size{0};
+  const auto counting = [&producer, &size](char* buffer, std::size_t capacity) {
+    const auto written = producer(buffer, capacity);
+    size += written;
+    return written;
+  };
+  try
+  {
+    next().sendStream(counting);
+  }
+  catch (...)
+  {
+    mFailedWrites.fetch_add(1, std::memory_order_relaxed);
+    throw;
+  }
+  mWrittenMessages.fetch_add(1, std::memory_order_relaxed);
+  mSentBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void Metrics::sendEncoded(std::string_view body, std::string_view contentEncoding)
+{
+  counted(body.size(), [this, body, contentEncoding] { next().sendEncoded(body, contentEncoding); });
+}
+
+TransportStatistics Metrics::sendStatistics() const
+{
+  TransportStatistics statistics;
+  try
+  {
+    statistics = next().sendStatistics();
+  }
+  catch (const InfluxDBException&)
+  {
+    // The wrapped transport has no statistics
+  }
+  statistics.writtenMessages = mWrittenMessages.load(std::memory_order_relaxed);
+  statistics.sentBytes = mSentBytes.load(std::memory_order_relaxed);
+  statistics.failedWrites = mFailedWrites.load(std::memory_order_relaxed);
+  return statistics;
+}
+
+
+RateLimit::RateLimit(std::unique_ptr<Transport> next, std::size_t bytesPerSecond) :
+  TransportDecorator(std::move(next)), mBytesPerSecond(static_cast<double>(bytesPerSecond)), mTokens(mBytesPerSecond),
+  mRefilled(std::chrono::steady_clock::now())
+{
+  if (bytesPerSecond == 0)
+  {
+    throw InfluxDBException{__func__, "Rate limit must be positive"};
+  }
+}
+
+void RateLimit::acquire(std::size_t bytes)
+{
+  const auto now = std::chrono::steady_clock::now();
+  const auto elapsed = std::chrono::duration<double>(now - mRefilled).count();
+  mRefilled = now;
+  // The bucket holds one second of the rate, messages larger than that are sent in debt
+  mTokens = std::min(mBytesPerSecond, mTokens + elapsed * mBytesPerSecond) - static_cast<double>(bytes);
+  if (mTokens < 0)
+  {
+    std::this_thread::sleep_for(std::chrono::duration<double>(-mTokens / mBytesPerSecond));
+  }
+}
+
+void RateLimit::send(std::string&& message)
+{
+  acquire(message.size());
+  next().send(std::move(message));
+}
+
+void RateLimit::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  acquire(totalSize(buffers));
+  next().sendBuffers(buffers);
+}
+
+void RateLimit::sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer)
+{
+  next().sendStream([this, &producer](char* buffer, std::size_t size) {
+    const auto written = producer(buffer, size);
+    acquire(written);
+    return written;
+  });
+}
+
+void RateLimit::sendEncoded(std::string_view body, std::string_view contentEncoding)
+{
+  acquire(body.size());
+  next().sendEncoded(body, contentEncoding);
+}
+
+
+Splitter::Splitter(std::unique_ptr<Transport> next, std::size_t maxMessageSize) :
+  TransportDecorator(std::move(next)), mMaxMessageSize(maxMessageSize)
+{
+  if (maxMessageSize == 0)
+  {
+    throw InfluxDBException{__func__, "Maximum message size must be positive"};
+  }
+}
+
+void Splitter::send(std::string&& message)
+{
+  if (message.size() <= mMaxMessageSize)
+  {
+    next().send(std::move(message));
+    return;
+  }
+  sendSplit(message);
+}
+
+void Splitter::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  if (totalSize(buffers) <= mMaxMessageSize)
+  {
+    next().sendBuffers(buffers);
+    return;
+  }
+  sendSplit(join(buffers));
+}
+
+void Splitter::sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer)
+{
+  Transport::sendStream(producer);
+}
+
+void Splitter::sendSplit(std::string_view message)
+{
+  // Parts and oversize lines are sent in message order, points of the same series and timestamp are
+  // written last wins
+  std::size_t partBegin{0};
+  std::size_t partEnd{0};
+  const auto sendPart = [&] {
+    if (partEnd > partBegin)
+    {
+      next().sendBuffers({message.substr(partBegin, partEnd - partBegin)});
+    }
+  };
+
+  for (std::size_t pos = 0; pos < message.size();)
+  {
+    const auto lineEnd = std::min(message.find('\n', pos), message.size());
+    if (lineEnd == pos)
+    {
+      ++pos;
+      continue;
+    }
+    if (lineEnd - pos > mMaxMessageSize)
+    {
+      // Sent alone, the next transport decides about lines it cannot take
+      sendPart();
+      next().sendBuffers({message.substr(pos, lineEnd - pos)});
+      partBegin = partEnd = lineEnd;
+    }
+    else if (partEnd == partBegin || lineEnd - partBegin > mMaxMessageSize)
+    {
+      sendPart();
+      partBegin = pos;
+      partEnd = lineEnd;
+    }
+    else
+    {
+      partEnd = lineEnd;
+    }
+    pos = lineEnd + 1;
+  }
+  sendPart();
+}
+
+
+Spool::Spool(std::unique_ptr<Transport> next, const std::string& path, std::size_t maxBytes, std::chrono::milliseconds retryInterval) :
+  TransportDecorator(std::move(next)), mPath(path), mMaxBytes(maxBytes), mRetryInterval(retryInterval), mSpooledBytes(0),
+  mRetryAt(std::chrono::steady_clock::now())
+{
+  std::ifstream file{mPath, std::ios::binary | std::ios::ate};
+  if (file.is_open())
+  {
+    mSpooledBytes = static_cast<std::uint64_t>(file.tellg());
+  }
+}
+
+void Spool::send(std::string&& message)
+{
+  sendBuffers({message});
+}
+
+void Spool::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  // Messages are spooled while older ones are, their order is kept
+  if (!sendSpooled(false))
+  {
+    spool(buffers);
+    return;
+  }
+  try
+  {
+    next().sendBuffers(buffers);
+  }
+  catch (const InfluxDBException& e)
+  {
+    if (internal::isPermanentError(e))
+    {
+      throw;
+    }
+    failed();
+    spool(buffers);
+  }
+}
+
+void Spool::sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer)
+{
+  Transport::sendStream(producer);
+}
+
+void Spool::flush()
+{
+  sendSpooled(true);
+  next().flush();
+}
+
+TransportStatistics Spool::sendStatistics() const
+{
+  TransportStatistics statistics;
+  try
+  {
+    statistics = next().sendStatistics();
+  }
+  catch (const InfluxDBException&)
+  {
+    // The wrapped transport has no statistics
+  }
+  statistics.droppedMessages += mDroppedMessages.load(std::memory_order_relaxed);
+  return statistics;
+}
+
+bool Spool::sendSpooled(bool force)
+{
+  if (mSpooledBytes == 0)
+  {
+    return true;
+  }
+  if (!force && std::chrono::steady_clock::now() < mRetryAt)
+  {
+    return false;
+  }
+
+  // Records are the message size followed by the message, they are read one at a time
+  std::ifstream file{mPath, std::ios::binary};
+  std::uint64_t offset{0};
+  std::string message;
+  bool sent{true};
+  while (offset < mSpooledBytes)
+  {
+    std::uint64_t size{0};
+    const bool valid = file.read(reinterpret_cast<char*>(&size), sizeof(size)) && size <= mMaxBytes &&
+                       sizeof(size) + size <= mSpooledBytes - offset &&
+                       file.read(message.assign(size, '\0').data(), static_cast<std::streamsize>(size));
+    if (!valid)
+    {
+      // Torn or corrupt record, e.g. of a crash while spooling; the rest of the spool is lost
+      mDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+      offset = mSpooledBytes;
+      break;
+    }
+
+    try
+    {
+      next().sendBuffers({message});
+    }
+    catch (const InfluxDBException& e)
+    {
+      if (!internal::isPermanentError(e))
+      {
+        sent = false;
+        break;
+      }
+      // The server will never accept the message
+      mDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+    }
+    offset += sizeof(size) + size;
+  }
+  file.close();
+
+  if (sent)
+  {
+    std::remove(mPath.c_str());
+    mSpooledBytes = 0;
+    return true;
+  }
+  failed();
+  if (offset > 0)
+  {
+    keepFrom(offset);
+  }
+  return false;
+}
+
+void Spool::keepFrom(std::uint64_t offset)
+{
+  // The spool is replaced once the rest is written, a crash meanwhile keeps the whole spool
+  const auto partial = mPath + ".tmp";
+  {
+    std::ifstream file{mPath, std::ios::binary};
+    file.seekg(static_cast<std::streamoff>(offset));
+    std::ofstream rest{partial, std::ios::binary | std::ios::trunc};
+    rest << file.rdbuf();
+    rest.flush();
+    if (!file || !rest)
+    {
+      // The sent messages are sent again by the next attempt
+      std::remove(partial.c_str());
+      return;
+    }
+  }
+  if (std::rename(partial.c_str(), mPath.c_str()) != 0)
+  {
+    std::remove(partial.c_str());
+    return;
+  }
+  mSpooledBytes -= offset;
+}
+
+void Spool::spool(const std::vector<std::string_view>& buffers)
+{
+  const std::uint64_t size{totalSize(buffers)};
+  if (mSpooledBytes + sizeof(size) + size > mMaxBytes)
+  {
+    mDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  std::ofstream file{mPath, std::ios::binary | std::ios::app};
+  file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  for (const auto& buffer : buffers)
+  {
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  }
+  file.flush();
+  if (!file)
+  {
+    throw InfluxDBException{__func__, "Cannot write spool file " + mPath};
+  }
+  mSpooledBytes += sizeof(size) + size;
+}
+
+void Spool::failed()
+{
+  mRetryAt = std::chrono::steady_clock::now() + mRetryInterval;
+}
+
+
+#ifdef INFLUXCXX_WITH_ZLIB
+
+struct Compression::Deflater
+{
+  z_stream stream{};
+  std::string output;
+};
+
+Compression::Compression(std::unique_ptr<Transport> next, int level) :
+  TransportDecorator(std::move(next)), mDeflater(std::make_unique<Deflater>())
+{
+  // Window bits beyond 15 select the gzip format
+  constexpr int gzipWindowBits{15 + 16};
+  constexpr int memoryLevel{8};
+  if (level < 1 || level > 9 ||
+      deflateInit2(&mDeflater->stream, level, Z_DEFLATED, gzipWindowBits, memoryLevel, Z_DEFAULT_STRATEGY) != Z_OK)
+  {
+    throw InfluxDBException{__func__, "Invalid compression level: " + std::to_string(level)};
+  }
+}
+
+Compression::~Compression()
+{
+  deflateEnd(&mDeflater->stream);
+}
+
+void Compression::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  z_stream& stream = mDeflater->stream;
+  std::string& output = mDeflater->output;
+  deflateReset(&stream);
+  output.resize(deflateBound(&stream, static_cast<uLong>(totalSize(buffers))));
+
+  stream.next_out = reinterpret_cast<Bytef*>(output.data());
+  stream.avail_out = static_cast<uInt>(output.size());
+  for (const auto& buffer : buffers)
+  {
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(buffer.data()));
+    stream.avail_in = static_cast<uInt>(buffer.size());
+    if (deflate(&stream, Z_NO_FLUSH) == Z_STREAM_ERROR)
+    {
+      throw InfluxDBException{__func__, "Compression failed"};
+    }
+  }
+  if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+  {
+    throw InfluxDBException{__func__, "Compression failed"};
+  }
+  next().sendEncoded({output.data(), static_cast<std::size_t>(stream.total_out)}, "gzip");
+}
+
+#else
+
+struct Compression::Deflater
+{
+};
+
+Compression::Compression(std::unique_ptr<Transport> next, int) :
+  TransportDecorator(std::move(next))
+{
+  throw InfluxDBException{__func__, "Compression requires zlib"};
+}
+
+Compression::~Compression() = default;
+
+void Compression::sendBuffers(const std::vector<std::string_view>&)
+{
+}
+
+#endif // INFLUXCXX_WITH_ZLIB
+
+void Compression::send(std::string&& message)
+{
+  sendBuffers({message});
+}
+
+void Compression::sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer)
+{
+  Transport::sendStream(producer);
+}
+
+} // namespace influxdb::transports
@@ -0,0 +1,211 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef INFLUXDATA_TRANSPORTS_TRANSPORTDECORATORS_H
+#define INFLUXDATA_TRANSPORTS_TRANSPORTDECORATORS_H
+
+#include "TransportDecorator.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace influxdb::transports
+{
+
+/// \brief Retries failed sends with exponential backoff; permanent errors, e.g. bad requests, are
+/// not retried (see internal::isPermanentError). Streams are not retried as their data is consumed.
+class Retry : public TransportDecorator
+{
+  public:
+    Retry(std::unique_ptr<Transport> next, std::size_t maxRetries, std::chrono::milliseconds backoff);
+
+    void send(std::string&& message) override;
+
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    void sendEncoded(std::string_view body, std::string_view contentEncoding) override;
+
+  private:
+    /// Calls send until it succeeds, the retries are exhausted or it fails permanently
+    template <class Send>
+    void retried(Send&& send);
+
+    const std::size_t mMaxRetries;
+    const std::chrono::milliseconds mBackoff;
+};
+
+/// \brief Counts the messages and bytes sent and the failed sends; the statistics of the wrapped
+/// transport are extended by these counts if it has any, its own counts are kept
+class Metrics : public TransportDecorator
+{
+  public:
+    explicit Metrics(std::unique_ptr<Transport> next);
+
+    void send(std::string&& message) override;
+
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    void sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer) override;
+
+    void sendEncoded(std::string_view body, std::string_view contentEncoding) override;
+
+    TransportStatistics sendStatistics() const override;
+
+  private:
+    /// Counts the outcome of send, exceptions are passed on
+    template <class Send>
+    void counted(std::size_t bytes, Send&& send);
+
+    std::atomic<std::uint64_t> mWrittenMessages{0};
+    std::atomic<std::uint64_t> mSentBytes{0};
+    std::atomic<std::uint64_t> mFailedWrites{0};
+};
+
+/// \brief Limits the rate of bytes sent by a token bucket holding one second of the rate; a sender
+/// exceeding it waits until the bucket is refilled
+class RateLimit : public TransportDecorator
+{
+  public:
+    RateLimit(std::unique_ptr<Transport> next, std::size_t bytesPerSecond);
+
+    void send(std::string&& message) override;
+
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    void sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer) override;
+
+    void sendEncoded(std::string_view body, std::string_view contentEncoding) override;
+
+  private:
+    /// Takes the bytes from the bucket, waiting while it is in debt
+    void acquire(std::size_t bytes);
+
+    const double mBytesPerSecond;
+    double mTokens;
+    std::chrono::steady_clock::time_point mRefilled;
+};
+
+/// \brief Splits messages larger than the maximum size at line boundaries into several sends,
+/// a line larger than the maximum size is sent on its own
+class Splitter : public TransportDecorator
+{
+  public:
+    Splitter(std::unique_ptr<Transport> next, std::size_t maxMessageSize);
+
+    void send(std::string&& message) override;
+
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    /// Collects the stream into a message to split it
+    void sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer) override;
+
+  private:
+    void sendSplit(std::string_view message);
+
+    const std::size_t mMaxMessageSize;
+};
+
+/// \brief Writes messages failing to be sent to a spool file instead of throwing, and sends them
+/// in order once sending succeeds again; it persists across restarts. Messages exceeding the spool
+/// size are dropped, permanent errors are thrown; spooled messages failing with one are dropped.
+class Spool : public TransportDecorator
+{
+  public:
+    /// Default maximum size of the spool file
+    static constexpr std::size_t defaultMaxBytes{64 * 1024 * 1024};
+
+    /// Default interval of sending the spooled messages while sending fails
+    static constexpr std::chrono::milliseconds defaultRetryInterval{1000};
+
+    /// \throw InfluxDBException 	if the spool file exists but cannot be read
+    Spool(std::unique_ptr<Transport> next, const std::string& path, std::size_t maxBytes, std::chrono::milliseconds retryInterval);
+
+    void send(std::string&& message) override;
+
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    /// Collects the stream into a message to spool it if sending fails
+    void sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer) override;
+
+    /// Sends the spooled messages, then flushes the wrapped transport
+    void flush() override;
+
+    /// Adds the messages dropped as the spool was full, as the server rejected them when sent from the
+    /// spool or as their record was corrupt to the statistics of the wrapped transport
+    TransportStatistics sendStatistics() const override;
+
+  private:
+    /// Sends the spooled messages if due
+    /// \return true if the spool is empty
+    bool sendSpooled(bool force);
+
+    /// Replaces the spool file by its records from the offset on
+    void keepFrom(std::uint64_t offset);
+
+    /// Appends the message to the spool file, it is dropped if the spool is full
+    void spool(const std::vector<std::string_view>& buffers);
+
+    /// Marks sending as failed, the spool is sent again after the retry interval
+    void failed();
+
+    const std::string mPath;
+    const std::size_t mMaxBytes;
+    const std::chrono::milliseconds mRetryInterval;
+    std::uint64_t mSpooledBytes;
+    std::chrono::steady_clock::time_point mRetryAt;
+    std::atomic<std::uint64_t> mDroppedMessages{0};
+};
+
+/// \brief Compresses messages with gzip and passes them to Transport::sendEncoded(), e.g. to a HTTP transport
+class Compression : public TransportDecorator
+{
+  public:
+    /// \param level 	zlib compression level, 1 (fastest) to 9 (smallest)
+    /// \throw InfluxDBException 	if built without zlib or the level is invalid
+    Compression(std::unique_ptr<Transport> next, int level);
+
+    ~Compression() override;
+
+    Compression(const Compression&) = delete;
+    Compression& operator=(const Compression&) = delete;
+
+    void send(std::string&& message) override;
+
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    /// Collects the stream into a message to compress it
+    void sendStream(const std::function<std::size_t(char* buffer, std::size_t size)>& producer) override;
+
+  private:
+    struct Deflater;
+
+    /// Deflate stream reused for all messages
+    std::unique_ptr<Deflater> mDeflater;
+};
+
+} // namespace influxdb::transports
+
+#endif // INFLUXDATA_TRANSPORTS_TRANSPORTDECORATORS_H
@@ -25,15 +25,32 @@
 ///
 
 #include "UDP.h"
+#include "AsioBuffers.h"
+#include "Datagrams.h"
 #include "InfluxDBException.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
 
 namespace influxdb::transports
 {
 
-UDP::UDP(const std::string &hostname, int port) :
-  mSocket(mIoService, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0))
+UDP::UDP(const std::string &hostname, int port, std::size_t maxDatagramSize) :
+  mSocket(mIoService, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0)),
+  mMaxDatagramSize(maxDatagramSize)
 {
+  if (mMaxDatagramSize == 0)
+  {
+    // Every line would exceed it
+    throw InfluxDBException{__func__, "Invalid maximum datagram size: 0"};
+  }
   boost::asio::ip::udp::resolver resolver(mIoService);
   boost::asio::ip::udp::resolver::query query(boost::asio::ip::udp::v4(), hostname, std::to_string(port));
   boost::asio::ip::udp::resolver::iterator resolverInerator = resolver.resolve(query);
@@ -41,10 +58,87 @@ UDP::UDP(const std::string &hostname, int port) :
 }
 
 void UDP::send(std::string &&message)
+{
+  if (mAsyncSender)
+  {
+    mAsyncSender->post([this, message = std::move(message)] { sendMessage(message); });
+    return;
+  }
+  sendMessage(message);
+}
+
+void UDP::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  std::size_t size{0};
+  for (const auto& buffer : buffers)
+  {
+    size += buffer.size();
+  }
+
+  if (buffers.size() > maxGatherBuffers || size > mMaxDatagramSize || mAsyncSender)
+  {
+    // Asio would silently drop the exceeding buffers of the datagram, larger messages are split;
+    // asynchronous sends need a copy as the buffers are valid during the call only
+    Transport::sendBuffers(buffers);
+    return;
+  }
+
+  boost::system::error_code error;
+  mSocket.send_to(toAsioBuffers(buffers), mEndpoint, 0, error);
+  // Refused datagrams are reported by the connected socket of io_uring only, they are lost like unconnected ones
+  if (error && error != boost::asio::error::connection_refused)
+  {
+    throw InfluxDBException(__func__, error.message());
+  }
+}
+
+void UDP::setRejectedLinesHandler(RejectedLinesHandler handler)
+{
+  mRejectedLinesHandler = std::move(handler);
+}
+
+void UDP::enableAsync(std::size_t queueSize)
+{
+  if (mAsyncSender)
+  {
+    return;
+  }
+  mSocket.non_blocking(true);
+  mAsyncSender = std::make_unique<internal::AsyncSender>(mIoService, queueSize);
+}
+
+bool UDP::enableIoUring()
+{
+  if (mIoUring)
+  {
+    return true;
+  }
+  if (!internal::IoUring::available())
+  {
+    return false;
+  }
+  try
+  {
+    // Fits a full submission of datagrams of the default size
+    constexpr unsigned entries{256};
+    auto ioUring = std::make_unique<internal::IoUring>(entries, std::max(std::size_t{entries} * defaultMaxDatagramSize, mMaxDatagramSize));
+    // Writes to a socket need a destination, datagrams are sent to the endpoint as before
+    mSocket.connect(mEndpoint);
+    mIoUring = std::move(ioUring);
+    return true;
+  }
+  catch (const std::exception&)
+  {
+    // io_uring may be restricted, e.g. by seccomp or the locked memory limit
+    return false;
+  }
+}
+
+void UDP::setSendBufferSize(std::size_t bytes)
 {
   try
   {
-    mSocket.send_to(boost::asio::buffer(message, message.size()), mEndpoint);
+    mSocket.set_option(boost::asio::socket_base::send_buffer_size(static_cast<int>(bytes)));
   }
   catch (const boost::system::system_error &e)
   {
@@ -52,4 +146,176 @@ void UDP::send(std::string &&message)
   }
 }
 
+void UDP::flush()
+{
+  if (mAsyncSender)
+  {
+    mAsyncSender->flush();
+  }
+}
+
+TransportStatistics UDP::sendStatistics() const
+{
+  if (!mAsyncSender)
+  {
+    return Transport::sendStatistics();
+  }
+  return mAsyncSender->statistics();
+}
+
+void UDP::sendMessage(std::string_view message)
+{
+  if (message.size() <= mMaxDatagramSize)
+  {
+    countSent(sendDatagram(message) ? 1 : 0, 1);
+    return;
+  }
+
+  const auto packed = internal::packDatagrams(message, mMaxDatagramSize);
+  countSent(sendDatagrams(packed.datagrams), packed.datagrams.size());
+
+  if (packed.oversizeLines.empty())
+  {
+    return;
+  }
+  if (!mRejectedLinesHandler)
+  {
+    // The other lines were sent, the oversize ones fail the same way if the message is sent again
+    throw BadRequest(__func__, std::to_string(packed.oversizeLines.size()) + " lines exceed the maximum datagram size of " +
+                                   std::to_string(mMaxDatagramSize) + " bytes");
+  }
+  const std::string reason{"Line exceeds the maximum datagram size of " + std::to_string(mMaxDatagramSize) + " bytes"};
+  for (const auto line : packed.oversizeLines)
+  {
+    mRejectedLinesHandler(line, reason);
+  }
+}
+
+void UDP::countSent(std::size_t sent, std::size_t total)
+{
+  if (mAsyncSender)
+  {
+    mAsyncSender->countSent(sent);
+    mAsyncSender->countSocketBufferFull(total - sent);
+  }
+}
+
+std::size_t UDP::sendDatagrams(const std::vector<std::string_view>& datagrams)
+{
+  if (mIoUring)
+  {
+    return sendDatagramsIoUring(datagrams);
+  }
+#ifdef __linux__
+  // Submits the datagrams with as few system calls as possible, the kernel accepts at most UIO_MAXIOV per call
+  constexpr std::size_t maxMessagesPerCall{1024};
+  std::vector<iovec> vectors(datagrams.size());
+  std::vector<mmsghdr> messages(datagrams.size());
+  for (std::size_t i = 0; i < datagrams.size(); ++i)
+  {
+    vectors[i].iov_base = const_cast<char*>(datagrams[i].data());
+    vectors[i].iov_len = datagrams[i].size();
+    messages[i].msg_hdr.msg_name = mEndpoint.data();
+    messages[i].msg_hdr.msg_namelen = static_cast<socklen_t>(mEndpoint.size());
+    messages[i].msg_hdr.msg_iov = &vectors[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  for (std::size_t sent = 0; sent < messages.size();)
+  {
+    const auto count = std::min(messages.size() - sent, maxMessagesPerCall);
+    const int result = ::sendmmsg(mSocket.native_handle(), &messages[sent], static_cast<unsigned int>(count), 0);
+    if (result >= 0)
+    {
+      sent += static_cast<std::size_t>(result);
+      continue;
+    }
+    if (errno == EINTR)
+    {
+      continue;
+    }
+    if (errno == EAGAIN)
+    {
+      // Non-blocking socket with a full send buffer
+      return sent;
+    }
+    if (errno == ENOSYS)
+    {
+      // Kernels without sendmmsg
+      for (; sent < datagrams.size() && sendDatagram(datagrams[sent]); ++sent)
+      {
+      }
+      return sent;
+    }
+    throw InfluxDBException(__func__, std::strerror(errno));
+  }
+  return messages.size();
+#else
+  std::size_t sent{0};
+  for (; sent < datagrams.size() && sendDatagram(datagrams[sent]); ++sent)
+  {
+  }
+  return sent;
+#endif
+}
+
+std::size_t UDP::sendDatagramsIoUring(const std::vector<std::string_view>& datagrams)
+{
+  std::size_t sent{0};
+  int error{0};
+  const auto onCompletion = [&sent, &error](std::uint64_t, int result)
+  {
+    if (result >= 0 || result == -ECONNREFUSED)
+    {
+      ++sent;
+    }
+    else if (result != -EAGAIN && error == 0)
+    {
+      error = -result;
+    }
+  };
+
+  const int fd = mSocket.native_handle();
+  std::size_t offset{0};
+  for (const auto datagram : datagrams)
+  {
+    if (offset + datagram.size() > mIoUring->bufferSize())
+    {
+      mIoUring->submit(onCompletion);
+      offset = 0;
+    }
+    char* data = mIoUring->buffer() + offset;
+    std::memcpy(data, datagram.data(), datagram.size());
+    if (!mIoUring->write(fd, data, datagram.size(), 0))
+    {
+      mIoUring->submit(onCompletion);
+      mIoUring->write(fd, data, datagram.size(), 0);
+    }
+    offset += datagram.size();
+  }
+  mIoUring->submit(onCompletion);
+
+  if (error != 0)
+  {
+    throw InfluxDBException(__func__, std::strerror(error));
+  }
+  return sent;
+}
+
+bool UDP::sendDatagram(std::string_view datagram)
+{
+  boost::system::error_code error;
+  mSocket.send_to(boost::asio::buffer(datagram.data(), datagram.size()), mEndpoint, 0, error);
+  if (error == boost::asio::error::would_block)
+  {
+    return false;
+  }
+  // Refused datagrams are reported by the connected socket of io_uring only, they are lost like unconnected ones
+  if (error && error != boost::asio::error::connection_refused)
+  {
+    throw InfluxDBException(__func__, error.message());
+  }
+  return true;
+}
+
 } // namespace influxdb::transports
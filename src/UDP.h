@@ -28,25 +28,81 @@
 #define INFLUXDATA_TRANSPORTS_UDP_H
 
 #include "Transport.h"
+#include "AsyncSender.h"
+#include "IoUring.h"
 
 #include <boost/asio.hpp>
 #include <chrono>
+#include <memory>
 #include <string>
 
 namespace influxdb::transports
 {
 
-/// \brief UDP transport
+/// \brief UDP transport; messages larger than the maximum datagram size are split at line boundaries
 class UDP : public Transport
 {
   public:
+    /// Default maximum datagram size, fits the path MTU of common networks to avoid IP fragmentation
+    static constexpr std::size_t defaultMaxDatagramSize{1400};
+
     /// Constructor
-    UDP(const std::string &hostname, int port);
+    /// \param maxDatagramSize 	maximum payload size of a datagram
+    /// \throw InfluxDBException 	if maxDatagramSize is 0
+    UDP(const std::string &hostname, int port, std::size_t maxDatagramSize = defaultMaxDatagramSize);
 
-    /// Sends blob via UDP
+    /// Sends blob via UDP, split into datagrams if larger than the maximum datagram size
+    /// \throw InfluxDBException 	if sending fails
+    /// \throw BadRequest 	if lines larger than a datagram are dropped without a rejected lines handler;
+    ///                    the other lines are still sent then
     void send(std::string&& message) override;
 
+    /// Sends buffers as one datagram using scatter-gather I/O if it fits
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    /// Sets a handler for lines larger than the maximum datagram size, which are dropped;
+    /// it is called on the I/O thread if sending asynchronously
+    void setRejectedLinesHandler(RejectedLinesHandler handler) override;
+
+    /// Sends messages on an I/O thread instead of the caller's; messages are dropped if the queue is full
+    /// and datagrams if the socket send buffer is full, instead of blocking
+    /// \param queueSize 	maximum number of queued messages
+    void enableAsync(std::size_t queueSize);
+
+    /// Writes the datagrams of a message by a single io_uring submission from a registered buffer instead
+    /// of sendmmsg; the socket is connected to the endpoint then
+    /// \return false if io_uring is not available, datagrams are sent by sendmmsg then
+    bool enableIoUring();
+
+    /// Sets the size of the socket send buffer (SO_SNDBUF)
+    void setSendBufferSize(std::size_t bytes);
+
+    /// Waits until the queued messages are sent
+    void flush() override;
+
+    /// Returns the counters of the asynchronous sends
+    /// \throw InfluxDBException 	if not sending asynchronously
+    TransportStatistics sendStatistics() const override;
+
   private:
+    /// Sends a message, split into datagrams if larger than the maximum datagram size
+    void sendMessage(std::string_view message);
+
+    /// Sends the datagrams with sendmmsg on Linux, one by one elsewhere
+    /// \return number of datagrams sent, less than passed only if the socket send buffer is full
+    std::size_t sendDatagrams(const std::vector<std::string_view>& datagrams);
+
+    /// Writes the datagrams via io_uring, copied into its registered buffer
+    /// \return number of datagrams sent, less than passed only if the socket send buffer is full
+    std::size_t sendDatagramsIoUring(const std::vector<std::string_view>& datagrams);
+
+    /// Sends a single datagram
+    /// \return false if the socket send buffer is full
+    bool sendDatagram(std::string_view datagram);
+
+    /// Counts the datagrams sent asynchronously
+    void countSent(std::size_t sent, std::size_t total);
+
     /// Boost Asio I/O functionality
     boost::asio::io_service mIoService;
 
@@ -56,6 +112,17 @@ class UDP : public Transport
     /// UDP endpoint
     boost::asio::ip::udp::endpoint mEndpoint;
 
+    /// Maximum payload size of a datagram
+    std::size_t mMaxDatagramSize;
+
+    /// Handler for lines larger than a datagram, empty if not set
+    RejectedLinesHandler mRejectedLinesHandler;
+
+    /// io_uring writing the datagrams, nullptr if sending by sendmmsg
+    std::unique_ptr<internal::IoUring> mIoUring;
+
+    /// Sender of the asynchronous sends, nullptr if sending synchronously; destroyed first to send the queue
+    std::unique_ptr<internal::AsyncSender> mAsyncSender;
 };
 
 } // namespace influxdb::transports
@@ -25,8 +25,10 @@
 ///
 
 #include "UnixSocket.h"
+#include "AsioBuffers.h"
 #include "InfluxDBException.h"
 #include <string>
+#include <utility>
 
 namespace influxdb::transports
 {
@@ -39,10 +41,50 @@ UnixSocket::UnixSocket(const std::string &socketPath) :
 }
 
 void UnixSocket::send(std::string &&message)
+{
+  if (mAsyncSender)
+  {
+    mAsyncSender->post([this, message = std::move(message)] { sendMessage(message); });
+    return;
+  }
+  sendMessage(message);
+}
+
+void UnixSocket::sendBuffers(const std::vector<std::string_view>& buffers)
+{
+  if (buffers.size() > maxGatherBuffers || mAsyncSender)
+  {
+    // Asio would silently drop the exceeding buffers of the datagram;
+    // asynchronous sends need a copy as the buffers are valid during the call only
+    Transport::sendBuffers(buffers);
+    return;
+  }
+
+  try
+  {
+    mSocket.send_to(toAsioBuffers(buffers), mEndpoint);
+  }
+  catch (const boost::system::system_error &e)
+  {
+    throw InfluxDBException(__func__, e.what());
+  }
+}
+
+void UnixSocket::enableAsync(std::size_t queueSize)
+{
+  if (mAsyncSender)
+  {
+    return;
+  }
+  mSocket.non_blocking(true);
+  mAsyncSender = std::make_unique<internal::AsyncSender>(mIoService, queueSize);
+}
+
+void UnixSocket::setSendBufferSize(std::size_t bytes)
 {
   try
   {
-    mSocket.send_to(boost::asio::buffer(message, message.size()), mEndpoint);
+    mSocket.set_option(boost::asio::socket_base::send_buffer_size(static_cast<int>(bytes)));
   }
   catch (const boost::system::system_error &e)
   {
@@ -50,6 +92,43 @@ void UnixSocket::send(std::string &&message)
   }
 }
 
+void UnixSocket::flush()
+{
+  if (mAsyncSender)
+  {
+    mAsyncSender->flush();
+  }
+}
+
+TransportStatistics UnixSocket::sendStatistics() const
+{
+  if (!mAsyncSender)
+  {
+    return Transport::sendStatistics();
+  }
+  return mAsyncSender->statistics();
+}
+
+void UnixSocket::sendMessage(std::string_view message)
+{
+  boost::system::error_code error;
+  mSocket.send_to(boost::asio::buffer(message.data(), message.size()), mEndpoint, 0, error);
+  if (error == boost::asio::error::would_block)
+  {
+    // Only if sending asynchronously, the socket is non-blocking then
+    mAsyncSender->countSocketBufferFull(1);
+    return;
+  }
+  if (error)
+  {
+    throw InfluxDBException(__func__, error.message());
+  }
+  if (mAsyncSender)
+  {
+    mAsyncSender->countSent(1);
+  }
+}
+
 #else
 
 UnixSocket::UnixSocket(const std::string&)
@@ -62,6 +141,34 @@ void UnixSocket::send(std::string&&)
   throw InfluxDBException{__func__, "Unix socket not supported on this system"};
 }
 
+void UnixSocket::sendBuffers(const std::vector<std::string_view>&)
+{
+  throw InfluxDBException{__func__, "Unix socket not supported on this system"};
+}
+
+void UnixSocket::enableAsync(std::size_t)
+{
+  throw InfluxDBException{__func__, "Unix socket not supported on this system"};
+}
+
+void UnixSocket::setSendBufferSize(std::size_t)
+{
+  throw InfluxDBException{__func__, "Unix socket not supported on this system"};
+}
+
+void UnixSocket::flush()
+{
+}
+
+TransportStatistics UnixSocket::sendStatistics() const
+{
+  throw InfluxDBException{__func__, "Unix socket not supported on this system"};
+}
+
+void UnixSocket::sendMessage(std::string_view)
+{
+}
+
 #endif // defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
 
 } // namespace influxdb::transports
@@ -28,8 +28,10 @@
 #define INFLUXDATA_TRANSPORTS_UNIX_H
 
 #include "Transport.h"
+#include "AsyncSender.h"
 
 #include <boost/asio.hpp>
+#include <memory>
 #include <string>
 
 namespace influxdb::transports
@@ -44,7 +46,28 @@ class UnixSocket : public Transport
     /// \param message   r-value string formated
     void send(std::string&& message) override;
 
+    /// Sends buffers as one datagram using scatter-gather I/O
+    void sendBuffers(const std::vector<std::string_view>& buffers) override;
+
+    /// Sends messages on an I/O thread instead of the caller's; messages are dropped if the queue or
+    /// the socket send buffer is full, instead of blocking
+    /// \param queueSize 	maximum number of queued messages
+    void enableAsync(std::size_t queueSize);
+
+    /// Sets the size of the socket send buffer (SO_SNDBUF)
+    void setSendBufferSize(std::size_t bytes);
+
+    /// Waits until the queued messages are sent
+    void flush() override;
+
+    /// Returns the counters of the asynchronous sends
+    /// \throw InfluxDBException 	if not sending asynchronously
+    TransportStatistics sendStatistics() const override;
+
   private:
+    /// Sends a message as one datagram
+    void sendMessage(std::string_view message);
+
     /// Boost Asio I/O functionality
     boost::asio::io_service mIoService;
 #if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
@@ -53,6 +76,9 @@ class UnixSocket : public Transport
 
     /// Unix endpoint
     boost::asio::local::datagram_protocol::endpoint mEndpoint;
+
+    /// Sender of the asynchronous sends, nullptr if sending synchronously; destroyed first to send the queue
+    std::unique_ptr<internal::AsyncSender> mAsyncSender;
 #endif // defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
 };
 
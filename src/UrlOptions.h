@@ -0,0 +1,116 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#pragma once
+
+#include "UriParser.h"
+#include "InfluxDBException.h"
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace influxdb::internal
+{
+    /// Removes a transport option (name=value) from the query string of the url,
+    /// options are consumed by the client and not passed to the server
+    /// \return value of the option if present
+    inline std::optional<std::string> takeUrlOption(http::url& uri, std::string_view name)
+    {
+        std::string& search = uri.search;
+        for (std::size_t begin = 0; begin < search.size();)
+        {
+            const auto end = std::min(search.find('&', begin), search.size());
+            const std::string_view parameter{search.data() + begin, end - begin};
+
+            if (parameter.size() > name.size() && parameter.substr(0, name.size()) == name && parameter[name.size()] == '=')
+            {
+                std::string value{parameter.substr(name.size() + 1)};
+                const auto eraseBegin = (begin > 0 ? begin - 1 : begin);
+                const auto eraseEnd = (begin > 0 || end == search.size() ? end : end + 1);
+                search.erase(eraseBegin, eraseEnd - eraseBegin);
+                uri.url = uri.url.substr(0, uri.url.find('?') + 1) + search;
+                return value;
+            }
+            begin = end + 1;
+        }
+        return std::nullopt;
+    }
+
+    /// Removes a non-negative integer option from the url
+    /// \throw InfluxDBException	if the value is not a valid number
+    inline std::optional<std::size_t> takeSizeOption(http::url& uri, std::string_view name)
+    {
+        const auto value = takeUrlOption(uri, name);
+        if (!value)
+        {
+            return std::nullopt;
+        }
+
+        std::size_t parsed{0};
+        long long count{-1};
+        try
+        {
+            count = std::stoll(*value, &parsed);
+        }
+        catch (const std::logic_error&)
+        {
+        }
+        if (count < 0 || parsed != value->size())
+        {
+            throw InfluxDBException{__func__, "Invalid value of " + std::string{name} + ": " + *value};
+        }
+        return static_cast<std::size_t>(count);
+    }
+
+    /// Removes a boolean option (`true` or `false`) from the url
+    /// \throw InfluxDBException	if the value is neither
+    inline std::optional<bool> takeBoolOption(http::url& uri, std::string_view name)
+    {
+        const auto value = takeUrlOption(uri, name);
+        if (!value)
+        {
+            return std::nullopt;
+        }
+        if (*value != "true" && *value != "false")
+        {
+            throw InfluxDBException{__func__, "Invalid value of " + std::string{name} + ": " + *value};
+        }
+        return *value == "true";
+    }
+
+    /// Removes a duration option given in milliseconds from the url
+    /// \throw InfluxDBException	if the value is not a valid duration
+    inline std::optional<std::chrono::milliseconds> takeDurationOption(http::url& uri, std::string_view name)
+    {
+        const auto count = takeSizeOption(uri, name);
+        if (!count)
+        {
+            return std::nullopt;
+        }
+        return std::chrono::milliseconds{static_cast<std::chrono::milliseconds::rep>(*count)};
+    }
+}
@@ -22,13 +22,147 @@
 
 #include "BoostSupport.h"
 #include "InfluxDBException.h"
-#include "mock/TransportMock.h"
-#include <boost/property_tree/exceptions.hpp>
+#include "TransportDecorators.h"
+#include "UDP.h"
 #include <catch2/catch.hpp>
-#include <catch2/trompeloeil.hpp>
+#include <boost/asio.hpp>
+#include <set>
+#include <unistd.h>
 
 namespace influxdb::test
 {
+    namespace
+    {
+        /// Receives datagrams on a local port
+        struct UdpReceiver
+        {
+            UdpReceiver()
+                : socket(ioService, boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::loopback(), 0))
+            {
+            }
+
+            std::string url(const std::string& options) const
+            {
+                return "udp://127.0.0.1:" + std::to_string(socket.local_endpoint().port()) + options;
+            }
+
+            std::string receive()
+            {
+                std::string buffer(65536, '\0');
+                buffer.resize(socket.receive(boost::asio::buffer(buffer)));
+                return buffer;
+            }
+
+            boost::asio::io_service ioService;
+            boost::asio::ip::udp::socket socket;
+        };
+
+        /// Datagram Unix socket bound to a temporary path, datagrams are queued until read
+        struct UnixReceiver
+        {
+            UnixReceiver()
+                : path("/tmp/influxdb-cxx-test-" + std::to_string(::getpid()) + ".sock"),
+                  socket(ioService, boost::asio::local::datagram_protocol::endpoint(path))
+            {
+            }
+
+            ~UnixReceiver()
+            {
+                ::unlink(path.c_str());
+            }
+
+            std::string url(const std::string& options) const
+            {
+                return "unix://" + path + options;
+            }
+
+            std::string receive()
+            {
+                std::string buffer(65536, '\0');
+                buffer.resize(socket.receive(boost::asio::buffer(buffer)));
+                return buffer;
+            }
+
+            std::string path;
+            boost::asio::io_service ioService;
+            boost::asio::local::datagram_protocol::socket socket;
+        };
+
+        /// Stream Unix socket listening on a temporary path
+        struct UnixStreamReceiver
+        {
+            UnixStreamReceiver()
+                : path("/tmp/influxdb-cxx-test-stream-" + std::to_string(::getpid()) + ".sock"),
+                  acceptor(ioService, boost::asio::local::stream_protocol::endpoint(path)), socket(ioService)
+            {
+            }
+
+            ~UnixStreamReceiver()
+            {
+                ::unlink(path.c_str());
+            }
+
+            std::string url(const std::string& options) const
+            {
+                return "unix://" + path + options;
+            }
+
+            void accept()
+            {
+                socket = boost::asio::local::stream_protocol::socket(ioService);
+                acceptor.accept(socket);
+            }
+
+            std::string receive(std::size_t size)
+            {
+                std::string buffer(size, '\0');
+                boost::asio::read(socket, boost::asio::buffer(buffer));
+                return buffer;
+            }
+
+            std::string path;
+            boost::asio::io_service ioService;
+            boost::asio::local::stream_protocol::acceptor acceptor;
+            boost::asio::local::stream_protocol::socket socket;
+        };
+
+        /// Accepts a TCP connection on a local port
+        struct TcpReceiver
+        {
+            TcpReceiver()
+                : acceptor(ioService, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)), socket(ioService)
+            {
+            }
+
+            std::string url(const std::string& options) const
+            {
+                return "tcp://127.0.0.1:" + std::to_string(acceptor.local_endpoint().port()) + options;
+            }
+
+            void accept()
+            {
+                socket = boost::asio::ip::tcp::socket(ioService);
+                acceptor.accept(socket);
+            }
+
+            std::string receive(std::size_t size)
+            {
+                std::string buffer(size, '\0');
+                boost::asio::read(socket, boost::asio::buffer(buffer));
+                return buffer;
+            }
+
+            boost::asio::io_service ioService;
+            boost::asio::ip::tcp::acceptor acceptor;
+            boost::asio::ip::tcp::socket socket;
+        };
+
+        http::url parse(std::string url)
+        {
+            return http::ParseHttpUrl(url);
+        }
+    }
+
     TEST_CASE("With UDP returns transport", "[BoostSupportTest]")
     {
         CHECK(internal::withUdpTransport(http::url{}) != nullptr);
@@ -51,107 +185,244 @@ namespace influxdb::test
         CHECK_THROWS_AS(udp->createDatabase(), std::runtime_error);
     }
 
-    TEST_CASE("Query is passed to transport", "[BoostSupportTest]")
+    TEST_CASE("UDP transport splits messages into datagrams at line boundaries", "[BoostSupportTest]")
     {
-        TransportMock transport;
-        REQUIRE_CALL(transport, query("SELECT * from test WHERE host = 'localhost'"))
-            .RETURN(R"({"results":[{"statement_id":0}]})");
+        UdpReceiver receiver;
+        auto udp = internal::withUdpTransport(parse(receiver.url("?max_datagram_size=12")));
 
-        internal::queryImpl(&transport, "SELECT * from test WHERE host = 'localhost'");
+        udp->send("a x=1\nb x=2\nc x=3");
+        CHECK(receiver.receive() == "a x=1\nb x=2");
+        CHECK(receiver.receive() == "c x=3");
+
+        udp->sendBuffers({"d x=4", "\n", "e x=5", "\n", "f x=6"});
+        CHECK(receiver.receive() == "d x=4\ne x=5");
+        CHECK(receiver.receive() == "f x=6");
     }
 
-    TEST_CASE("Query throws if transport throws", "[BoostSupportTest]")
+    TEST_CASE("UDP transport reports lines larger than a datagram", "[BoostSupportTest]")
     {
-        using trompeloeil::_;
+        UdpReceiver receiver;
+        auto udp = internal::withUdpTransport(parse(receiver.url("?max_datagram_size=8")));
 
-        TransportMock transport;
-        ALLOW_CALL(transport, query(_)).THROW(InfluxDBException{"unit test", "Intentional"});
+        CHECK_THROWS_AS(udp->send("a x=1\nlarge x=1234\nb x=2"), BadRequest);
+        CHECK(receiver.receive() == "a x=1");
+        CHECK(receiver.receive() == "b x=2");
 
-        CHECK_THROWS_AS(internal::queryImpl(&transport, "select should throw"), InfluxDBException);
+        std::vector<std::string> rejected;
+        udp->setRejectedLinesHandler([&rejected](std::string_view line, std::string_view) { rejected.emplace_back(line); });
+        udp->send("c x=3\nlarge x=1234");
+        CHECK(receiver.receive() == "c x=3");
+        CHECK(rejected == std::vector<std::string>{"large x=1234"});
     }
 
-    TEST_CASE("Query returns empty if empty result", "[BoostSupportTest]")
+    TEST_CASE("UDP transport lines larger than a datagram are not retried", "[BoostSupportTest]")
     {
-        using trompeloeil::_;
+        UdpReceiver receiver;
+        transports::Retry udp{internal::withUdpTransport(parse(receiver.url("?max_datagram_size=8"))), 3, std::chrono::milliseconds{1}};
 
-        TransportMock transport;
-        ALLOW_CALL(transport, query(_)).RETURN(R"({"results":[]})");
+        CHECK_THROWS_AS(udp.send("a x=1\nlarge x=1234\nb x=2"), BadRequest);
+        CHECK(receiver.receive() == "a x=1");
+        CHECK(receiver.receive() == "b x=2");
+        CHECK(receiver.socket.available() == 0);
+    }
 
-        CHECK(internal::queryImpl(&transport, "SELECT * from test").empty());
+    TEST_CASE("UDP transport throws on invalid max datagram size", "[BoostSupportTest]")
+    {
+        CHECK_THROWS_AS(internal::withUdpTransport(parse("udp://localhost:8089?max_datagram_size=0")), InfluxDBException);
+        CHECK_THROWS_AS(internal::withUdpTransport(parse("udp://localhost:8089?max_datagram_size=x")), InfluxDBException);
+        CHECK_THROWS_AS(transports::UDP("localhost", 8089, 0), InfluxDBException);
     }
 
-    TEST_CASE("Query returns point of single result", "[BoostSupportTest]")
+    TEST_CASE("UDP transport with io_uring splits messages into datagrams", "[BoostSupportTest]")
     {
-        using trompeloeil::_;
+        UdpReceiver receiver;
+        auto udp = internal::withUdpTransport(parse(receiver.url("?io_uring=true&max_datagram_size=12")));
+
+        udp->send("a x=1\nb x=2\nc x=3");
+        udp->sendBuffers({"d x=4", "\n", "e x=5"});
+
+        // Writes of a submission may complete in any order
+        std::multiset<std::string> received;
+        for (int i = 0; i < 3; ++i)
+        {
+            received.insert(receiver.receive());
+        }
+        CHECK(received == std::multiset<std::string>{"a x=1\nb x=2", "c x=3", "d x=4\ne x=5"});
+    }
 
-        std::tm timestamp{};
-        std::stringstream timeString;
-        timeString << "2021-01-01:11:22.000000000Z";
-        timeString >> std::get_time(&timestamp, "%Y-%m-%dT%H:%M:%SZ");
+    TEST_CASE("UDP transport with io_uring ignores refused datagrams", "[BoostSupportTest]")
+    {
+        std::string url;
+        {
+            UdpReceiver receiver;
+            url = receiver.url("?io_uring=true&max_datagram_size=8");
+        }
+        auto udp = internal::withUdpTransport(parse(url));
 
-        TransportMock transport;
-        ALLOW_CALL(transport, query(_))
-            .RETURN(R"({"results":[{"statement_id":0,)"
-                    R"("series":[{"name":"unittest","columns":["time","host","value"],)"
-                    R"("values":[["2021-01-01:11:22.000000000Z","localhost",112233]]}]}]})");
+        for (int i = 0; i < 3; ++i)
+        {
+            CHECK_NOTHROW(udp->send("a x=1\nb x=2"));
+            CHECK_NOTHROW(udp->send("c x=3"));
+        }
+    }
 
-        const auto result = internal::queryImpl(&transport, "SELECT * from test");
-        CHECK(result.size() == 1);
-        const auto point = result[0];
-        CHECK(point.getName() == "unittest");
-        CHECK(point.getTimestamp() == std::chrono::system_clock::from_time_t(std::mktime(&timestamp)));
-        CHECK(point.getTags() == "host=localhost");
-        CHECK(point.getFields() == "value=112233.000000000000000000");
+    TEST_CASE("UDP transport throws on invalid io_uring option", "[BoostSupportTest]")
+    {
+        CHECK_THROWS_AS(internal::withUdpTransport(parse("udp://localhost:8089?io_uring=yes")), InfluxDBException);
     }
 
-    TEST_CASE("Query returns points of multiple results", "[BoostSupportTest]")
+    TEST_CASE("Async UDP transport sends on I/O thread", "[BoostSupportTest]")
     {
-        using trompeloeil::_;
+        UdpReceiver receiver;
+        auto udp = internal::withUdpTransport(parse(receiver.url("?async=true&max_datagram_size=12&send_buffer_size=65536")));
 
-        TransportMock transport;
-        ALLOW_CALL(transport, query(_))
-            .RETURN(R"({"results":[{"statement_id":0,)"
-                    R"("series":[{"name":"unittest","columns":["time","host","value"],)"
-                    R"("values":[["2021-01-01:11:22.000000000Z","host-0",100],)"
-                    R"(["2021-01-01:11:23.000000000Z","host-1",30],)"
-                    R"(["2021-01-01:11:24.000000000Z","host-2",54]]}]}]})");
+        udp->send("a x=1\nb x=2\nc x=3");
+        udp->sendBuffers({"d x=4", "\n", "e x=5"});
+        udp->flush();
 
-        const auto result = internal::queryImpl(&transport, "SELECT * from test");
-        CHECK(result.size() == 3);
-        CHECK(result[0].getName() == "unittest");
-        CHECK(result[0].getTags() == "host=host-0");
-        CHECK(result[0].getFields() == "value=100.000000000000000000");
-        CHECK(result[1].getName() == "unittest");
-        CHECK(result[1].getTags() == "host=host-1");
-        CHECK(result[1].getFields() == "value=30.000000000000000000");
-        CHECK(result[2].getName() == "unittest");
-        CHECK(result[2].getTags() == "host=host-2");
-        CHECK(result[2].getFields() == "value=54.000000000000000000");
+        CHECK(receiver.receive() == "a x=1\nb x=2");
+        CHECK(receiver.receive() == "c x=3");
+        CHECK(receiver.receive() == "d x=4\ne x=5");
+        const auto statistics = udp->sendStatistics();
+        CHECK(statistics.sentMessages == 2);
+        CHECK(statistics.sentDatagrams == 3);
+        CHECK(statistics.droppedMessages == 0);
+        CHECK(statistics.droppedDatagrams == 0);
+        CHECK(statistics.failedMessages == 0);
     }
 
-    TEST_CASE("Query throws on invalid result", "[BoostSupportTest]")
+    TEST_CASE("Async UDP transport counts every message", "[BoostSupportTest]")
     {
-        using trompeloeil::_;
+        UdpReceiver receiver;
+        auto udp = internal::withUdpTransport(parse(receiver.url("?async=true&queue_size=1")));
 
-        TransportMock transport;
-        ALLOW_CALL(transport, query(_))
-            .RETURN(R"({"invalid-results":[]})");
+        constexpr std::size_t count{1000};
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            udp->send("a x=1");
+        }
+        udp->flush();
 
-        CHECK_THROWS_AS(internal::queryImpl(&transport, "SELECT * from test"), boost::property_tree::ptree_bad_path);
+        const auto statistics = udp->sendStatistics();
+        CHECK(statistics.sentMessages + statistics.droppedMessages == count);
+        CHECK(statistics.sentDatagrams == statistics.sentMessages);
     }
 
-    TEST_CASE("Query is safe to empty name", "[BoostSupportTest]")
+    TEST_CASE("Sync UDP transport has no statistics", "[BoostSupportTest]")
     {
-        using trompeloeil::_;
+        UdpReceiver receiver;
+        auto udp = internal::withUdpTransport(parse(receiver.url("")));
+        CHECK_THROWS_AS(udp->sendStatistics(), InfluxDBException);
+    }
 
-        TransportMock transport;
-        ALLOW_CALL(transport, query(_))
-            .RETURN(R"({"results":[{"statement_id":0,"series":[{"columns":["time","host","value"],)"
-                    R"("values":[["2021-01-01:11:22.000000000Z","x",8]]}]}]})");
+    TEST_CASE("Async Unix socket transport drops datagrams if the socket buffer is full", "[BoostSupportTest]")
+    {
+        UnixReceiver receiver;
+        auto unixSocket = internal::withUnixSocketTransport(parse(receiver.url("?async=true&queue_size=100000&send_buffer_size=4096")));
+
+        constexpr std::size_t count{2000};
+        const std::string line(1000, 'x');
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            unixSocket->send(std::string{line});
+        }
+        unixSocket->flush();
+
+        const auto statistics = unixSocket->sendStatistics();
+        CHECK(statistics.sentDatagrams > 0);
+        CHECK(statistics.droppedDatagrams > 0);
+        CHECK(statistics.sentDatagrams + statistics.droppedDatagrams == count);
+        CHECK(statistics.sentMessages == statistics.sentDatagrams);
+        CHECK(statistics.droppedMessages == statistics.droppedDatagrams);
+        CHECK(receiver.receive() == line);
+    }
+
+    TEST_CASE("Async Unix socket transport counts failed sends", "[BoostSupportTest]")
+    {
+        auto unixSocket = internal::withUnixSocketTransport(parse("unix:///tmp/influxdb-cxx-test-no-receiver.sock?async=true"));
+
+        unixSocket->send("a x=1");
+        unixSocket->flush();
+
+        CHECK(unixSocket->sendStatistics().failedMessages == 1);
+    }
+
+    TEST_CASE("Datagram transports throw on invalid async options", "[BoostSupportTest]")
+    {
+        CHECK_THROWS_AS(internal::withUdpTransport(parse("udp://localhost:8089?async=yes")), InfluxDBException);
+        CHECK_THROWS_AS(internal::withUdpTransport(parse("udp://localhost:8089?async=true&queue_size=0")), InfluxDBException);
+        CHECK_THROWS_AS(internal::withUnixSocketTransport(parse("unix:///tmp/x.sock?send_buffer_size=-1")), InfluxDBException);
+    }
+
+    TEST_CASE("Unix stream transport writes newline terminated messages", "[BoostSupportTest]")
+    {
+        UnixStreamReceiver receiver;
+        auto unixSocket = internal::withUnixSocketTransport(parse(receiver.url("?stream=true")));
+
+        unixSocket->send("a x=1");
+        unixSocket->sendBuffers({"b x=2", "\n", "c x=3"});
+        const std::string large(300 * 1024, 'x');
+        unixSocket->send(std::string{large});
+        unixSocket->send("d x=4");
+
+        receiver.accept();
+        CHECK(receiver.receive(18) == "a x=1\nb x=2\nc x=3\n");
+        CHECK(receiver.receive(large.size() + 1) == large + "\n");
+        CHECK(receiver.receive(6) == "d x=4\n");
+        unixSocket->flush();
+    }
+
+    TEST_CASE("Unix stream transport reconnects", "[BoostSupportTest]")
+    {
+        UnixStreamReceiver receiver;
+        auto unixSocket = internal::withUnixSocketTransport(parse(receiver.url("?stream=true&reconnect_backoff_ms=1")));
+
+        unixSocket->send("a x=1");
+        receiver.accept();
+        CHECK(receiver.receive(6) == "a x=1\n");
+        unixSocket->flush();
+        receiver.socket.close();
+
+        unixSocket->send("b x=2");
+        receiver.accept();
+        CHECK(receiver.receive(6) == "b x=2\n");
+        unixSocket->flush();
+    }
+
+    TEST_CASE("Unix stream transport reports connection failures", "[BoostSupportTest]")
+    {
+        auto unixSocket = internal::withUnixSocketTransport(
+            parse("unix:///tmp/influxdb-cxx-test-no-receiver.sock?stream=true&reconnect_backoff_ms=1&max_pending_bytes=8"));
 
-        const auto result = internal::queryImpl(&transport, "SELECT * from test");
-        CHECK(result.size() == 1);
-        CHECK(result[0].getName() == "");
-        CHECK(result[0].getTags() == "host=x");
+        unixSocket->send("a x=1");
+        CHECK_THROWS_AS(unixSocket->flush(), InfluxDBException);
+        CHECK_THROWS_AS(unixSocket->send("b x=2"), InfluxDBException);
+    }
+
+    TEST_CASE("TCP transport writes newline terminated messages", "[BoostSupportTest]")
+    {
+        TcpReceiver receiver;
+        auto tcp = internal::withTcpTransport(parse(receiver.url("?send_buffer_size=65536")));
+
+        tcp->send("a x=1");
+        tcp->sendBuffers({"b x=2", "\n", "c x=3"});
+        receiver.accept();
+        CHECK(receiver.receive(18) == "a x=1\nb x=2\nc x=3\n");
+        tcp->flush();
+        receiver.socket.close();
+
+        for (std::size_t i = 0; i < 100; ++i)
+        {
+            tcp->send("d x=4");
+        }
+        receiver.accept();
+        CHECK(receiver.receive(6) == "d x=4\n");
+        tcp->flush();
+    }
+
+    TEST_CASE("TCP transport throws on invalid options", "[BoostSupportTest]")
+    {
+        CHECK_THROWS_AS(internal::withTcpTransport(parse("tcp://localhost:8094?max_pending_bytes=0")), InfluxDBException);
+        CHECK_THROWS_AS(internal::withTcpTransport(parse("tcp://localhost:8094?reconnect_backoff_ms=x")), InfluxDBException);
     }
 }
@@ -0,0 +1,63 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Datagrams.h"
+#include <catch2/catch.hpp>
+
+namespace influxdb::test
+{
+    using internal::packDatagrams;
+
+    TEST_CASE("Pack datagrams keeps message fitting into one datagram", "[DatagramsTest]")
+    {
+        const auto packed = packDatagrams("a x=1\nb x=2", 11);
+        CHECK(packed.datagrams == std::vector<std::string_view>{"a x=1\nb x=2"});
+        CHECK(packed.oversizeLines.empty());
+    }
+
+    TEST_CASE("Pack datagrams splits at line boundaries", "[DatagramsTest]")
+    {
+        const auto packed = packDatagrams("a x=1\nb x=2\nc x=3\nd x=4", 12);
+        CHECK(packed.datagrams == std::vector<std::string_view>{"a x=1\nb x=2", "c x=3\nd x=4"});
+    }
+
+    TEST_CASE("Pack datagrams fills datagrams up to the maximum size", "[DatagramsTest]")
+    {
+        const auto packed = packDatagrams("a x=1\nb x=2\nc x=3\nd x=4", 17);
+        CHECK(packed.datagrams == std::vector<std::string_view>{"a x=1\nb x=2\nc x=3", "d x=4"});
+    }
+
+    TEST_CASE("Pack datagrams reports oversize lines", "[DatagramsTest]")
+    {
+        const auto packed = packDatagrams("a x=1\nbig x=12345\nc x=3\n", 6);
+        CHECK(packed.datagrams == std::vector<std::string_view>{"a x=1", "c x=3"});
+        CHECK(packed.oversizeLines == std::vector<std::string_view>{"big x=12345"});
+    }
+
+    TEST_CASE("Pack datagrams skips empty lines at datagram boundaries", "[DatagramsTest]")
+    {
+        const auto packed = packDatagrams("\na x=1\n\n\nb x=2\n", 5);
+        CHECK(packed.datagrams == std::vector<std::string_view>{"a x=1", "b x=2"});
+        CHECK(packDatagrams("", 5).datagrams.empty());
+    }
+}
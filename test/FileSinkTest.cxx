@@ -0,0 +1,270 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "FileSink.h"
+#include "InfluxDBFactory.h"
+#include "InfluxDBException.h"
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+#ifdef INFLUXCXX_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace influxdb::test
+{
+    using transports::FileSink;
+
+    namespace
+    {
+        /// Directory unique to the test, removed at the end of the test
+        struct TemporaryDirectory
+        {
+            explicit TemporaryDirectory(const std::string& test)
+                : path(std::filesystem::temp_directory_path() / ("influxdb-cxx-test-" + std::to_string(::getpid()) + "-" + test))
+            {
+                std::filesystem::remove_all(path);
+                std::filesystem::create_directories(path);
+            }
+
+            ~TemporaryDirectory()
+            {
+                std::filesystem::remove_all(path);
+            }
+
+            std::string file(const std::string& name) const
+            {
+                return (path / name).string();
+            }
+
+            /// Names of the rotated files, ordered by their rotation
+            std::vector<std::string> rotatedFiles(const std::string& name, const std::string& suffix = "") const
+            {
+                std::vector<std::string> files;
+                for (const auto& entry : std::filesystem::directory_iterator(path))
+                {
+                    const auto fileName = entry.path().filename().string();
+                    if (fileName != name && fileName.rfind(name + ".", 0) == 0 && fileName.size() >= suffix.size() &&
+                        fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) == 0)
+                    {
+                        files.push_back(entry.path().string());
+                    }
+                }
+                std::sort(files.begin(), files.end());
+                return files;
+            }
+
+            std::filesystem::path path;
+        };
+
+        std::string readFile(const std::string& path)
+        {
+            std::ifstream file{path, std::ios::binary};
+            std::ostringstream content;
+            content << file.rdbuf();
+            return content.str();
+        }
+    }
+
+    TEST_CASE("File transport appends newline terminated messages", "[FileSinkTest]")
+    {
+        TemporaryDirectory directory{"append"};
+        const auto path = directory.file("metrics.lp");
+        {
+            FileSink sink{path};
+            sink.send("a x=1\nb x=2");
+            sink.sendBuffers({"c x=3", "\n", "d x=4"});
+            std::string stream{"e x=5"};
+            sink.sendStream([&stream](char* buffer, std::size_t size) {
+                const auto count = stream.copy(buffer, size);
+                stream.erase(0, count);
+                return count;
+            });
+            CHECK(readFile(path).empty());
+
+            sink.flush();
+            CHECK(readFile(path) == "a x=1\nb x=2\nc x=3\nd x=4\ne x=5\n");
+        }
+
+        FileSink sink{path};
+        sink.send("f x=6");
+        sink.flush();
+        CHECK(readFile(path) == "a x=1\nb x=2\nc x=3\nd x=4\ne x=5\nf x=6\n");
+    }
+
+    TEST_CASE("File transport writes messages larger than the buffer", "[FileSinkTest]")
+    {
+        TemporaryDirectory directory{"large"};
+        const auto path = directory.file("metrics.lp");
+        {
+            FileSink sink{path, 8};
+            sink.send("a x=1");
+            sink.send("large x=1234567890");
+            sink.sendBuffers({"b x=2", "\n", "c x=3"});
+            std::string stream{"d x=4\ne x=5"};
+            sink.sendStream([&stream](char* buffer, std::size_t size) {
+                const auto count = stream.copy(buffer, size);
+                stream.erase(0, count);
+                return count;
+            });
+        }
+        CHECK(readFile(path) == "a x=1\nlarge x=1234567890\nb x=2\nc x=3\nd x=4\ne x=5\n");
+    }
+
+    TEST_CASE("File transport rotates by size at message boundaries", "[FileSinkTest]")
+    {
+        TemporaryDirectory directory{"size"};
+        const auto path = directory.file("metrics.lp");
+        {
+            FileSink sink{path};
+            sink.setMaxFileSize(10);
+            sink.send("a x=1");
+            sink.send("b x=2\nc x=3");
+            sink.send("d x=4");
+        }
+
+        const auto rotated = directory.rotatedFiles("metrics.lp");
+        REQUIRE(rotated.size() == 1);
+        CHECK(readFile(rotated[0]) == "a x=1\nb x=2\nc x=3\n");
+        CHECK(readFile(path) == "d x=4\n");
+    }
+
+    TEST_CASE("File transport opens the file again after a failed rotation", "[FileSinkTest]")
+    {
+        TemporaryDirectory directory{"reopen"};
+        const auto path = directory.file("metrics.lp");
+        FileSink sink{path};
+        sink.setMaxFileSize(10);
+
+        std::filesystem::remove_all(directory.path);
+        // The message is written before the rotation fails, it must not be sent again
+        CHECK_NOTHROW(sink.send("a x=1\nb x=2"));
+        sink.send("c x=3");
+        CHECK_THROWS_AS(sink.flush(), InfluxDBException);
+
+        std::filesystem::create_directories(directory.path);
+        sink.setMaxFileSize(0);
+        sink.send("d x=4");
+        // The failed rotation is reported once
+        CHECK_THROWS_AS(sink.flush(), InfluxDBException);
+        sink.flush();
+        CHECK(readFile(path) == "d x=4\n");
+    }
+
+    TEST_CASE("File transport rotates by age", "[FileSinkTest]")
+    {
+        TemporaryDirectory directory{"age"};
+        const auto path = directory.file("metrics.lp");
+        FileSink sink{path};
+        sink.setRotateInterval(std::chrono::milliseconds{1});
+        std::this_thread::sleep_for(std::chrono::milliseconds{2});
+        sink.send("a x=1");
+        sink.flush();
+
+        const auto rotated = directory.rotatedFiles("metrics.lp");
+        REQUIRE(rotated.size() == 1);
+        CHECK(readFile(rotated[0]) == "a x=1\n");
+        CHECK(readFile(path).empty());
+    }
+
+#ifdef INFLUXCXX_WITH_ZLIB
+    TEST_CASE("File transport compresses rotated files", "[FileSinkTest]")
+    {
+        TemporaryDirectory directory{"gzip"};
+        const auto path = directory.file("metrics.lp");
+        {
+            auto influxdb = InfluxDBFactory::Get("file://" + path + "?max_file_size=1&gzip=true&fsync=rotate");
+            influxdb->write(Point{"a"}.addField("x", 1).setTimestamp(std::chrono::time_point<std::chrono::system_clock>{}));
+            influxdb->write(Point{"b"}.addField("x", 2).setTimestamp(std::chrono::time_point<std::chrono::system_clock>{}));
+        }
+
+        const auto compressed = directory.rotatedFiles("metrics.lp", ".gz");
+        REQUIRE(compressed.size() == 2);
+        CHECK(directory.rotatedFiles("metrics.lp").size() == 2);
+
+        gzFile file = ::gzopen(compressed[1].c_str(), "rb");
+        REQUIRE(file != nullptr);
+        std::string content(64, '\0');
+        content.resize(static_cast<std::size_t>(::gzread(file, content.data(), static_cast<unsigned>(content.size()))));
+        ::gzclose(file);
+        CHECK(content == "b x=2i 0\n");
+    }
+
+    TEST_CASE("File transport reports failed compressions by flush", "[FileSinkTest]")
+    {
+        TemporaryDirectory directory{"gzip-failed"};
+        // The rotated files fit the maximum name length, the temporary compressed files do not
+        const auto path = directory.file(std::string(226, 'm') + ".lp");
+        FileSink sink{path};
+        sink.setMaxFileSize(1);
+        sink.enableCompression();
+
+        sink.send("a x=1");
+        CHECK_NOTHROW(sink.send("b x=2"));
+        CHECK_THROWS_AS(sink.flush(), InfluxDBException);
+
+        // The compression of the second file is started although the first one failed
+        bool reported{false};
+        for (int attempt = 0; attempt < 1000 && !reported; ++attempt)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            try
+            {
+                sink.flush();
+            }
+            catch (const InfluxDBException&)
+            {
+                reported = true;
+            }
+        }
+        CHECK(reported);
+        CHECK(directory.rotatedFiles(std::string(226, 'm') + ".lp").size() == 2);
+    }
+#endif
+
+    TEST_CASE("File transport is created by the factory", "[FileSinkTest]")
+    {
+        TemporaryDirectory directory{"factory"};
+        const auto path = directory.file("metrics.lp");
+        {
+            auto influxdb = InfluxDBFactory::Get("file://" + path + "?buffer_size=65536&fsync=flush&rotate_interval_ms=60000");
+            influxdb->write(Point{"test"}.addField("value", 10).setTimestamp(std::chrono::time_point<std::chrono::system_clock>{}));
+            influxdb->flushTransport();
+            CHECK(readFile(path) == "test value=10i 0\n");
+        }
+    }
+
+    TEST_CASE("File transport throws on invalid options", "[FileSinkTest]")
+    {
+        TemporaryDirectory directory{"options"};
+        const auto url = "file://" + directory.file("metrics.lp");
+        CHECK_THROWS_AS(InfluxDBFactory::Get(url + "?fsync=always"), InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::Get(url + "?buffer_size=0"), InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::Get(url + "?gzip=1"), InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::Get("file://" + directory.file("missing/metrics.lp")), InfluxDBException);
+    }
+}
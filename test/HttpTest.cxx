@@ -25,6 +25,8 @@
 #include "mock/CurlMock.h"
 #include <catch2/catch.hpp>
 #include <catch2/trompeloeil.hpp>
+#include <functional>
+#include <utility>
 
 
 namespace influxdb::test
@@ -40,6 +42,43 @@ namespace influxdb::test
     using influxdb::transports::HTTP;
     using trompeloeil::_;
 
+    namespace
+    {
+        /// Answers writes through the curl callbacks, the response depends on the request body
+        struct FakeWriteServer
+        {
+            using Handler = std::function<std::pair<long, std::string>(const std::string&)>;
+
+            explicit FakeWriteServer(Handler handler)
+                : respond(std::move(handler))
+            {
+            }
+
+            void serve()
+            {
+                std::string body;
+                char buffer[8];
+                for (auto n = readCallback(buffer, 1, sizeof(buffer), readUserdata); n > 0; n = readCallback(buffer, 1, sizeof(buffer), readUserdata))
+                {
+                    body.append(buffer, n);
+                }
+                requests.push_back(body);
+
+                auto [code, response] = respond(body);
+                responseCode = code;
+                writeCallback(response.data(), 1, response.size(), writeUserdata);
+            }
+
+            Handler respond;
+            ReadCallbackFn readCallback{nullptr};
+            void* readUserdata{nullptr};
+            WriteCallbackFn writeCallback{nullptr};
+            void* writeUserdata{nullptr};
+            long responseCode{0};
+            std::vector<std::string> requests;
+        };
+    }
+
     TEST_CASE("Construction initializes curl", "[HttpTest]")
     {
         REQUIRE_CALL(curlMock, curl_global_init(CURL_GLOBAL_ALL)).RETURN(CURLE_OK);
@@ -146,6 +185,181 @@ namespace influxdb::test
         http.send(std::string{data});
     }
 
+    TEST_CASE("Send buffers streams buffers to curl", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        const std::vector<std::string_view> buffers{"line-0", "\n", "line-1", "\n", "", "line-2"};
+        HTTP http{"http://localhost:8086?db=test"};
+
+        ReadCallbackFn callback{nullptr};
+        void* userdata{nullptr};
+        std::string transmitted;
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_POSTFIELDS, static_cast<void*>(nullptr))).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_POSTFIELDSIZE_LARGE, long{20})).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READFUNCTION, ANY(ReadCallbackFn)))
+            .LR_SIDE_EFFECT(callback = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(userdata = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_perform(handle))
+            .LR_SIDE_EFFECT({
+                char buffer[4];
+                for (auto n = callback(buffer, 1, sizeof(buffer), userdata); n > 0; n = callback(buffer, 1, sizeof(buffer), userdata))
+                {
+                    transmitted.append(buffer, n);
+                }
+            })
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 204)
+            .RETURN(CURLE_OK);
+
+        http.sendBuffers(buffers);
+        CHECK(transmitted == "line-0\nline-1\nline-2");
+    }
+
+    TEST_CASE("Send stream uses chunked transfer", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+
+        curl_slist headers{};
+        ReadCallbackFn callback{nullptr};
+        void* userdata{nullptr};
+        std::string transmitted;
+        REQUIRE_CALL(curlMock, curl_slist_append(nullptr, _))
+            .WITH(std::string{_2} == "Transfer-Encoding: chunked")
+            .RETURN(&headers);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_POSTFIELDS, static_cast<void*>(nullptr))).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_POSTFIELDSIZE, long{-1})).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_HTTPHEADER, static_cast<void*>(&headers))).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READFUNCTION, ANY(ReadCallbackFn)))
+            .LR_SIDE_EFFECT(callback = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(userdata = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_perform(handle))
+            .LR_SIDE_EFFECT({
+                char buffer[4];
+                for (auto n = callback(buffer, 1, sizeof(buffer), userdata); n > 0; n = callback(buffer, 1, sizeof(buffer), userdata))
+                {
+                    transmitted.append(buffer, n);
+                }
+            })
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_HTTPHEADER, static_cast<void*>(nullptr))).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_slist_free_all(&headers));
+        REQUIRE_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 204)
+            .RETURN(CURLE_OK);
+
+        const std::string data{"generated-content"};
+        std::size_t offset{0};
+        http.sendStream([&data, &offset](char* buffer, std::size_t size) {
+            const auto count = data.copy(buffer, size, offset);
+            offset += count;
+            return count;
+        });
+        CHECK(transmitted == data);
+    }
+
+    TEST_CASE("Send encoded sets content encoding header", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+
+        curl_slist headers{};
+        ReadCallbackFn callback{nullptr};
+        void* userdata{nullptr};
+        std::string transmitted;
+        REQUIRE_CALL(curlMock, curl_slist_append(nullptr, _))
+            .WITH(std::string{_2} == "Content-Encoding: gzip")
+            .RETURN(&headers);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_HTTPHEADER, static_cast<void*>(&headers))).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_POSTFIELDS, static_cast<void*>(nullptr))).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_POSTFIELDSIZE_LARGE, long{7})).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READFUNCTION, ANY(ReadCallbackFn)))
+            .LR_SIDE_EFFECT(callback = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(userdata = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_perform(handle))
+            .LR_SIDE_EFFECT({
+                char buffer[4];
+                for (auto n = callback(buffer, 1, sizeof(buffer), userdata); n > 0; n = callback(buffer, 1, sizeof(buffer), userdata))
+                {
+                    transmitted.append(buffer, n);
+                }
+            })
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 204)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_HTTPHEADER, static_cast<void*>(nullptr))).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_slist_free_all(&headers));
+
+        http.sendEncoded("encoded", "gzip");
+        CHECK(transmitted == "encoded");
+    }
+
+    TEST_CASE("Send stream throws if producer throws", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+
+        curl_slist headers{};
+        ReadCallbackFn callback{nullptr};
+        void* userdata{nullptr};
+        ALLOW_CALL(curlMock, curl_slist_append(_, _)).RETURN(&headers);
+        ALLOW_CALL(curlMock, curl_slist_free_all(&headers));
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READFUNCTION, ANY(ReadCallbackFn)))
+            .LR_SIDE_EFFECT(callback = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(userdata = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_perform(handle))
+            .LR_SIDE_EFFECT({
+                char buffer[4];
+                CHECK(callback(buffer, 1, sizeof(buffer), userdata) == CURL_READFUNC_ABORT);
+            })
+            .RETURN(CURLE_ABORTED_BY_CALLBACK);
+
+        CHECK_THROWS_AS(http.sendStream([](char*, std::size_t) -> std::size_t { throw std::runtime_error{"Intentional"}; }), std::runtime_error);
+    }
+
     TEST_CASE("Send fails on unsuccessful execution", "[HttpTest]")
     {
         ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
@@ -226,6 +440,374 @@ namespace influxdb::test
         REQUIRE_THROWS_AS(http.send("content"), ServerError);
     }
 
+    TEST_CASE("Send reports lines the server is unable to parse", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+        FakeWriteServer server{[](const std::string&) {
+            return std::pair{400L, std::string{R"({"error":"unable to parse 'x,a=\"b\"': missing fields\nunable to parse 'y v=1i2': invalid number"})"}};
+        }};
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READFUNCTION, ANY(ReadCallbackFn)))
+            .LR_SIDE_EFFECT(server.readCallback = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(server.readUserdata = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEFUNCTION, ANY(WriteCallbackFn)))
+            .LR_SIDE_EFFECT(server.writeCallback = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(server.writeUserdata = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_POSTFIELDS, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_perform(handle)).LR_SIDE_EFFECT(server.serve()).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = server.responseCode)
+            .RETURN(CURLE_OK);
+        std::vector<std::pair<std::string, std::string>> rejected;
+        http.setRejectedLinesHandler([&rejected](std::string_view line, std::string_view reason) { rejected.emplace_back(line, reason); });
+
+        http.sendBuffers({"ok v=1", "\n", "x,a=\"b\"", "\n", "y v=1i2"});
+
+        CHECK(server.requests == std::vector<std::string>{"ok v=1\nx,a=\"b\"\ny v=1i2"});
+        CHECK(rejected == std::vector<std::pair<std::string, std::string>>{{"x,a=\"b\"", "missing fields"}, {"y v=1i2", "invalid number"}});
+    }
+
+    TEST_CASE("Send bisects partial writes to find rejected lines", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+        FakeWriteServer server{[](const std::string& body) {
+            if (body.find("conflict") != std::string::npos)
+            {
+                return std::pair{400L, std::string{R"({"error":"partial write: field type conflict dropped=1"})"}};
+            }
+            return std::pair{204L, std::string{}};
+        }};
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READFUNCTION, ANY(ReadCallbackFn)))
+            .LR_SIDE_EFFECT(server.readCallback = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(server.readUserdata = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEFUNCTION, ANY(WriteCallbackFn)))
+            .LR_SIDE_EFFECT(server.writeCallback = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(server.writeUserdata = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_POSTFIELDS, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_perform(handle)).LR_SIDE_EFFECT(server.serve()).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = server.responseCode)
+            .RETURN(CURLE_OK);
+        std::vector<std::pair<std::string, std::string>> rejected;
+        http.setRejectedLinesHandler([&rejected](std::string_view line, std::string_view reason) { rejected.emplace_back(line, reason); });
+
+        http.send("m v=0 1\nm v=1 2\nconflict v=2 3\nm v=3 4");
+
+        CHECK(server.requests == std::vector<std::string>{"m v=0 1\nm v=1 2\nconflict v=2 3\nm v=3 4",
+                                                          "m v=0 1\nm v=1 2\n",
+                                                          "conflict v=2 3\nm v=3 4\n",
+                                                          "conflict v=2 3\n",
+                                                          "m v=3 4\n"});
+        CHECK(rejected == std::vector<std::pair<std::string, std::string>>{{"conflict v=2 3", "partial write: field type conflict dropped=1"}});
+    }
+
+    TEST_CASE("Send does not resend lines without timestamp on partial writes", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+        FakeWriteServer server{[](const std::string& body) {
+            if (body.find("conflict") != std::string::npos)
+            {
+                return std::pair{400L, std::string{R"({"error":"partial write: field type conflict dropped=1"})"}};
+            }
+            return std::pair{204L, std::string{}};
+        }};
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READFUNCTION, ANY(ReadCallbackFn)))
+            .LR_SIDE_EFFECT(server.readCallback = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(server.readUserdata = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEFUNCTION, ANY(WriteCallbackFn)))
+            .LR_SIDE_EFFECT(server.writeCallback = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(server.writeUserdata = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_POSTFIELDS, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_perform(handle)).LR_SIDE_EFFECT(server.serve()).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = server.responseCode)
+            .RETURN(CURLE_OK);
+        std::vector<std::pair<std::string, std::string>> rejected;
+        http.setRejectedLinesHandler([&rejected](std::string_view line, std::string_view reason) { rejected.emplace_back(line, reason); });
+
+        http.send("m v=0\nconflict,t=a\\ b s=\"x y\" 3\nm v=\"a b\"");
+
+        CHECK(server.requests == std::vector<std::string>{"m v=0\nconflict,t=a\\ b s=\"x y\" 3\nm v=\"a b\"",
+                                                          "conflict,t=a\\ b s=\"x y\" 3\n"});
+        const std::string unresolved{"partial write: field type conflict dropped=1 (not resent as the line has no timestamp, it may have been written)"};
+        CHECK(rejected == std::vector<std::pair<std::string, std::string>>{{"m v=0", unresolved},
+                                                                           {"m v=\"a b\"", unresolved},
+                                                                           {"conflict,t=a\\ b s=\"x y\" 3", "partial write: field type conflict dropped=1"}});
+    }
+
+    TEST_CASE("Send throws on bad request without rejected lines", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+        FakeWriteServer server{[](const std::string&) {
+            return std::pair{400L, std::string{R"({"error":"database name required"})"}};
+        }};
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READFUNCTION, ANY(ReadCallbackFn)))
+            .LR_SIDE_EFFECT(server.readCallback = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(server.readUserdata = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEFUNCTION, ANY(WriteCallbackFn)))
+            .LR_SIDE_EFFECT(server.writeCallback = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(server.writeUserdata = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_POSTFIELDS, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_perform(handle)).LR_SIDE_EFFECT(server.serve()).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = server.responseCode)
+            .RETURN(CURLE_OK);
+        bool called{false};
+        http.setRejectedLinesHandler([&called](std::string_view, std::string_view) { called = true; });
+
+        REQUIRE_THROWS_AS(http.send("m v=0"), BadRequest);
+        CHECK_FALSE(called);
+    }
+
+    TEST_CASE("Send keeps invalid escapes of error messages", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+        FakeWriteServer server{[](const std::string&) {
+            return std::pair{400L, std::string{R"({"error":"invalid \u00e4 \u20ac \ud83d\ude00 \ud83d \uzz12 \u00"})"}};
+        }};
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READFUNCTION, ANY(ReadCallbackFn)))
+            .LR_SIDE_EFFECT(server.readCallback = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_READDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(server.readUserdata = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEFUNCTION, ANY(WriteCallbackFn)))
+            .LR_SIDE_EFFECT(server.writeCallback = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(server.writeUserdata = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_POSTFIELDS, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_perform(handle)).LR_SIDE_EFFECT(server.serve()).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = server.responseCode)
+            .RETURN(CURLE_OK);
+        http.setRejectedLinesHandler([](std::string_view, std::string_view) {});
+
+        std::string message;
+        try
+        {
+            http.send("m v=0");
+        }
+        catch (const BadRequest& e)
+        {
+            message = e.what();
+        }
+        CHECK(message.find("invalid \xc3\xa4 \xe2\x82\xac \xf0\x9f\x98\x80 \\ud83d \\uzz12 \\u00") != std::string::npos);
+    }
+
+    TEST_CASE("Timeouts configure curl", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_CONNECTTIMEOUT_MS, long{150})).TIMES(2).RETURN(CURLE_OK);
+        http.setConnectTimeout(std::chrono::milliseconds{150});
+
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_TIMEOUT_MS, long{300})).RETURN(CURLE_OK);
+        http.setWriteTimeout(std::chrono::milliseconds{300});
+
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_TIMEOUT_MS, long{2000})).RETURN(CURLE_OK);
+        http.setQueryTimeout(std::chrono::milliseconds{2000});
+    }
+
+    TEST_CASE("Hedged write is duplicated if not completed in time", "[HttpTest]")
+    {
+        CurlHandleDummy hedgeDummy;
+        CURL* hedgeHandle = &hedgeDummy;
+        CURLM* multiHandle = &hedgeDummy;
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(ReadCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+        ALLOW_CALL(curlMock, curl_multi_cleanup(multiHandle)).RETURN(CURLM_OK);
+
+        int handles{0};
+        ALLOW_CALL(curlMock, curl_easy_init()).LR_RETURN(++handles > 2 ? hedgeHandle : handle);
+        REQUIRE_CALL(curlMock, curl_multi_init()).RETURN(multiHandle);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(hedgeHandle, CURLOPT_URL, std::string{"http://otherhost:8086/write?db=test"})).RETURN(CURLE_OK);
+
+        HTTP http{"http://localhost:8086?db=test"};
+        http.enableHedgedWrites("http://otherhost:8086?db=test");
+
+        // The first endpoint never responds, the hedge endpoint responds immediately
+        bool hedged{false};
+        CURLMsg done{};
+        done.msg = CURLMSG_DONE;
+        done.easy_handle = hedgeHandle;
+        done.data.result = CURLE_OK;
+        REQUIRE_CALL(curlMock, curl_multi_add_handle(multiHandle, handle)).RETURN(CURLM_OK);
+        REQUIRE_CALL(curlMock, curl_multi_add_handle(multiHandle, hedgeHandle)).LR_SIDE_EFFECT(hedged = true).RETURN(CURLM_OK);
+        ALLOW_CALL(curlMock, curl_multi_perform(multiHandle, _)).RETURN(CURLM_OK);
+        ALLOW_CALL(curlMock, curl_multi_wait(multiHandle, _)).RETURN(CURLM_OK);
+        bool delivered{false};
+        ALLOW_CALL(curlMock, curl_multi_info_read(multiHandle, _))
+            .LR_RETURN(hedged && !std::exchange(delivered, true) ? &done : nullptr);
+        REQUIRE_CALL(curlMock, curl_easy_getinfo_(hedgeHandle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 204)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_multi_remove_handle(multiHandle, handle)).RETURN(CURLM_OK);
+        REQUIRE_CALL(curlMock, curl_multi_remove_handle(multiHandle, hedgeHandle)).RETURN(CURLM_OK);
+
+        http.send("m v=1 1");
+        CHECK(hedged);
+    }
+
+    TEST_CASE("Hedged write fails over immediately on connection error", "[HttpTest]")
+    {
+        CurlHandleDummy hedgeDummy;
+        CURL* hedgeHandle = &hedgeDummy;
+        CURLM* multiHandle = &hedgeDummy;
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(ReadCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+        ALLOW_CALL(curlMock, curl_multi_cleanup(multiHandle)).RETURN(CURLM_OK);
+
+        int handles{0};
+        ALLOW_CALL(curlMock, curl_easy_init()).LR_RETURN(++handles > 2 ? hedgeHandle : handle);
+        ALLOW_CALL(curlMock, curl_multi_init()).RETURN(multiHandle);
+
+        HTTP http{"http://localhost:8086?db=test"};
+        http.enableHedgedWrites("http://otherhost:8086?db=test");
+
+        std::vector<CURLMsg> messages(2);
+        messages[0].msg = CURLMSG_DONE;
+        messages[0].easy_handle = handle;
+        messages[0].data.result = CURLE_COULDNT_CONNECT;
+        messages[1].msg = CURLMSG_DONE;
+        messages[1].easy_handle = hedgeHandle;
+        messages[1].data.result = CURLE_OK;
+        std::size_t added{0};
+        std::size_t delivered{0};
+        ALLOW_CALL(curlMock, curl_multi_add_handle(multiHandle, _)).LR_SIDE_EFFECT(++added).RETURN(CURLM_OK);
+        ALLOW_CALL(curlMock, curl_multi_perform(multiHandle, _)).RETURN(CURLM_OK);
+        FORBID_CALL(curlMock, curl_multi_wait(multiHandle, _));
+        ALLOW_CALL(curlMock, curl_multi_info_read(multiHandle, _))
+            .LR_RETURN(delivered < added ? &messages[delivered++] : nullptr);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 0)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(hedgeHandle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 204)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_multi_remove_handle(multiHandle, _)).RETURN(CURLM_OK);
+
+        http.send("m v=1 1");
+        CHECK(added == 2);
+    }
+
+    TEST_CASE("Hedged writes skip messages with lines without timestamp", "[HttpTest]")
+    {
+        CurlHandleDummy hedgeDummy;
+        CURL* hedgeHandle = &hedgeDummy;
+        CURLM* multiHandle = &hedgeDummy;
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(ReadCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+        ALLOW_CALL(curlMock, curl_multi_cleanup(multiHandle)).RETURN(CURLM_OK);
+
+        int handles{0};
+        ALLOW_CALL(curlMock, curl_easy_init()).LR_RETURN(++handles > 2 ? hedgeHandle : handle);
+        ALLOW_CALL(curlMock, curl_multi_init()).RETURN(multiHandle);
+
+        HTTP http{"http://localhost:8086?db=test"};
+        http.enableHedgedWrites("http://otherhost:8086?db=test");
+
+        // Each server would assign its own time to the lines, storing them twice
+        FORBID_CALL(curlMock, curl_multi_add_handle(multiHandle, _));
+        REQUIRE_CALL(curlMock, curl_easy_perform(handle)).TIMES(2).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 204)
+            .RETURN(CURLE_OK);
+
+        http.send("m v=1");
+        http.sendBuffers({"m v=1 1", "\n", "m v=2"});
+    }
+
     TEST_CASE("Query configures curl", "[HttpTest]")
     {
         ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
@@ -362,6 +944,298 @@ namespace influxdb::test
         REQUIRE_THROWS_AS(http.query(query), ServerError);
     }
 
+    TEST_CASE("Query requests epoch timestamps if enabled", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+        ALLOW_CALL(curlMock, curl_easy_perform(handle)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 200)
+            .RETURN(CURLE_OK);
+
+        HTTP http{"http://localhost:8086?db=test"};
+        http.enableEpochTimestamps();
+
+        std::string query{"q"};
+        ALLOW_CALL(curlMock, curl_easy_escape(handle, _, _)).RETURN(&query[0]);
+        ALLOW_CALL(curlMock, curl_free(_));
+
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(_, CURLOPT_URL, "http://localhost:8086/query?db=test&epoch=ns&q=q")).RETURN(CURLE_OK);
+        http.query(query);
+
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(_, CURLOPT_URL, "http://localhost:8086/query?db=test&chunked=true&chunk_size=10000&epoch=ns&q=q")).RETURN(CURLE_OK);
+        http.queryChunked(query, [](std::string_view) {});
+    }
+
+    TEST_CASE("Query format sets accept header", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        curl_slist csvHeaders{};
+        curl_slist msgPackHeaders{};
+        REQUIRE_CALL(curlMock, curl_slist_append(nullptr, _))
+            .WITH(std::string{_2} == "Accept: application/csv")
+            .RETURN(&csvHeaders);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_HTTPHEADER, static_cast<void*>(&csvHeaders))).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_slist_free_all(&csvHeaders));
+        REQUIRE_CALL(curlMock, curl_slist_append(nullptr, _))
+            .WITH(std::string{_2} == "Accept: application/x-msgpack")
+            .RETURN(&msgPackHeaders);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_HTTPHEADER, static_cast<void*>(&msgPackHeaders))).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_slist_free_all(&msgPackHeaders));
+
+        HTTP http{"http://localhost:8086?db=test"};
+        http.setQueryFormat(HTTP::QueryFormat::Csv);
+        http.setQueryFormat(HTTP::QueryFormat::MessagePack);
+    }
+
+    TEST_CASE("Query format keeps headers of running queries", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, CURLOPT_WRITEDATA, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(_, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 200)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        curl_slist csvHeaders{};
+        curl_slist msgPackHeaders{};
+        ALLOW_CALL(curlMock, curl_slist_append(nullptr, _))
+            .WITH(std::string{_2} == "Accept: application/csv")
+            .RETURN(&csvHeaders);
+        ALLOW_CALL(curlMock, curl_slist_append(nullptr, _))
+            .WITH(std::string{_2} == "Accept: application/x-msgpack")
+            .RETURN(&msgPackHeaders);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_HTTPHEADER, ANY(void*))).RETURN(CURLE_OK);
+        bool csvFreed{false};
+        REQUIRE_CALL(curlMock, curl_slist_free_all(&csvHeaders)).LR_SIDE_EFFECT(csvFreed = true);
+        REQUIRE_CALL(curlMock, curl_slist_free_all(&msgPackHeaders));
+
+        HTTP http{"http://localhost:8086?db=test"};
+        http.setQueryFormat(HTTP::QueryFormat::Csv);
+        std::string escaped{"q"};
+        ALLOW_CALL(curlMock, curl_easy_escape(handle, _, _)).RETURN(escaped.data());
+        ALLOW_CALL(curlMock, curl_free(_));
+        bool freedWhileRunning{true};
+        REQUIRE_CALL(curlMock, curl_easy_perform(handle))
+            .LR_SIDE_EFFECT({
+                http.setQueryFormat(HTTP::QueryFormat::MessagePack);
+                freedWhileRunning = csvFreed;
+            })
+            .RETURN(CURLE_OK);
+        http.query("q");
+        CHECK_FALSE(freedWhileRunning);
+        CHECK(csvFreed);
+    }
+
+    TEST_CASE("Query timeout is applied to running queries once they complete", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, CURLOPT_WRITEDATA, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(_, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 200)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+        std::string escaped{"q"};
+        ALLOW_CALL(curlMock, curl_easy_escape(handle, _, _)).RETURN(escaped.data());
+        ALLOW_CALL(curlMock, curl_free(_));
+
+        HTTP http{"http://localhost:8086?db=test"};
+        bool running{false};
+        bool appliedWhileRunning{false};
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_TIMEOUT_MS, 777L))
+            .LR_SIDE_EFFECT(appliedWhileRunning = running)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_perform(handle))
+            .LR_SIDE_EFFECT({
+                running = true;
+                http.setQueryTimeout(std::chrono::milliseconds{777});
+                running = false;
+            })
+            .RETURN(CURLE_OK);
+        http.query("q");
+        CHECK_FALSE(appliedWhileRunning);
+    }
+
+    TEST_CASE("Query chunked configures curl", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+
+        const std::string query{"/12?ab=cd"};
+        std::string returnValue = query;
+        char* ptr = &returnValue[0];
+        WriteCallbackFn callback{nullptr};
+        void* userdata{nullptr};
+        std::string chunk0{"{\"results\":[]}\n"};
+        std::string chunk1{"{\"results\":[]}\n"};
+        REQUIRE_CALL(curlMock, curl_easy_escape(handle, query.c_str(), static_cast<int>(query.size()))).RETURN(ptr);
+        ALLOW_CALL(curlMock, curl_free(ptr));
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(_, CURLOPT_URL, "http://localhost:8086/query?db=test&chunked=true&chunk_size=10000&q=/12?ab=cd")).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(_, CURLOPT_WRITEFUNCTION, ANY(WriteCallbackFn)))
+            .LR_SIDE_EFFECT(callback = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(_, CURLOPT_WRITEDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(userdata = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_perform(handle))
+            .LR_SIDE_EFFECT(callback(&chunk0[0], 1, chunk0.size(), userdata))
+            .LR_SIDE_EFFECT(callback(&chunk1[0], 1, chunk1.size(), userdata))
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 200)
+            .RETURN(CURLE_OK);
+
+        std::vector<std::string> chunks;
+        http.queryChunked(query, [&chunks](std::string_view chunk) { chunks.emplace_back(chunk); });
+        CHECK(chunks == std::vector<std::string>{chunk0, chunk1});
+    }
+
+    TEST_CASE("Query chunked does not pass response of unsuccessful request", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+
+        const std::string query{"/x?shouldfail=true"};
+        std::string returnValue = query;
+        char* ptr = &returnValue[0];
+        WriteCallbackFn callback{nullptr};
+        void* userdata{nullptr};
+        std::string chunk{"{\"error\":\"intentional\"}"};
+        ALLOW_CALL(curlMock, curl_easy_escape(handle, query.c_str(), static_cast<int>(query.size()))).RETURN(ptr);
+        ALLOW_CALL(curlMock, curl_free(_));
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(_, CURLOPT_WRITEFUNCTION, ANY(WriteCallbackFn)))
+            .LR_SIDE_EFFECT(callback = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(_, CURLOPT_WRITEDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(userdata = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_perform(handle))
+            .LR_SIDE_EFFECT(callback(&chunk[0], 1, chunk.size(), userdata))
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 400)
+            .RETURN(CURLE_OK);
+
+        bool called{false};
+        REQUIRE_THROWS_AS(http.queryChunked(query, [&called](std::string_view) { called = true; }), BadRequest);
+        CHECK(called == false);
+    }
+
+    TEST_CASE("Query cancellable aborts transfer if cancelled", "[HttpTest]")
+    {
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, CURLOPT_WRITEDATA, ANY(void*))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+
+        HTTP http{"http://localhost:8086?db=test"};
+
+        const std::string query{"select * from x"};
+        std::string returnValue = query;
+        char* ptr = &returnValue[0];
+        XferInfoCallbackFn progress{nullptr};
+        void* progressData{nullptr};
+        ALLOW_CALL(curlMock, curl_easy_escape(handle, _, _)).RETURN(ptr);
+        ALLOW_CALL(curlMock, curl_free(_));
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_XFERINFOFUNCTION, ANY(XferInfoCallbackFn)))
+            .LR_SIDE_EFFECT(progress = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_XFERINFODATA, ANY(void*)))
+            .LR_SIDE_EFFECT(progressData = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_NOPROGRESS, 0L)).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_NOPROGRESS, 1L)).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_perform(handle))
+            .RETURN(progress(progressData, 0, 0, 0, 0) != 0 ? CURLE_ABORTED_BY_CALLBACK : CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(handle, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 0)
+            .RETURN(CURLE_OK);
+
+        REQUIRE_THROWS_AS(http.queryCancellable(query, [](std::string_view) {}, [] { return true; }), QueryCancelled);
+    }
+
+    TEST_CASE("Query while another query runs uses separate read handle", "[HttpTest]")
+    {
+        CurlHandleDummy otherDummy;
+        CURL* otherHandle = &otherDummy;
+        ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_init()).RETURN(handle);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(std::string))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(long))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(_, _, ANY(WriteCallbackFn))).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_cleanup(_));
+        ALLOW_CALL(curlMock, curl_global_cleanup());
+        std::string escaped{"select"};
+        ALLOW_CALL(curlMock, curl_easy_escape(_, _, _)).RETURN(&escaped[0]);
+        ALLOW_CALL(curlMock, curl_free(_));
+
+        HTTP http{"http://localhost:8086?db=test"};
+        http.setQueryTimeout(std::chrono::milliseconds{345});
+
+        REQUIRE_CALL(curlMock, curl_easy_init()).RETURN(otherHandle);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(otherHandle, CURLOPT_TIMEOUT_MS, 345L)).RETURN(CURLE_OK);
+        WriteCallbackFn callback{nullptr};
+        void* userdata{nullptr};
+        std::string chunk{"{\"results\":[]}\n"};
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEFUNCTION, ANY(WriteCallbackFn)))
+            .LR_SIDE_EFFECT(callback = _3)
+            .RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_setopt_(handle, CURLOPT_WRITEDATA, ANY(void*)))
+            .LR_SIDE_EFFECT(userdata = _3)
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_setopt_(otherHandle, CURLOPT_WRITEDATA, ANY(void*))).RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_perform(handle))
+            .LR_SIDE_EFFECT(callback(&chunk[0], 1, chunk.size(), userdata))
+            .RETURN(CURLE_OK);
+        REQUIRE_CALL(curlMock, curl_easy_perform(otherHandle)).RETURN(CURLE_OK);
+        ALLOW_CALL(curlMock, curl_easy_getinfo_(_, CURLINFO_RESPONSE_CODE, _))
+            .LR_SIDE_EFFECT(*static_cast<long*>(_3) = 200)
+            .RETURN(CURLE_OK);
+
+        http.queryChunked("select 1", [&http](std::string_view) { http.query("select 2"); });
+    }
+
     TEST_CASE("Create database configures curl", "[HttpTest]")
     {
         ALLOW_CALL(curlMock, curl_global_init(_)).RETURN(CURLE_OK);
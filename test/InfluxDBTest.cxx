@@ -58,6 +58,26 @@ namespace influxdb::test
                   Point{"p2"}.addField("f2", 2).setTimestamp(ignoreTimestamp)});
     }
 
+    TEST_CASE("Write stream transmits generated points", "[InfluxDBTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*mock, send("p0,x=1 f0=0i 4567000000\np1,x=1 f1=1i 4567000000\np2,x=1 f2=2i 4567000000"));
+
+        InfluxDB db{std::make_unique<TransportAdapter>(mock)};
+        db.addGlobalTag("x", "1");
+        db.batchOf(2);
+
+        int count{0};
+        db.writeStream([&count]() -> std::optional<Point> {
+            if (count == 3)
+            {
+                return std::nullopt;
+            }
+            const auto n = count++;
+            return Point{"p" + std::to_string(n)}.addField("f" + std::to_string(n), n).setTimestamp(ignoreTimestamp);
+        });
+    }
+
     TEST_CASE("Write adds global tags", "[InfluxDBTest]")
     {
         auto mock = std::make_shared<TransportMock>();
@@ -125,6 +145,22 @@ namespace influxdb::test
         db.flushBatch();
     }
 
+    TEST_CASE("Flush transport transmits pending points and flushes transport", "[InfluxDBTest]")
+    {
+        using trompeloeil::_;
+
+        auto mock = std::make_shared<TransportMock>();
+
+        InfluxDB db{std::make_unique<TransportAdapter>(mock)};
+        db.batchOf(300);
+        db.write(Point{"x"}.setTimestamp(ignoreTimestamp));
+
+        trompeloeil::sequence seq;
+        REQUIRE_CALL(*mock, send("x 4567000000")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, flush()).IN_SEQUENCE(seq);
+        db.flushTransport();
+    }
+
     TEST_CASE("Destructs cleanly with pending batches", "[InfluxDBTest]")
     {
         using trompeloeil::_;
@@ -169,4 +205,54 @@ namespace influxdb::test
         InfluxDB db{std::make_unique<TransportAdapter>(mock)};
         db.createDatabaseIfNotExists();
     }
+
+    TEST_CASE("Query cache answers repeated queries without transport", "[InfluxDBTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*mock, query("SELECT * FROM cpu"))
+            .RETURN(R"({"results":[{"statement_id":0,"series":[{"name":"cpu","columns":["time","v"],"values":[["2021-01-01T00:00:00Z",1]]}]}]})")
+            .TIMES(1);
+
+        InfluxDB db{std::make_unique<TransportAdapter>(mock)};
+        db.enableQueryCache(std::chrono::minutes{1});
+        CHECK(db.query("SELECT * FROM cpu").size() == 1);
+        CHECK(db.execute("SELECT  * FROM cpu;").statements.at(0).series.at(0).rows() == 1);
+        CHECK_THROWS_AS(db.enableQueryCache(std::chrono::minutes{1}), InfluxDBException);
+    }
+
+    TEST_CASE("Query async returns result through future", "[InfluxDBTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*mock, query("SELECT * FROM cpu"))
+            .RETURN(R"({"results":[{"statement_id":0,"series":[{"name":"cpu","columns":["time","v"],"values":[["2021-01-01T00:00:00Z",1],["2021-01-01T00:00:01Z",2]]}]}]})");
+
+        InfluxDB db{std::make_unique<TransportAdapter>(mock)};
+        auto points = db.queryAsync("SELECT * FROM cpu");
+        CHECK(points.get().size() == 2);
+    }
+
+    TEST_CASE("Query async throws if cancelled", "[InfluxDBTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        FORBID_CALL(*mock, query(trompeloeil::_));
+
+        InfluxDB db{std::make_unique<TransportAdapter>(mock)};
+        CancellationToken cancellation;
+        cancellation.cancel();
+        auto result = db.executeAsync("SELECT * FROM cpu", cancellation);
+        CHECK_THROWS_AS(result.get(), QueryCancelled);
+    }
+
+    TEST_CASE("Write with schema cache throws on field type conflict before sending", "[InfluxDBTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*mock, query("SHOW MEASUREMENTS; SHOW FIELD KEYS; SHOW TAG KEYS"))
+            .RETURN(R"({"results":[{"statement_id":0},{"statement_id":1,"series":[{"name":"cpu","columns":["fieldKey","fieldType"],"values":[["load","float"]]}]},{"statement_id":2}]})");
+        REQUIRE_CALL(*mock, send("cpu load=0.500000000000000000 4567000000"));
+
+        InfluxDB db{std::make_unique<TransportAdapter>(mock)};
+        db.enableSchemaCache();
+        db.write(Point{"cpu"}.addField("load", 0.5).setTimestamp(ignoreTimestamp));
+        CHECK_THROWS_AS(db.write({Point{"cpu"}.addField("load", 0.5), Point{"cpu"}.addField("load", 1)}), SchemaConflict);
+    }
 }
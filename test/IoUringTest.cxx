@@ -0,0 +1,128 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "IoUring.h"
+#include "InfluxDBException.h"
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <map>
+#include <unistd.h>
+
+namespace influxdb::test
+{
+    using internal::IoUring;
+
+    namespace
+    {
+        /// Pipe closed at the end of the test
+        struct Pipe
+        {
+            Pipe()
+            {
+                REQUIRE(::pipe(fds) == 0);
+            }
+
+            ~Pipe()
+            {
+                ::close(fds[0]);
+                ::close(fds[1]);
+            }
+
+            std::string read(std::size_t size)
+            {
+                std::string buffer(size, '\0');
+                REQUIRE(::read(fds[0], buffer.data(), size) == static_cast<ssize_t>(size));
+                return buffer;
+            }
+
+            int fds[2];
+        };
+
+        char* copyInto(IoUring& ring, std::size_t offset, std::string_view data)
+        {
+            char* target = ring.buffer() + offset;
+            std::memcpy(target, data.data(), data.size());
+            return target;
+        }
+    }
+
+    TEST_CASE("io_uring writes from the registered buffer by one submission", "[IoUringTest]")
+    {
+        if (!IoUring::available())
+        {
+            CHECK_THROWS_AS(IoUring(4, 4096), InfluxDBException);
+            return;
+        }
+
+        Pipe pipe;
+        IoUring ring{4, 4096};
+        CHECK(ring.bufferSize() == 4096);
+        CHECK(ring.entries() == 4);
+
+        CHECK(ring.write(pipe.fds[1], copyInto(ring, 0, "abc"), 3, 1));
+        CHECK(ring.write(pipe.fds[1], copyInto(ring, 3, "de"), 2, 2));
+
+        std::map<std::uint64_t, int> results;
+        ring.submit([&results](std::uint64_t tag, int result) { results[tag] = result; });
+
+        CHECK(results == std::map<std::uint64_t, int>{{1, 3}, {2, 2}});
+        CHECK(pipe.read(5) == "abcde");
+    }
+
+    TEST_CASE("io_uring rejects writes exceeding the submission queue", "[IoUringTest]")
+    {
+        if (!IoUring::available())
+        {
+            return;
+        }
+
+        Pipe pipe;
+        IoUring ring{2, 4096};
+        const char* data = copyInto(ring, 0, "x");
+        CHECK(ring.write(pipe.fds[1], data, 1, 0));
+        CHECK(ring.write(pipe.fds[1], data, 1, 0));
+        CHECK_FALSE(ring.write(pipe.fds[1], data, 1, 0));
+
+        std::size_t completed{0};
+        ring.submit([&completed](std::uint64_t, int) { ++completed; });
+        CHECK(completed == 2);
+        CHECK(ring.write(pipe.fds[1], data, 1, 0));
+        ring.submit([&completed](std::uint64_t, int) { ++completed; });
+        CHECK(completed == 3);
+        CHECK(pipe.read(3) == "xxx");
+    }
+
+    TEST_CASE("io_uring reports failed writes", "[IoUringTest]")
+    {
+        if (!IoUring::available())
+        {
+            return;
+        }
+
+        IoUring ring{2, 4096};
+        int result{0};
+        CHECK(ring.write(-1, ring.buffer(), 1, 0));
+        ring.submit([&result](std::uint64_t, int value) { result = value; });
+        CHECK(result == -EBADF);
+    }
+}
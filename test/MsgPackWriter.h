@@ -0,0 +1,134 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace influxdb::test
+{
+    /// Writes MessagePack documents as sent by InfluxDB for tests
+    class MsgPackWriter
+    {
+    public:
+        MsgPackWriter& map(std::size_t entries)
+        {
+            return header(0x80, 0xde, entries);
+        }
+
+        MsgPackWriter& array(std::size_t elements)
+        {
+            return header(0x90, 0xdc, elements);
+        }
+
+        MsgPackWriter& string(std::string_view value)
+        {
+            if (value.size() < 32)
+            {
+                data.push_back(static_cast<char>(0xa0 | value.size()));
+            }
+            else
+            {
+                data.push_back(static_cast<char>(0xda));
+                bigEndian(value.size(), 2);
+            }
+            data.append(value);
+            return *this;
+        }
+
+        MsgPackWriter& integer(std::int64_t value)
+        {
+            if (value >= 0 && value < 128)
+            {
+                data.push_back(static_cast<char>(value));
+            }
+            else
+            {
+                data.push_back(static_cast<char>(0xd3));
+                bigEndian(static_cast<std::uint64_t>(value), 8);
+            }
+            return *this;
+        }
+
+        MsgPackWriter& real(double value)
+        {
+            std::uint64_t bits{0};
+            static_assert(sizeof(bits) == sizeof(value));
+            std::memcpy(&bits, &value, sizeof(bits));
+            data.push_back(static_cast<char>(0xcb));
+            bigEndian(bits, 8);
+            return *this;
+        }
+
+        MsgPackWriter& boolean(bool value)
+        {
+            data.push_back(static_cast<char>(value ? 0xc3 : 0xc2));
+            return *this;
+        }
+
+        MsgPackWriter& nil()
+        {
+            data.push_back(static_cast<char>(0xc0));
+            return *this;
+        }
+
+        /// Writes a timestamp as msgp time extension, as used by InfluxDB
+        MsgPackWriter& time(std::int64_t nanoseconds)
+        {
+            data.push_back(static_cast<char>(0xc7));
+            data.push_back(12);
+            data.push_back(5);
+            bigEndian(static_cast<std::uint64_t>(nanoseconds / 1000000000), 8);
+            bigEndian(static_cast<std::uint64_t>(nanoseconds % 1000000000), 4);
+            return *this;
+        }
+
+        std::string data;
+
+    private:
+        MsgPackWriter& header(unsigned char fixed, unsigned char sized, std::size_t size)
+        {
+            if (size < 16)
+            {
+                data.push_back(static_cast<char>(fixed | size));
+            }
+            else
+            {
+                data.push_back(static_cast<char>(sized + 1));
+                bigEndian(size, 4);
+            }
+            return *this;
+        }
+
+        void bigEndian(std::uint64_t value, std::size_t bytes)
+        {
+            for (std::size_t i = bytes; i > 0; --i)
+            {
+                data.push_back(static_cast<char>((value >> ((i - 1) * 8)) & 0xff));
+            }
+        }
+    };
+}
@@ -26,24 +26,6 @@
 
 namespace influxdb::test
 {
-    namespace
-    {
-        struct TransportDummy : public Transport
-        {
-            void send([[maybe_unused]] std::string&& message) override
-            {
-            }
-        };
-
-        TransportDummy dummy;
-    }
-
-
-    TEST_CASE("Query impl throws unconditionally", "[NoBoostSupportTest]")
-    {
-        CHECK_THROWS_AS(internal::queryImpl(&dummy, "-ignore-"), InfluxDBException);
-    }
-
     TEST_CASE("With UDP throws transport unconditionally", "[NoBoostSupportTest]")
     {
         CHECK_THROWS_AS(internal::withUdpTransport(http::url{}), InfluxDBException);
@@ -54,4 +36,9 @@ namespace influxdb::test
         CHECK_THROWS_AS(internal::withUnixSocketTransport(http::url{}), InfluxDBException);
     }
 
+    TEST_CASE("With TCP transport throws unconditionally", "[NoBoostSupportTest]")
+    {
+        CHECK_THROWS_AS(internal::withTcpTransport(http::url{}), InfluxDBException);
+    }
+
 }
@@ -0,0 +1,260 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "QueryCache.h"
+#include "InfluxDBException.h"
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace influxdb::test
+{
+    namespace
+    {
+        struct CountingTransportStub : public Transport
+        {
+            void send([[maybe_unused]] std::string&& message) override
+            {
+            }
+
+            void queryChunked(const std::string& query, const std::function<void(std::string_view)>& onChunk) override
+            {
+                {
+                    std::unique_lock<std::mutex> lock{mutex};
+                    ++requests;
+                    started.notify_all();
+                    released.wait(lock, [this] { return !blocked; });
+                }
+                if (failing)
+                {
+                    throw InfluxDBException{"Test", "query failed"};
+                }
+                onChunk("response of ");
+                onChunk(query);
+            }
+
+            void release()
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                blocked = false;
+                released.notify_all();
+            }
+
+            void waitForRequest()
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                started.wait(lock, [this] { return requests > 0; });
+            }
+
+            std::mutex mutex;
+            std::condition_variable started;
+            std::condition_variable released;
+            std::size_t requests{0};
+            bool blocked{false};
+            bool failing{false};
+        };
+
+        constexpr std::chrono::hours longTtl{1};
+    }
+
+    TEST_CASE("Query cache normalizes whitespace outside of quotes", "[QueryCacheTest]")
+    {
+        CHECK(internal::QueryCache::normalize("  SELECT *\n\tFROM  cpu ; ") == "SELECT * FROM cpu");
+        CHECK(internal::QueryCache::normalize("SELECT * FROM \"my  cpu\" WHERE host = 'a  b;'") == "SELECT * FROM \"my  cpu\" WHERE host = 'a  b;'");
+        CHECK(internal::QueryCache::normalize("SELECT 'it\\'s  x'") == "SELECT 'it\\'s  x'");
+    }
+
+    TEST_CASE("Query cache answers repeated queries from cache", "[QueryCacheTest]")
+    {
+        auto stub = std::make_unique<CountingTransportStub>();
+        auto& transport = *stub;
+        internal::QueryCache cache{std::move(stub), longTtl, 1024};
+
+        CHECK(cache.query("SELECT * FROM cpu") == "response of SELECT * FROM cpu");
+        CHECK(cache.query("SELECT  *  FROM cpu;") == "response of SELECT * FROM cpu");
+        CHECK(cache.query("SELECT * FROM mem") == "response of SELECT * FROM mem");
+
+        CHECK(transport.requests == 2);
+        CHECK(cache.statistics().hits == 1);
+        CHECK(cache.statistics().misses == 2);
+    }
+
+    TEST_CASE("Query cache does not use expired responses", "[QueryCacheTest]")
+    {
+        auto stub = std::make_unique<CountingTransportStub>();
+        auto& transport = *stub;
+        internal::QueryCache cache{std::move(stub), std::chrono::milliseconds{0}, 1024};
+
+        cache.query("SELECT * FROM cpu");
+        cache.query("SELECT * FROM cpu");
+
+        CHECK(transport.requests == 2);
+    }
+
+    TEST_CASE("Query cache evicts least recently used responses", "[QueryCacheTest]")
+    {
+        auto stub = std::make_unique<CountingTransportStub>();
+        auto& transport = *stub;
+        // Overhead, key (stored twice) and response of each entry
+        constexpr std::size_t entrySize{128 + 2 * 2 + 14};
+        internal::QueryCache cache{std::move(stub), longTtl, 2 * entrySize};
+
+        cache.query("q1");
+        cache.query("q2");
+        cache.query("q1");
+        cache.query("q3");
+        CHECK(transport.requests == 3);
+
+        cache.query("q1");
+        CHECK(transport.requests == 3);
+        cache.query("q2");
+        CHECK(transport.requests == 4);
+    }
+
+    TEST_CASE("Query cache does not store responses exceeding the cap", "[QueryCacheTest]")
+    {
+        auto stub = std::make_unique<CountingTransportStub>();
+        auto& transport = *stub;
+        internal::QueryCache cache{std::move(stub), longTtl, 16};
+
+        CHECK(cache.query("SELECT * FROM cpu") == "response of SELECT * FROM cpu");
+        CHECK(cache.query("SELECT * FROM cpu") == "response of SELECT * FROM cpu");
+        CHECK(transport.requests == 2);
+    }
+
+    TEST_CASE("Query cache shares the request of concurrent calls", "[QueryCacheTest]")
+    {
+        auto stub = std::make_unique<CountingTransportStub>();
+        auto& transport = *stub;
+        transport.blocked = true;
+        internal::QueryCache cache{std::move(stub), std::chrono::milliseconds{0}, 1024};
+
+        std::string first;
+        std::string second;
+        std::thread leader{[&] { first = cache.query("SELECT * FROM cpu"); }};
+        transport.waitForRequest();
+        std::thread follower{[&] { second = cache.query("SELECT * FROM cpu"); }};
+        while (cache.statistics().coalesced == 0)
+        {
+            std::this_thread::yield();
+        }
+        transport.release();
+        leader.join();
+        follower.join();
+
+        CHECK(transport.requests == 1);
+        CHECK(first == "response of SELECT * FROM cpu");
+        CHECK(second == first);
+    }
+
+    TEST_CASE("Query cache passes errors to all calls sharing the request", "[QueryCacheTest]")
+    {
+        auto stub = std::make_unique<CountingTransportStub>();
+        auto& transport = *stub;
+        transport.blocked = true;
+        transport.failing = true;
+        internal::QueryCache cache{std::move(stub), longTtl, 1024};
+
+        std::atomic<int> failures{0};
+        const auto run = [&] {
+            try
+            {
+                cache.query("SELECT * FROM cpu");
+            }
+            catch (const InfluxDBException&)
+            {
+                ++failures;
+            }
+        };
+        std::thread leader{run};
+        transport.waitForRequest();
+        std::thread follower{run};
+        while (cache.statistics().coalesced == 0)
+        {
+            std::this_thread::yield();
+        }
+        transport.release();
+        leader.join();
+        follower.join();
+
+        CHECK(transport.requests == 1);
+        CHECK(failures == 2);
+
+        transport.failing = false;
+        CHECK(cache.query("SELECT * FROM cpu") == "response of SELECT * FROM cpu");
+    }
+
+    TEST_CASE("Query cache aborts the request if the handler fails", "[QueryCacheTest]")
+    {
+        auto stub = std::make_unique<CountingTransportStub>();
+        auto& transport = *stub;
+        internal::QueryCache cache{std::move(stub), longTtl, 1024};
+
+        std::size_t chunks{0};
+        CHECK_THROWS_AS(cache.queryChunked("SELECT * FROM cpu",
+                                           [&chunks](std::string_view) {
+                                               ++chunks;
+                                               throw InfluxDBException{"Test", "handler failed"};
+                                           }),
+                        InfluxDBException);
+        CHECK(chunks == 1);
+        CHECK(cache.query("SELECT * FROM cpu") == "response of SELECT * FROM cpu");
+        CHECK(transport.requests == 2);
+    }
+
+    TEST_CASE("Query cache stops waiting for a shared request once cancelled", "[QueryCacheTest]")
+    {
+        auto stub = std::make_unique<CountingTransportStub>();
+        auto& transport = *stub;
+        transport.blocked = true;
+        internal::QueryCache cache{std::move(stub), longTtl, 1024};
+
+        std::string first;
+        std::thread leader{[&] { first = cache.query("SELECT * FROM cpu"); }};
+        transport.waitForRequest();
+        CHECK_THROWS_AS(cache.queryCancellable("SELECT * FROM cpu", [](std::string_view) {}, [] { return true; }), QueryCancelled);
+        transport.release();
+        leader.join();
+
+        CHECK(first == "response of SELECT * FROM cpu");
+        CHECK(transport.requests == 1);
+    }
+
+    TEST_CASE("Query cache passes other calls to the transport", "[QueryCacheTest]")
+    {
+        auto stub = std::make_unique<CountingTransportStub>();
+        auto& transport = *stub;
+        internal::QueryCache cache{std::move(stub), longTtl, 1024};
+
+        std::string response;
+        cache.queryCancellable("SELECT * FROM cpu", [&response](std::string_view chunk) { response.append(chunk); }, [] { return false; });
+        CHECK(response == "response of SELECT * FROM cpu");
+        CHECK(cache.query("SELECT * FROM cpu") == response);
+        CHECK(transport.requests == 1);
+        CHECK_THROWS_AS(cache.setRejectedLinesHandler({}), InfluxDBException);
+        CHECK_THROWS_AS(internal::QueryCache(nullptr, longTtl, 1024), InfluxDBException);
+    }
+}
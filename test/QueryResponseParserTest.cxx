@@ -0,0 +1,290 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "QueryResponseParser.h"
+#include "CsvResponseParser.h"
+#include "MsgPackResponseParser.h"
+#include "MsgPackWriter.h"
+#include "InfluxDBException.h"
+#include <catch2/catch.hpp>
+
+namespace influxdb::test
+{
+    namespace
+    {
+        struct RecordingHandler : public internal::QueryResponseHandler
+        {
+            void onStatement(std::size_t statementId) override
+            {
+                events.push_back("statement " + std::to_string(statementId));
+            }
+
+            void onStatementError(std::string_view error) override
+            {
+                events.push_back("error " + std::string{error});
+            }
+
+            void onSeries(std::string_view name, const std::vector<std::pair<std::string_view, std::string_view>>& tags,
+                          const std::vector<std::string_view>& columns) override
+            {
+                std::string event{"series " + std::string{name}};
+                for (const auto& [key, value] : tags)
+                {
+                    event.append(" ").append(key).append("=").append(value);
+                }
+                event.append(" |");
+                for (const auto& column : columns)
+                {
+                    event.append(" ").append(column);
+                }
+                events.push_back(event);
+            }
+
+            void onRow(const std::vector<internal::ResponseValue>& values) override
+            {
+                static constexpr const char* types[] = {"null", "bool", "number", "string", "integer", "float", "time"};
+                std::string event{"row"};
+                for (const auto& value : values)
+                {
+                    event.append(" ").append(types[static_cast<int>(value.type)]).append(":");
+                    switch (value.type)
+                    {
+                        case internal::ResponseValue::Type::Integer:
+                        case internal::ResponseValue::Type::Time:
+                            event.append(std::to_string(value.integer));
+                            break;
+                        case internal::ResponseValue::Type::Float:
+                            event.append(std::to_string(value.real));
+                            break;
+                        default:
+                            event.append(value.text);
+                            break;
+                    }
+                }
+                events.push_back(event);
+            }
+
+            void onStatementEnd() override
+            {
+                events.push_back("end");
+            }
+
+            std::vector<std::string> events;
+        };
+    }
+
+    TEST_CASE("Parser passes statements, series and rows", "[QueryResponseParserTest]")
+    {
+        internal::QueryResponseParser parser;
+        RecordingHandler handler;
+
+        parser.parse(R"({"results":[{"statement_id":0,"series":[{"name":"cpu","tags":{"host":"a"},"columns":["time","value","ok","note"],)"
+                     R"("values":[["2021-01-01T00:00:00Z",1.5,true,null],["2021-01-01T00:00:01Z",-2e3,false,"x"]]}]},)"
+                     R"({"statement_id":1}]})",
+                     handler);
+
+        CHECK(handler.events == std::vector<std::string>{"statement 0",
+                                                         "series cpu host=a | time value ok note",
+                                                         "row string:2021-01-01T00:00:00Z number:1.5 bool:true null:null",
+                                                         "row string:2021-01-01T00:00:01Z number:-2e3 bool:false string:x",
+                                                         "end",
+                                                         "statement 1",
+                                                         "end"});
+    }
+
+    TEST_CASE("Parser unescapes strings", "[QueryResponseParserTest]")
+    {
+        internal::QueryResponseParser parser;
+        RecordingHandler handler;
+
+        parser.parse(R"({"results":[{"statement_id":0,"series":[{"name":"a\"b","columns":["v"],"values":[["x\\y\n\u00e9\ud83d\ude00"]]}]}]})", handler);
+
+        CHECK(handler.events.at(1) == "series a\"b | v");
+        CHECK(handler.events.at(2) == "row string:x\\y\n\xc3\xa9\xf0\x9f\x98\x80");
+    }
+
+    TEST_CASE("Parser accepts members in any order", "[QueryResponseParserTest]")
+    {
+        internal::QueryResponseParser parser;
+        RecordingHandler handler;
+
+        parser.parse(R"({"results":[{"series":[{"values":[[1]],"columns":["v"],"name":"m"}],"statement_id":3,"partial":false}]})", handler);
+
+        CHECK(handler.events == std::vector<std::string>{"statement 3", "series m | v", "row number:1", "end"});
+    }
+
+    TEST_CASE("Parser passes statement errors", "[QueryResponseParserTest]")
+    {
+        internal::QueryResponseParser parser;
+        RecordingHandler handler;
+
+        parser.parse(R"({"results":[{"statement_id":0,"error":"database not found: x"}]})", handler);
+
+        CHECK(handler.events == std::vector<std::string>{"statement 0", "error database not found: x", "end"});
+    }
+
+    TEST_CASE("Parser throws on response error", "[QueryResponseParserTest]")
+    {
+        internal::QueryResponseParser parser;
+        RecordingHandler handler;
+
+        CHECK_THROWS_AS(parser.parse(R"({"error":"error parsing query"})", handler), InfluxDBException);
+    }
+
+    TEST_CASE("Parser throws on malformed response", "[QueryResponseParserTest]")
+    {
+        internal::QueryResponseParser parser;
+        RecordingHandler handler;
+
+        CHECK_THROWS_AS(parser.parse(R"({"results":[{"statement_id":0,"series":[{"columns":["v"],"values":[[1,]]}]}]})", handler), InfluxDBException);
+        CHECK_THROWS_AS(parser.parse(R"({"results":[{"statement_id":0)", handler), InfluxDBException);
+        CHECK_THROWS_AS(parser.parse(R"({"results":[]} x)", handler), InfluxDBException);
+        CHECK_THROWS_AS(parser.parse(R"({"results":[{"statement_id":0,"series":[{"name":"\u00zz"}]}]})", handler), InfluxDBException);
+        CHECK_THROWS_AS(parser.parse(R"({"other":[]})", handler), InfluxDBException);
+    }
+
+    TEST_CASE("CSV parser passes sections as series of one statement", "[QueryResponseParserTest]")
+    {
+        internal::CsvResponseParser parser;
+        RecordingHandler handler;
+
+        parser.parse("name,tags,time,value,host\n"
+                     "cpu,\"host=a,region=eu\\,w\",1609459200000000000,1.5,\"x,y\"\n"
+                     "cpu,\"host=a,region=eu\\,w\",1609459200000000001,,srv\r\n",
+                     handler);
+        parser.parse("mem,,1609459200000000002,7,\"say \"\"hi\"\"\"\n"
+                     "\n"
+                     "name,tags,time,count\n"
+                     "cpu,,1609459200000000003,true",
+                     handler);
+        parser.finish(handler);
+
+        CHECK(handler.events == std::vector<std::string>{"statement 0",
+                                                         "series cpu host=a region=eu,w | time value host",
+                                                         "row number:1609459200000000000 number:1.5 string:x,y",
+                                                         "row number:1609459200000000001 null:null string:srv",
+                                                         "series mem | time value host",
+                                                         "row number:1609459200000000002 number:7 string:say \"hi\"",
+                                                         "series cpu | time count",
+                                                         "row number:1609459200000000003 bool:true",
+                                                         "end"});
+    }
+
+    TEST_CASE("CSV parser throws on response error", "[QueryResponseParserTest]")
+    {
+        internal::CsvResponseParser parser;
+        RecordingHandler handler;
+
+        CHECK_THROWS_WITH(parser.parse("error\nerror parsing query: found EOF\n", handler), Catch::Contains("error parsing query: found EOF"));
+    }
+
+    TEST_CASE("CSV parser throws on malformed response", "[QueryResponseParserTest]")
+    {
+        RecordingHandler handler;
+
+        CHECK_THROWS_AS(internal::CsvResponseParser{}.parse("time,value\n1,2\n", handler), InfluxDBException);
+        CHECK_THROWS_AS(internal::CsvResponseParser{}.parse("name,tags,v\nm,\"unterminated,1\n", handler), InfluxDBException);
+        CHECK_THROWS_AS(internal::CsvResponseParser{}.parse("name,tags,v\nm,\"a\"b,1\n", handler), InfluxDBException);
+        CHECK_THROWS_AS(internal::CsvResponseParser{}.parse("name,tags,v\nm,novalue,1\n", handler), InfluxDBException);
+    }
+
+    TEST_CASE("MessagePack parser passes statements, series and typed rows", "[QueryResponseParserTest]")
+    {
+        test::MsgPackWriter writer;
+        writer.map(1).string("results").array(2);
+        writer.map(2).string("statement_id").integer(0).string("series").array(1);
+        writer.map(4).string("name").string("cpu").string("tags").map(1).string("host").string("a");
+        writer.string("columns").array(4).string("time").string("value").string("ok").string("note");
+        writer.string("values").array(2);
+        writer.array(4).time(1609459200000000005).real(1.5).boolean(true).nil();
+        writer.array(4).time(1609459201000000000).integer(-7).boolean(false).string("x");
+        writer.map(2).string("statement_id").integer(1).string("error").string("database not found: x");
+
+        internal::MsgPackResponseParser parser;
+        RecordingHandler handler;
+        parser.parse(writer.data, handler);
+
+        CHECK(handler.events == std::vector<std::string>{"statement 0",
+                                                         "series cpu host=a | time value ok note",
+                                                         "row time:1609459200000000005 float:1.500000 bool:true null:null",
+                                                         "row time:1609459201000000000 integer:-7 bool:false string:x",
+                                                         "end",
+                                                         "statement 1",
+                                                         "error database not found: x",
+                                                         "end"});
+    }
+
+    TEST_CASE("MessagePack parser accepts members in any order", "[QueryResponseParserTest]")
+    {
+        test::MsgPackWriter writer;
+        writer.map(1).string("results").array(1);
+        writer.map(3).string("series").array(1);
+        writer.map(3).string("values").array(1).array(1).integer(1).string("columns").array(1).string("v").string("name").string("m");
+        writer.string("statement_id").integer(3).string("partial").boolean(false);
+
+        internal::MsgPackResponseParser parser;
+        RecordingHandler handler;
+        parser.parse(writer.data, handler);
+
+        CHECK(handler.events == std::vector<std::string>{"statement 3", "series m | v", "row integer:1", "end"});
+    }
+
+    TEST_CASE("MessagePack parser throws on error and malformed response", "[QueryResponseParserTest]")
+    {
+        internal::MsgPackResponseParser parser;
+        RecordingHandler handler;
+
+        test::MsgPackWriter error;
+        error.map(1).string("error").string("error parsing query");
+        CHECK_THROWS_WITH(parser.parse(error.data, handler), Catch::Contains("error parsing query"));
+
+        test::MsgPackWriter truncated;
+        truncated.map(1).string("results").array(1).map(1).string("statement_id");
+        CHECK_THROWS_AS(parser.parse(truncated.data, handler), InfluxDBException);
+        CHECK_THROWS_AS(parser.parse(std::string{"\x81\xc1"}, handler), InfluxDBException);
+        CHECK_THROWS_AS(parser.parse(std::string{"\x80"}, handler), InfluxDBException);
+    }
+
+    TEST_CASE("MessagePack scanner finds ends of documents received in parts", "[QueryResponseParserTest]")
+    {
+        test::MsgPackWriter writer;
+        writer.map(1).string("results").array(1).map(1).string("statement_id").integer(0);
+        const auto size = writer.data.size();
+        writer.map(1).string("results").array(0);
+
+        internal::MsgPackScanner scanner;
+        std::string received;
+        std::vector<std::size_t> documents;
+        for (const char c : writer.data)
+        {
+            received.push_back(c);
+            if (const auto document = scanner.scan(received); document > 0)
+            {
+                documents.push_back(document);
+                received.erase(0, document);
+            }
+        }
+
+        CHECK(documents == std::vector<std::size_t>{size, writer.data.size() - size});
+        CHECK(received.empty());
+    }
+}
@@ -0,0 +1,577 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Query.h"
+#include "InfluxDBException.h"
+#include "MsgPackWriter.h"
+#include "mock/TransportMock.h"
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace influxdb::test
+{
+    namespace
+    {
+        struct ChunkedTransportStub : public Transport
+        {
+            explicit ChunkedTransportStub(std::vector<std::string> parts)
+                : chunks(std::move(parts))
+            {
+            }
+
+            void send([[maybe_unused]] std::string&& message) override
+            {
+            }
+
+            void queryChunked([[maybe_unused]] const std::string& query, const std::function<void(std::string_view)>& onChunk) override
+            {
+                for (const auto& chunk : chunks)
+                {
+                    ++delivered;
+                    onChunk(chunk);
+                }
+            }
+
+            std::vector<std::string> chunks;
+            std::size_t delivered{0};
+        };
+
+        std::vector<std::string> split(const std::string& data, std::size_t size)
+        {
+            std::vector<std::string> parts;
+            for (std::size_t offset = 0; offset < data.size(); offset += size)
+            {
+                parts.push_back(data.substr(offset, size));
+            }
+            return parts;
+        }
+    }
+
+    TEST_CASE("Query is passed to transport", "[QueryTest]")
+    {
+        TransportMock transport;
+        REQUIRE_CALL(transport, query("SELECT * from test WHERE host = 'localhost'"))
+            .RETURN(R"({"results":[{"statement_id":0}]})");
+
+        internal::queryImpl(&transport, "SELECT * from test WHERE host = 'localhost'");
+    }
+
+    TEST_CASE("Query throws if transport throws", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_)).THROW(InfluxDBException{"unit test", "Intentional"});
+
+        CHECK_THROWS_AS(internal::queryImpl(&transport, "select should throw"), InfluxDBException);
+    }
+
+    TEST_CASE("Query returns empty if empty result", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_)).RETURN(R"({"results":[]})");
+
+        CHECK(internal::queryImpl(&transport, "SELECT * from test").empty());
+    }
+
+    TEST_CASE("Query returns point of single result", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .RETURN(R"({"results":[{"statement_id":0,)"
+                    R"("series":[{"name":"unittest","columns":["time","host","value"],)"
+                    R"("values":[["2021-01-01T11:22:00.123456789Z","localhost",112233]]}]}]})");
+
+        const auto result = internal::queryImpl(&transport, "SELECT * from test");
+        CHECK(result.size() == 1);
+        const auto point = result[0];
+        CHECK(point.getName() == "unittest");
+        CHECK(point.getTimestamp() == std::chrono::system_clock::from_time_t(1609500120) + std::chrono::nanoseconds{123456789});
+        CHECK(point.getTags() == "host=localhost");
+        CHECK(point.getFields() == "value=112233.000000000000000000");
+    }
+
+    TEST_CASE("Query returns points of multiple results", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .RETURN(R"({"results":[{"statement_id":0,)"
+                    R"("series":[{"name":"unittest","columns":["time","host","value"],)"
+                    R"("values":[["2021-01-01T11:22:00Z","host-0",100],)"
+                    R"(["2021-01-01T11:23:00Z","host-1",30],)"
+                    R"(["2021-01-01T11:24:00Z","host-2",54]]}]}]})");
+
+        const auto result = internal::queryImpl(&transport, "SELECT * from test");
+        CHECK(result.size() == 3);
+        CHECK(result[0].getName() == "unittest");
+        CHECK(result[0].getTags() == "host=host-0");
+        CHECK(result[0].getFields() == "value=100.000000000000000000");
+        CHECK(result[1].getName() == "unittest");
+        CHECK(result[1].getTags() == "host=host-1");
+        CHECK(result[1].getFields() == "value=30.000000000000000000");
+        CHECK(result[2].getName() == "unittest");
+        CHECK(result[2].getTags() == "host=host-2");
+        CHECK(result[2].getFields() == "value=54.000000000000000000");
+    }
+
+    TEST_CASE("Query returns points of statements following a statement without series", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .RETURN(R"({"results":[{"statement_id":0},)"
+                    R"({"statement_id":1,"series":[{"name":"a","columns":["time","v"],"values":[["2021-01-01T11:22:00Z",1]]}]},)"
+                    R"({"statement_id":2,"series":[{"name":"b","columns":["time","v"],"values":[["2021-01-01T11:22:00Z",2]]}]}]})");
+
+        const auto result = internal::queryImpl(&transport, "SELECT * from x; SELECT * FROM a; SELECT * FROM b");
+        REQUIRE(result.size() == 2);
+        CHECK(result[0].getName() == "a");
+        CHECK(result[1].getName() == "b");
+    }
+
+    TEST_CASE("Query statements returns points and error per statement", "[QueryTest]")
+    {
+        ChunkedTransportStub transport{{R"({"results":[{"statement_id":0,"series":[{"name":"a","columns":["time","v"],"values":[["2021-01-01T11:22:00Z",1]]}],"partial":true}]})",
+                                        R"({"results":[{"statement_id":0,"series":[{"name":"a","columns":["time","v"],"values":[["2021-01-01T11:23:00Z",2]]}]}]})",
+                                        R"({"results":[{"statement_id":1},{"statement_id":2,"error":"measurement not found"},)"
+                                        R"({"statement_id":3,"series":[{"name":"c","columns":["time","v"],"values":[["2021-01-01T11:22:00Z",3]]}]}]})"}};
+
+        const auto statements = internal::queryStatementsImpl(&transport, "SELECT * FROM a; SELECT * FROM b; SELECT * FROM x; SELECT * FROM c");
+        REQUIRE(statements.size() == 4);
+        CHECK(statements[0].statementId == 0);
+        CHECK(statements[0].points.size() == 2);
+        CHECK(statements[0].error == std::nullopt);
+        CHECK(statements[1].points.empty());
+        CHECK(statements[2].error == "measurement not found");
+        CHECK(statements[2].points.empty());
+        CHECK(statements[3].statementId == 3);
+        REQUIRE(statements[3].points.size() == 1);
+        CHECK(statements[3].points[0].getName() == "c");
+    }
+
+    TEST_CASE("Query throws on invalid result", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .RETURN(R"({"invalid-results":[]})");
+
+        CHECK_THROWS_AS(internal::queryImpl(&transport, "SELECT * from test"), InfluxDBException);
+    }
+
+    TEST_CASE("Query is safe to empty name", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .RETURN(R"({"results":[{"statement_id":0,"series":[{"columns":["time","host","value"],)"
+                    R"("values":[["2021-01-01T11:22:00Z","x",8]]}]}]})");
+
+        const auto result = internal::queryImpl(&transport, "SELECT * from test");
+        CHECK(result.size() == 1);
+        CHECK(result[0].getName() == "");
+        CHECK(result[0].getTags() == "host=x");
+    }
+
+    TEST_CASE("Query passes points of chunked response while received", "[QueryTest]")
+    {
+        ChunkedTransportStub transport{{R"({"results":[{"statement_id":0,"series":[{"name":"unittest","columns":["time","host","value"],)",
+                                        R"("values":[["2021-01-01T11:22:00Z","host-0",1]],"partial":true}],"partial":true}]})"
+                                        "\n"
+                                        R"({"results":[{"statement_id":0,"series":[{"name":"unittest","columns":["time","host","value"],)"
+                                        R"("values":[["2021-01-01T11:23:00Z","host-1",2]]}]}]})",
+                                        "\n"}};
+        std::vector<Point> points;
+
+        internal::queryImpl(&transport, "SELECT * from test", [&points](Point&& point) { points.push_back(std::move(point)); });
+        CHECK(points.size() == 2);
+        CHECK(points[0].getTags() == "host=host-0");
+        CHECK(points[1].getTags() == "host=host-1");
+    }
+
+    TEST_CASE("Query passes points of chunk before next chunk is received", "[QueryTest]")
+    {
+        ChunkedTransportStub transport{{R"({"results":[{"statement_id":0,"series":[{"name":"x","columns":["time","v"],"values":[["2021-01-01T11:22:00Z","a}\"b"]]}]}]})",
+                                        R"({"results":[{"statement_id":0,"series":[{"name":"y","columns":["time","v"],"values":[["2021-01-01T11:22:00Z","c"]]}]}]})"}};
+        std::vector<std::pair<std::string, std::size_t>> received;
+
+        internal::queryImpl(&transport, "SELECT * from test", [&](Point&& point) {
+            received.emplace_back(point.getName(), transport.delivered);
+        });
+        CHECK(received == std::vector<std::pair<std::string, std::size_t>>{{"x", 1}, {"y", 2}});
+    }
+
+    TEST_CASE("Query throws on incomplete chunked response", "[QueryTest]")
+    {
+        ChunkedTransportStub transport{{R"({"results":[{"statement_id":0,"series":[{"name":"x",)"}};
+
+        CHECK_THROWS_AS(internal::queryImpl(&transport, "SELECT * from test", [](Point&&) {}), InfluxDBException);
+    }
+
+    TEST_CASE("Query result has typed columns", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .RETURN(R"({"results":[{"statement_id":0,"series":[{"name":"cpu","tags":{"region":"eu"},)"
+                    R"("columns":["time","count","load","up","host","note"],)"
+                    R"("values":[["2021-01-01T00:00:01.5Z",3,0.25,true,"a",null],)"
+                    R"(["2021-01-01T00:00:02Z",-4,1,false,"b\"c",null]]}]}]})");
+
+        const auto result = internal::queryResultImpl(&transport, "SELECT * from cpu");
+        REQUIRE(result.statements.size() == 1);
+        REQUIRE(result.statements[0].series.size() == 1);
+        const auto& series = result.statements[0].series[0];
+        CHECK(series.name == "cpu");
+        CHECK(series.tags == std::vector<std::pair<std::string, std::string>>{{"region", "eu"}});
+        CHECK(series.rows() == 2);
+
+        using namespace std::chrono_literals;
+        const auto epoch = std::chrono::system_clock::from_time_t(1609459200);
+        CHECK(series.columns[0].get<std::chrono::system_clock::time_point>() == std::vector{epoch + 1500ms, epoch + 2s});
+        CHECK(series.columns[1].get<std::int64_t>() == std::vector<std::int64_t>{3, -4});
+        CHECK(series.columns[2].get<double>() == std::vector{0.25, 1.0});
+        CHECK(series.columns[3].get<bool>() == std::vector{true, false});
+        CHECK(series.columns[4].get<std::string_view>() == std::vector<std::string_view>{"a", "b\"c"});
+        CHECK(series.columns[5].type() == ColumnType::Null);
+        CHECK(series.columns[5].nulls == std::vector{true, true});
+        CHECK(&series.column("load") == &series.columns[2]);
+        CHECK(&series.findColumn("load")->get() == &series.columns[2]);
+        CHECK_THROWS_AS(series.column("missing"), InfluxDBException);
+        CHECK_FALSE(series.findColumn("missing").has_value());
+    }
+
+    TEST_CASE("Query result promotes and converts column types", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .RETURN(R"({"results":[{"statement_id":0,"series":[{"name":"m","columns":["a","b","c"],)"
+                    R"("values":[[null,1,true],[1,2.5,"x"],[2.5,null,null]]}]}]})");
+
+        const auto result = internal::queryResultImpl(&transport, "SELECT * from m");
+        const auto& series = result.statements[0].series[0];
+        CHECK(series.columns[0].get<double>() == std::vector{0.0, 1.0, 2.5});
+        CHECK(series.columns[0].nulls == std::vector{true, false, false});
+        CHECK(series.columns[1].get<double>() == std::vector{1.0, 2.5, 0.0});
+        CHECK(series.columns[2].get<std::string_view>() == std::vector<std::string_view>{"true", "x", ""});
+        CHECK(series.columns[2].nulls == std::vector{false, false, true});
+    }
+
+    TEST_CASE("Query result merges series split over chunks", "[QueryTest]")
+    {
+        ChunkedTransportStub transport{{R"({"results":[{"statement_id":0,"series":[{"name":"m","columns":["time","v"],)"
+                                        R"("values":[["2021-01-01T00:00:00Z","a"]],"partial":true}],"partial":true}]})",
+                                        R"({"results":[{"statement_id":0,"series":[{"name":"m","columns":["time","v"],)"
+                                        R"("values":[["2021-01-01T00:00:01Z","b"]]},{"name":"n","columns":["time","v"],"values":[["2021-01-01T00:00:02Z","c"]]}]},)"
+                                        R"({"statement_id":1,"error":"not executed"}]})"}};
+
+        auto result = internal::queryResultImpl(&transport, "SELECT * from m; SELECT * from n");
+        const auto moved = std::move(result);
+        REQUIRE(moved.statements.size() == 2);
+        REQUIRE(moved.statements[0].series.size() == 2);
+        CHECK(moved.statements[0].series[0].columns[1].get<std::string_view>() == std::vector<std::string_view>{"a", "b"});
+        CHECK(moved.statements[0].series[1].columns[1].get<std::string_view>() == std::vector<std::string_view>{"c"});
+        CHECK(moved.statements[1].error == "not executed");
+    }
+
+    TEST_CASE("Query result throws on invalid timestamp", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .RETURN(R"({"results":[{"statement_id":0,"series":[{"name":"m","columns":["time"],"values":[["yesterday"]]}]}]})");
+
+        CHECK_THROWS_AS(internal::queryResultImpl(&transport, "SELECT * from m"), InfluxDBException);
+    }
+
+    TEST_CASE("Query stream passes typed rows while chunks are received", "[QueryTest]")
+    {
+        ChunkedTransportStub transport{{R"({"results":[{"statement_id":0,"series":[{"name":"m","tags":{"host":"a"},"columns":["time","v","s"],)"
+                                        R"("values":[["2021-01-01T00:00:00Z",1,"x"],["2021-01-01T00:00:01Z",2.5,null]],"partial":true}],"partial":true}]})",
+                                        R"({"results":[{"statement_id":0,"series":[{"name":"m","tags":{"host":"a"},"columns":["time","v","s"],)"
+                                        R"("values":[["2021-01-01T00:00:02Z",true,"y"]]}]}]})"}};
+        std::vector<std::vector<QueryValue>> rows;
+        std::deque<std::string> strings;
+        std::vector<std::size_t> chunks;
+
+        internal::queryStreamImpl(&transport, "SELECT * from m", [&](const QueryRow& row) {
+            CHECK(row.statementId == 0);
+            CHECK(row.name == "m");
+            CHECK(row.tags == std::vector<std::pair<std::string_view, std::string_view>>{{"host", "a"}});
+            CHECK(row.columns == std::vector<std::string_view>{"time", "v", "s"});
+            auto& values = rows.emplace_back(row.values);
+            for (auto& value : values)
+            {
+                // String values refer to the response, which is only valid during the call
+                if (const auto* text = std::get_if<std::string_view>(&value))
+                {
+                    value = std::string_view{strings.emplace_back(*text)};
+                }
+            }
+            chunks.push_back(transport.delivered);
+        });
+
+        const auto epoch = std::chrono::system_clock::from_time_t(1609459200);
+        REQUIRE(rows.size() == 3);
+        CHECK(rows[0] == std::vector<QueryValue>{epoch, std::int64_t{1}, std::string_view{"x"}});
+        CHECK(rows[1] == std::vector<QueryValue>{epoch + std::chrono::seconds{1}, 2.5, std::monostate{}});
+        CHECK(rows[2][1] == QueryValue{true});
+        CHECK(chunks == std::vector<std::size_t>{1, 1, 2});
+    }
+
+    TEST_CASE("Query stream throws on statement error", "[QueryTest]")
+    {
+        ChunkedTransportStub transport{{R"({"results":[{"statement_id":0,"error":"database not found: x"}]})"}};
+
+        CHECK_THROWS_AS(internal::queryStreamImpl(&transport, "SELECT * from m", [](const QueryRow&) {}), InfluxDBException);
+    }
+
+    TEST_CASE("Query accepts epoch timestamps", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .RETURN(R"({"results":[{"statement_id":0,"series":[{"name":"m","columns":["time","v"],"values":[[1609500120123456789,1]]}]}]})");
+
+        const auto expected = std::chrono::system_clock::from_time_t(1609500120) + std::chrono::nanoseconds{123456789};
+        CHECK(internal::queryImpl(&transport, "SELECT * from m").at(0).getTimestamp() == expected);
+        CHECK(internal::queryResultImpl(&transport, "SELECT * from m").statements.at(0).series.at(0).columns.at(0).get<std::chrono::system_clock::time_point>() ==
+              std::vector{expected});
+    }
+
+    TEST_CASE("Query result decodes CSV responses", "[QueryTest]")
+    {
+        const std::string response{"name,tags,time,count,note\n"
+                                   "cpu,host=a,1609459200000000000,3,\"x\n,y\"\n"
+                                   "cpu,host=a,1609459201000000000,4,\n"
+                                   "cpu,host=b,1609459202000000000,5,z\n"};
+        ChunkedTransportStub transport{split(response, 7)};
+
+        const auto result = internal::queryResultImpl(&transport, "SELECT * from cpu");
+        REQUIRE(result.statements.size() == 1);
+        REQUIRE(result.statements[0].series.size() == 2);
+        const auto& series = result.statements[0].series[0];
+        CHECK(series.tags == std::vector<std::pair<std::string, std::string>>{{"host", "a"}});
+        CHECK(series.columns[0].get<std::chrono::system_clock::time_point>() ==
+              std::vector{std::chrono::system_clock::from_time_t(1609459200), std::chrono::system_clock::from_time_t(1609459201)});
+        CHECK(series.columns[1].get<std::int64_t>() == std::vector<std::int64_t>{3, 4});
+        CHECK(series.columns[2].get<std::string_view>() == std::vector<std::string_view>{"x\n,y", ""});
+        CHECK(series.columns[2].nulls == std::vector{false, true});
+        CHECK(result.statements[0].series[1].columns[2].get<std::string_view>() == std::vector<std::string_view>{"z"});
+    }
+
+    TEST_CASE("Query result decodes MessagePack responses", "[QueryTest]")
+    {
+        MsgPackWriter writer;
+        for (std::int64_t chunk = 0; chunk < 2; ++chunk)
+        {
+            writer.map(1).string("results").array(1).map(2).string("statement_id").integer(0).string("series").array(1);
+            writer.map(3).string("name").string("m").string("columns").array(4).string("time").string("count").string("load").string("host");
+            writer.string("values").array(1).array(4).time(1609459200000000001 + chunk).integer(chunk).real(0.5).string("h");
+        }
+        ChunkedTransportStub transport{split(writer.data, 5)};
+
+        const auto result = internal::queryResultImpl(&transport, "SELECT * from m");
+        REQUIRE(result.statements.size() == 1);
+        REQUIRE(result.statements[0].series.size() == 1);
+        const auto& series = result.statements[0].series[0];
+        const auto epoch = std::chrono::system_clock::from_time_t(1609459200);
+        CHECK(series.columns[0].get<std::chrono::system_clock::time_point>() == std::vector{epoch + std::chrono::nanoseconds{1}, epoch + std::chrono::nanoseconds{2}});
+        CHECK(series.columns[1].get<std::int64_t>() == std::vector<std::int64_t>{0, 1});
+        CHECK(series.columns[2].get<double>() == std::vector{0.5, 0.5});
+        CHECK(series.columns[3].get<std::string_view>() == std::vector<std::string_view>{"h", "h"});
+    }
+
+    TEST_CASE("Query returns points of MessagePack responses", "[QueryTest]")
+    {
+        MsgPackWriter writer;
+        writer.map(1).string("results").array(1).map(2).string("statement_id").integer(0).string("series").array(1);
+        writer.map(3).string("name").string("m").string("columns").array(3).string("time").string("value").string("host");
+        writer.string("values").array(1).array(3).time(1609459200000000000).integer(7).string("h");
+        ChunkedTransportStub transport{{writer.data}};
+
+        const auto points = internal::queryImpl(&transport, "SELECT * from m");
+        REQUIRE(points.size() == 1);
+        CHECK(points[0].getName() == "m");
+        CHECK(points[0].getFields() == "value=7.000000000000000000");
+        CHECK(points[0].getTags() == "host=h");
+        CHECK(points[0].getTimestamp() == std::chrono::system_clock::from_time_t(1609459200));
+    }
+
+    TEST_CASE("Query throws on incomplete MessagePack response", "[QueryTest]")
+    {
+        MsgPackWriter writer;
+        writer.map(1).string("results").array(1);
+        ChunkedTransportStub transport{{writer.data}};
+
+        CHECK_THROWS_AS(internal::queryResultImpl(&transport, "SELECT * from m"), InfluxDBException);
+    }
+
+    TEST_CASE("Split time range creates query per window", "[QueryTest]")
+    {
+        const auto from = std::chrono::system_clock::time_point{std::chrono::seconds{10}};
+        const auto to = std::chrono::system_clock::time_point{std::chrono::seconds{40}};
+
+        CHECK(internal::splitTimeRange("SELECT * FROM m WHERE $timeFilter AND host = 'a'", from, to, 3) ==
+              std::vector<std::string>{"SELECT * FROM m WHERE time >= 10000000000 AND time < 20000000000 AND host = 'a'",
+                                       "SELECT * FROM m WHERE time >= 20000000000 AND time < 30000000000 AND host = 'a'",
+                                       "SELECT * FROM m WHERE time >= 30000000000 AND time < 40000000000 AND host = 'a'"});
+        CHECK(internal::splitTimeRange("SELECT $timeFilter", from, from + std::chrono::nanoseconds{2}, 5) ==
+              std::vector<std::string>{"SELECT time >= 10000000000 AND time < 10000000001", "SELECT time >= 10000000001 AND time < 10000000002"});
+        CHECK_THROWS_AS(internal::splitTimeRange("SELECT * FROM m", from, to, 3), InfluxDBException);
+        CHECK_THROWS_AS(internal::splitTimeRange("SELECT $timeFilter", to, from, 3), InfluxDBException);
+        CHECK_THROWS_AS(internal::splitTimeRange("SELECT $timeFilter", from, to, 0), InfluxDBException);
+        CHECK_THROWS_AS(internal::splitTimeRange("SELECT * FROM m WHERE $timeFilter limit 10", from, to, 3), InfluxDBException);
+        CHECK_THROWS_AS(internal::splitTimeRange("SELECT * FROM m WHERE $timeFilter ORDER BY time DESC", from, to, 3), InfluxDBException);
+    }
+
+    TEST_CASE("Unsplittable clauses are found outside of quotes", "[QueryTest]")
+    {
+        CHECK(internal::unsplittableClause("SELECT * FROM m WHERE $timeFilter SLIMIT 2") == "SLIMIT");
+        CHECK(internal::unsplittableClause("select * from m where $timeFilter order by time desc") == "DESC");
+        CHECK(internal::unsplittableClause("SELECT \"limit\" FROM m WHERE host = 'desc' AND $timeFilter") == std::nullopt);
+        CHECK(internal::unsplittableClause("SELECT limited FROM m_limit WHERE $timeFilter") == std::nullopt);
+    }
+
+    TEST_CASE("Split query passes points in window order", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .RETURN(R"({"results":[{"statement_id":0,"series":[{"name":"m","columns":["time","w"],"values":[[1,)" + _1.substr(_1.size() - 1) + "]]}]}]}");
+
+        std::string windows;
+        internal::querySplitImpl(&transport, {"q0", "q1", "q2", "q3"}, [&windows](Point&& point) { windows += point.getFields().substr(0, 3); });
+        CHECK(windows == "w=0w=1w=2w=3");
+    }
+
+    TEST_CASE("Split query bounds concurrent windows", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        std::mutex mutex;
+        std::size_t running{0};
+        std::size_t maxRunning{0};
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .LR_SIDE_EFFECT({
+                {
+                    std::lock_guard lock{mutex};
+                    maxRunning = std::max(maxRunning, ++running);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds{5});
+                std::lock_guard lock{mutex};
+                --running;
+            })
+            .RETURN(R"({"results":[{"statement_id":0,"series":[{"name":"m","columns":["time","w"],"values":[[1,)" + _1.substr(_1.size() - 1) + "]]}]}]}");
+
+        for (const std::size_t concurrency : {1, 3})
+        {
+            maxRunning = 0;
+            std::string windows;
+            internal::querySplitImpl(&transport, {"q0", "q1", "q2", "q3", "q4", "q5"},
+                                     [&windows](Point&& point) { windows += point.getFields().substr(0, 3); }, nullptr, concurrency);
+            CHECK(windows == "w=0w=1w=2w=3w=4w=5");
+            CHECK(maxRunning <= concurrency);
+        }
+        CHECK_THROWS_AS(internal::querySplitImpl(&transport, {"q0"}, [](Point&&) {}, nullptr, 0), InfluxDBException);
+    }
+
+    TEST_CASE("Split query throws if a window fails", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_)).RETURN(R"({"results":[{"statement_id":0}]})");
+        ALLOW_CALL(transport, query("q1")).THROW(InfluxDBException{"test", "failed"});
+
+        CHECK_THROWS_AS(internal::querySplitImpl(&transport, {"q0", "q1", "q2"}, [](Point&&) {}), InfluxDBException);
+    }
+
+    TEST_CASE("Query types values as declared by schema", "[QueryTest]")
+    {
+        using trompeloeil::_;
+
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_))
+            .RETURN(R"({"results":[{"statement_id":0,"series":[{"name":"m","columns":["time","host","load","count","note","max"],)"
+                    R"("values":[["2021-01-01T11:22:00Z","42",1,2,"x",3]]}]}]})");
+        const internal::ColumnSchemaLookup schema = [](std::string_view measurement, std::string_view column) -> std::optional<internal::ColumnSchema> {
+            if (measurement != "m")
+            {
+                return std::nullopt;
+            }
+            if (column == "host")
+            {
+                return internal::ColumnSchema{ColumnType::String, true};
+            }
+            if (column == "load")
+            {
+                return internal::ColumnSchema{ColumnType::Double, false};
+            }
+            if (column == "count")
+            {
+                return internal::ColumnSchema{ColumnType::Int64, false};
+            }
+            if (column == "note")
+            {
+                return internal::ColumnSchema{ColumnType::String, false};
+            }
+            return std::nullopt;
+        };
+
+        const auto points = internal::queryImpl(&transport, "SELECT * FROM m", nullptr, &schema);
+        REQUIRE(points.size() == 1);
+        CHECK(points[0].getTags() == "host=42");
+        CHECK(points[0].getFields() == "load=1.000000000000000000,count=2i,note=\"x\",max=3.000000000000000000");
+
+        const auto result = internal::queryResultImpl(&transport, "SELECT * FROM m", nullptr, &schema);
+        const auto& series = result.statements.at(0).series.at(0);
+        CHECK(series.column("host").type() == ColumnType::String);
+        CHECK(series.column("load").get<double>() == std::vector<double>{1.0});
+        CHECK(series.column("count").get<std::int64_t>() == std::vector<std::int64_t>{2});
+        CHECK(series.column("max").type() == ColumnType::Int64);
+
+        internal::queryStreamImpl(&transport, "SELECT * FROM m", [](const QueryRow& row) {
+            CHECK(std::get<double>(row.values[2]) == 1.0);
+        }, nullptr, &schema);
+    }
+}
@@ -0,0 +1,148 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SchemaCache.h"
+#include "InfluxDBException.h"
+#include "mock/TransportMock.h"
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+#include <thread>
+
+namespace influxdb::test
+{
+    using internal::SchemaCache;
+    using trompeloeil::_;
+
+    namespace
+    {
+        constexpr std::chrono::hours noRefresh{1};
+
+        const std::string schemaQuery{"SHOW MEASUREMENTS; SHOW FIELD KEYS; SHOW TAG KEYS"};
+        const std::string schemaResponse{R"({"results":[)"
+                                         R"({"statement_id":0,"series":[{"name":"measurements","columns":["name"],"values":[["cpu"],["mem"]]}]},)"
+                                         R"({"statement_id":1,"series":[{"name":"cpu","columns":["fieldKey","fieldType"],"values":[["load","float"],["count","integer"]]},)"
+                                         R"({"name":"mem","columns":["fieldKey","fieldType"],"values":[["free","integer"],["note","string"]]}]},)"
+                                         R"({"statement_id":2,"series":[{"name":"cpu","columns":["tagKey"],"values":[["host"]]}]}]})"};
+    }
+
+    TEST_CASE("Schema cache loads schema on first use", "[SchemaCacheTest]")
+    {
+        TransportMock transport;
+        REQUIRE_CALL(transport, query(schemaQuery)).RETURN(schemaResponse).TIMES(1);
+
+        SchemaCache cache{transport, noRefresh};
+        CHECK(cache.measurements() == std::vector<std::string>{"cpu", "mem"});
+        CHECK(cache.column("cpu", "load")->type == ColumnType::Double);
+        CHECK(cache.column("cpu", "count")->type == ColumnType::Int64);
+        CHECK(cache.column("mem", "note")->type == ColumnType::String);
+        CHECK(cache.column("cpu", "host")->tag);
+        CHECK(cache.column("cpu", "missing") == std::nullopt);
+    }
+
+    TEST_CASE("Schema cache loads unknown measurement once in the background", "[SchemaCacheTest]")
+    {
+        TransportMock transport;
+        REQUIRE_CALL(transport, query(schemaQuery)).RETURN(schemaResponse);
+        REQUIRE_CALL(transport, query(R"(SHOW FIELD KEYS FROM "disk"; SHOW TAG KEYS FROM "disk")"))
+            .RETURN(R"({"results":[{"statement_id":0,"series":[{"name":"disk","columns":["fieldKey","fieldType"],"values":[["used","boolean"]]}]},)"
+                    R"({"statement_id":1}]})")
+            .TIMES(1);
+
+        SchemaCache cache{transport, noRefresh};
+        CHECK(cache.column("disk", "used") == std::nullopt);
+
+        // Loaded in the background, lookups do not wait for it
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+        while (cache.column("disk", "used") == std::nullopt && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        CHECK(cache.column("disk", "used")->type == ColumnType::Bool);
+        CHECK(cache.column("disk", "other") == std::nullopt);
+    }
+
+    TEST_CASE("Schema cache treats columns as unknown if schema query fails", "[SchemaCacheTest]")
+    {
+        TransportMock transport;
+        ALLOW_CALL(transport, query(_)).THROW(InfluxDBException{"Test", "unsupported"});
+
+        SchemaCache cache{transport, noRefresh};
+        CHECK(cache.column("cpu", "load") == std::nullopt);
+        CHECK_NOTHROW(cache.check(Point{"cpu"}.addField("load", 1)));
+    }
+
+    TEST_CASE("Schema cache detects field type conflicts", "[SchemaCacheTest]")
+    {
+        TransportMock transport;
+        REQUIRE_CALL(transport, query(schemaQuery)).RETURN(schemaResponse);
+
+        SchemaCache cache{transport, noRefresh};
+        CHECK_NOTHROW(cache.check(Point{"cpu"}.addField("load", 0.5).addField("count", 3)));
+        CHECK_NOTHROW(cache.check(Point{"mem"}.addField("note", "a,b=c").addField("free", 7LL)));
+        CHECK_THROWS_WITH(cache.check(Point{"cpu"}.addField("load", 1).addField("count", "x")),
+                          "influx-cxx [SchemaCache]: Field type conflict: cpu.load is float, written as integer, "
+                          "cpu.count is integer, written as string");
+        CHECK_THROWS_AS(cache.check(Point{"cpu"}.addField("load", 1)), SchemaConflict);
+    }
+
+    TEST_CASE("Schema cache unescapes field keys", "[SchemaCacheTest]")
+    {
+        TransportMock transport;
+        REQUIRE_CALL(transport, query(schemaQuery))
+            .RETURN(R"({"results":[{"statement_id":0},{"statement_id":1,"series":[{"name":"cpu","columns":["fieldKey","fieldType"],"values":[["a,b=c d","float"]]}]},{"statement_id":2}]})");
+
+        SchemaCache cache{transport, noRefresh};
+        CHECK_NOTHROW(cache.check(Point{"cpu"}.addField("a\\,b\\=c\\ d", 0.5)));
+        CHECK_THROWS_AS(cache.check(Point{"cpu"}.addField("a\\,b\\=c\\ d", 1)), SchemaConflict);
+    }
+
+    TEST_CASE("Schema cache records written fields of unknown type", "[SchemaCacheTest]")
+    {
+        TransportMock transport;
+        REQUIRE_CALL(transport, query(schemaQuery)).RETURN(schemaResponse);
+
+        SchemaCache cache{transport, noRefresh};
+        std::vector<Point> conflicting;
+        conflicting.push_back(Point{"cpu"}.addField("new", 1));
+        conflicting.push_back(Point{"cpu"}.addField("new", 1.5));
+        CHECK_THROWS_AS(cache.check(conflicting), SchemaConflict);
+        CHECK(cache.column("cpu", "new") == std::nullopt);
+
+        cache.check(Point{"cpu"}.addField("new", 2));
+        CHECK(cache.column("cpu", "new")->type == ColumnType::Int64);
+        CHECK_THROWS_AS(cache.check(Point{"cpu"}.addField("new", 2.5)), SchemaConflict);
+    }
+
+    TEST_CASE("Schema cache refreshes schema", "[SchemaCacheTest]")
+    {
+        TransportMock transport;
+        REQUIRE_CALL(transport, query(schemaQuery)).RETURN(schemaResponse);
+        SchemaCache cache{transport, noRefresh};
+        CHECK(cache.column("cpu", "idle") == std::nullopt);
+
+        REQUIRE_CALL(transport, query(schemaQuery))
+            .RETURN(R"({"results":[{"statement_id":0},{"statement_id":1,"series":[{"name":"cpu","columns":["fieldKey","fieldType"],"values":[["idle","float"]]}]},{"statement_id":2}]})");
+        cache.refresh();
+        CHECK(cache.column("cpu", "idle")->type == ColumnType::Double);
+    }
+}
@@ -0,0 +1,215 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SharedRing.h"
+#include "SharedMemoryReader.h"
+#include "InfluxDBFactory.h"
+#include "InfluxDBException.h"
+#include <catch2/catch.hpp>
+#include <map>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace influxdb::test
+{
+    using internal::SharedRing;
+
+    namespace
+    {
+        /// Name of a shared memory segment unique to the test, removed at the end of the test
+        struct SegmentName
+        {
+            explicit SegmentName(const std::string& test)
+                : name("influxdb-cxx-test-" + std::to_string(::getpid()) + "-" + test)
+            {
+                SharedRing::remove(name);
+            }
+
+            ~SegmentName()
+            {
+                SharedRing::remove(name);
+            }
+
+            std::string name;
+        };
+
+        std::vector<std::string> readAll(SharedRing& ring)
+        {
+            std::vector<std::string> messages;
+            ring.read([&messages](std::string_view message) { messages.emplace_back(message); }, 1000000);
+            return messages;
+        }
+    }
+
+    TEST_CASE("Shared ring passes messages in order", "[SharedMemoryTest]")
+    {
+        SegmentName segment{"order"};
+        SharedRing writer{segment.name, 4096};
+        SharedRing reader{segment.name, 4096};
+
+        CHECK(writer.capacity() == 4096);
+        CHECK(writer.tryWrite("a x=1"));
+        CHECK(writer.tryWrite(std::vector<std::string_view>{"b x=2", "\n", "c x=3"}));
+        CHECK(writer.tryWrite(""));
+        CHECK(reader.readable());
+        CHECK(readAll(reader) == std::vector<std::string>{"a x=1", "b x=2\nc x=3", ""});
+        CHECK_FALSE(reader.readable());
+        CHECK(readAll(reader).empty());
+    }
+
+    TEST_CASE("Shared ring rounds capacity up to a power of two", "[SharedMemoryTest]")
+    {
+        SegmentName segment{"capacity"};
+        SharedRing ring{segment.name, 5000};
+        CHECK(ring.capacity() == 8192);
+
+        SharedRing opened{segment.name, 100};
+        CHECK(opened.capacity() == 8192);
+    }
+
+    TEST_CASE("Shared ring rejects messages if full", "[SharedMemoryTest]")
+    {
+        SegmentName segment{"full"};
+        SharedRing ring{segment.name, 4096};
+        const std::string message(1000, 'x');
+
+        std::size_t written{0};
+        while (ring.tryWrite(message))
+        {
+            ++written;
+        }
+        CHECK(written == 4);
+        CHECK_FALSE(ring.tryWrite(std::string(ring.maxMessageSize() + 1, 'x')));
+
+        CHECK(ring.read([](std::string_view) {}, 1) == 1);
+        CHECK(ring.tryWrite(message));
+        CHECK(readAll(ring).size() == 4);
+    }
+
+    TEST_CASE("Shared ring wraps around", "[SharedMemoryTest]")
+    {
+        SegmentName segment{"wrap"};
+        SharedRing ring{segment.name, 4096};
+
+        for (std::size_t i = 0; i < 1000; ++i)
+        {
+            const std::string message(i % 1500, static_cast<char>('a' + i % 26));
+            REQUIRE(ring.tryWrite(message));
+            REQUIRE(readAll(ring) == std::vector<std::string>{message});
+        }
+    }
+
+    TEST_CASE("Shared ring keeps the order of each producer", "[SharedMemoryTest]")
+    {
+        SegmentName segment{"producers"};
+        SharedRing ring{segment.name, 64 * 1024};
+        constexpr std::size_t producers{4};
+        constexpr std::size_t messagesPerProducer{20000};
+
+        std::vector<std::thread> threads;
+        for (std::size_t producer = 0; producer < producers; ++producer)
+        {
+            threads.emplace_back([&ring, producer] {
+                for (std::size_t i = 0; i < messagesPerProducer;)
+                {
+                    if (ring.tryWrite(std::to_string(producer) + " " + std::to_string(i)))
+                    {
+                        ++i;
+                    }
+                }
+            });
+        }
+
+        std::map<std::size_t, std::size_t> next;
+        std::size_t received{0};
+        bool ordered{true};
+        while (received < producers * messagesPerProducer)
+        {
+            received += ring.read([&next, &ordered](std::string_view message) {
+                const auto separator = message.find(' ');
+                const auto producer = std::stoul(std::string{message.substr(0, separator)});
+                const auto index = std::stoul(std::string{message.substr(separator + 1)});
+                ordered = ordered && (next[producer]++ == index);
+            }, 1000);
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        CHECK(ordered);
+        CHECK(received == producers * messagesPerProducer);
+    }
+
+    TEST_CASE("Shared ring throws on segment of other size", "[SharedMemoryTest]")
+    {
+        SegmentName segment{"invalid"};
+        const auto fd = ::shm_open(("/" + segment.name).c_str(), O_RDWR | O_CREAT, 0600);
+        REQUIRE(fd >= 0);
+        REQUIRE(::ftruncate(fd, 10000) == 0);
+        ::close(fd);
+
+        CHECK_THROWS_AS(SharedRing(segment.name, 4096), InfluxDBException);
+    }
+
+    TEST_CASE("Shared memory transport writes to reader", "[SharedMemoryTest]")
+    {
+        SegmentName segment{"transport"};
+        SharedMemoryReader reader{segment.name, 4096};
+        auto db = InfluxDBFactory::Get("shm://" + segment.name + "?size=4096");
+
+        db->write(Point{"cpu"}.addField("load", 1).setTimestamp(std::chrono::system_clock::time_point{std::chrono::seconds{1}}));
+        db->batchOf(2);
+        db->write(Point{"a"}.addField("x", 1).setTimestamp(std::chrono::system_clock::time_point{}));
+        db->write(Point{"b"}.addField("x", 2).setTimestamp(std::chrono::system_clock::time_point{}));
+
+        CHECK(reader.wait(std::chrono::seconds{1}));
+        std::vector<std::string> messages;
+        CHECK(reader.read([&messages](std::string_view message) { messages.emplace_back(message); }) == 2);
+        CHECK(messages == std::vector<std::string>{"cpu load=1i 1000000000", "a x=1i 0\nb x=2i 0"});
+        CHECK_FALSE(reader.wait(std::chrono::microseconds{10}));
+
+        const auto statistics = db->transportStatistics();
+        CHECK(statistics.sentMessages == 2);
+        CHECK(statistics.droppedMessages == 0);
+    }
+
+    TEST_CASE("Shared memory transport counts dropped messages", "[SharedMemoryTest]")
+    {
+        SegmentName segment{"dropped"};
+        auto db = InfluxDBFactory::Get("shm://" + segment.name + "?size=4096&single_producer=true");
+
+        for (std::size_t i = 0; i < 100; ++i)
+        {
+            db->write(Point{"cpu"}.addField("value", std::string(100, 'x')));
+        }
+        db->write(Point{"cpu"}.addField("value", std::string(3000, 'x')));
+
+        const auto statistics = db->transportStatistics();
+        CHECK(statistics.sentMessages > 0);
+        CHECK(statistics.sentMessages + statistics.droppedMessages == 100);
+        CHECK(statistics.failedMessages == 1);
+    }
+}
@@ -0,0 +1,273 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Tee.h"
+#include "InfluxDBFactory.h"
+#include "InfluxDBException.h"
+#include "mock/TransportMock.h"
+#include <catch2/catch.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#endif
+
+namespace influxdb::test
+{
+    using transports::Tee;
+    using trompeloeil::_;
+
+    namespace
+    {
+        /// Records the messages sent; sends fail as configured and block while held
+        struct RecordingTransport : public Transport
+        {
+            struct State
+            {
+                std::vector<std::string> messages;
+                std::size_t failures{0};
+                bool rejecting{false};
+                std::size_t attempts{0};
+                bool held{false};
+                std::mutex mutex;
+                std::condition_variable released;
+            };
+
+            explicit RecordingTransport(std::shared_ptr<State> state)
+                : mState(std::move(state))
+            {
+            }
+
+            void send(std::string&& message) override
+            {
+                std::unique_lock<std::mutex> lock{mState->mutex};
+                mState->released.wait(lock, [this] { return !mState->held; });
+                ++mState->attempts;
+                if (mState->rejecting)
+                {
+                    throw BadRequest{"RecordingTransport", "Partial write"};
+                }
+                if (mState->failures > 0)
+                {
+                    --mState->failures;
+                    throw InfluxDBException{"RecordingTransport", "Send failed"};
+                }
+                mState->messages.push_back(std::move(message));
+            }
+
+            std::shared_ptr<State> mState;
+        };
+
+        std::shared_ptr<RecordingTransport::State> addRecording(Tee& tee, const Tee::ChildOptions& options = Tee::ChildOptions{})
+        {
+            auto state = std::make_shared<RecordingTransport::State>();
+            tee.add(std::make_unique<RecordingTransport>(state), options);
+            return state;
+        }
+
+        void hold(RecordingTransport::State& state, bool held)
+        {
+            {
+                std::lock_guard<std::mutex> lock{state.mutex};
+                state.held = held;
+            }
+            state.released.notify_all();
+        }
+
+        Tee::ChildOptions fastRetries(std::size_t maxRetries)
+        {
+            Tee::ChildOptions options;
+            options.maxRetries = maxRetries;
+            options.retryBackoff = std::chrono::milliseconds{1};
+            return options;
+        }
+    }
+
+    TEST_CASE("Tee sends every message to all children", "[TeeTest]")
+    {
+        Tee tee;
+        const auto first = addRecording(tee);
+        const auto second = addRecording(tee);
+
+        tee.send("a x=1");
+        tee.sendBuffers({"b x=2", "\n", "c x=3"});
+        tee.flush();
+
+        const std::vector<std::string> expected{"a x=1", "b x=2\nc x=3"};
+        CHECK(first->messages == expected);
+        CHECK(second->messages == expected);
+        CHECK(tee.sendStatistics().sentMessages == 4);
+    }
+
+    TEST_CASE("Tee does not delay children by a slow child", "[TeeTest]")
+    {
+        Tee tee;
+        const auto fast = addRecording(tee);
+        const auto slow = addRecording(tee);
+        hold(*slow, true);
+
+        tee.send("a x=1");
+        tee.send("b x=2");
+        while (tee.childStatistics(0).sentMessages < 2)
+        {
+            std::this_thread::yield();
+        }
+        CHECK(fast->messages == std::vector<std::string>{"a x=1", "b x=2"});
+
+        hold(*slow, false);
+        tee.flush();
+        CHECK(slow->messages == std::vector<std::string>{"a x=1", "b x=2"});
+    }
+
+    TEST_CASE("Tee retries failed sends of a child", "[TeeTest]")
+    {
+        Tee tee;
+        const auto healthy = addRecording(tee, fastRetries(2));
+        const auto flaky = addRecording(tee, fastRetries(2));
+        flaky->failures = 2;
+
+        tee.send("a x=1");
+        tee.flush();
+
+        CHECK(healthy->messages == std::vector<std::string>{"a x=1"});
+        CHECK(flaky->messages == std::vector<std::string>{"a x=1"});
+        CHECK(flaky->attempts == 3);
+        CHECK(tee.childStatistics(1).failedMessages == 0);
+    }
+
+    TEST_CASE("Tee counts messages failing all retries", "[TeeTest]")
+    {
+        Tee tee;
+        const auto healthy = addRecording(tee, fastRetries(1));
+        const auto failing = addRecording(tee, fastRetries(1));
+        failing->failures = 100;
+
+        CHECK_NOTHROW(tee.send("a x=1"));
+        CHECK_NOTHROW(tee.send("b x=2"));
+        tee.flush();
+
+        CHECK(healthy->messages.size() == 2);
+        CHECK(failing->attempts == 4);
+        const auto statistics = tee.childStatistics(1);
+        CHECK(statistics.sentMessages == 0);
+        CHECK(statistics.failedMessages == 2);
+        CHECK(tee.childStatistics(0).failedMessages == 0);
+    }
+
+    TEST_CASE("Tee does not retry permanent errors", "[TeeTest]")
+    {
+        Tee tee;
+        const auto rejecting = addRecording(tee, fastRetries(3));
+        rejecting->rejecting = true;
+
+        tee.send("a x=1");
+        tee.flush();
+
+        CHECK(rejecting->attempts == 1);
+        CHECK(tee.childStatistics(0).failedMessages == 1);
+    }
+
+    TEST_CASE("Tee drops messages if the queue of a child is full", "[TeeTest]")
+    {
+        Tee tee;
+        Tee::ChildOptions options;
+        options.queueSize = 1;
+        const auto slow = addRecording(tee, options);
+        hold(*slow, true);
+
+        tee.send("a x=1");
+        std::size_t sends{1};
+        while (tee.childStatistics(0).droppedMessages == 0)
+        {
+            tee.send("b x=2");
+            ++sends;
+        }
+
+        hold(*slow, false);
+        tee.flush();
+        const auto statistics = tee.childStatistics(0);
+        CHECK(statistics.sentMessages + statistics.droppedMessages == sends);
+        CHECK(slow->messages.size() == statistics.sentMessages);
+        CHECK(slow->messages.front() == "a x=1");
+    }
+
+    TEST_CASE("Tee queries the first child", "[TeeTest]")
+    {
+        auto primary = std::make_shared<TransportMock>();
+        auto secondary = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*primary, query("SELECT * FROM test")).RETURN("result");
+        REQUIRE_CALL(*primary, createDatabase());
+        ALLOW_CALL(*primary, flush());
+        ALLOW_CALL(*secondary, flush());
+
+        Tee tee;
+        tee.add(std::make_unique<TransportAdapter>(primary), Tee::ChildOptions{});
+        tee.add(std::make_unique<TransportAdapter>(secondary), Tee::ChildOptions{});
+        CHECK(tee.query("SELECT * FROM test") == "result");
+        tee.createDatabase();
+    }
+
+    TEST_CASE("Tee without children throws on queries", "[TeeTest]")
+    {
+        Tee tee;
+        CHECK_THROWS_AS(tee.query("SELECT * FROM test"), InfluxDBException);
+        CHECK_THROWS_AS(tee.add(nullptr, Tee::ChildOptions{}), InfluxDBException);
+        CHECK_THROWS_AS(tee.childStatistics(0), InfluxDBException);
+    }
+
+    TEST_CASE("Tee factory throws on invalid URLs", "[TeeTest]")
+    {
+        CHECK_THROWS_AS(InfluxDBFactory::GetTee({}), InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::GetTee({"unknown://localhost"}), InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::GetTee({"http://localhost:8086?db=test&tee_queue_size=0"}), InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::GetTee({"http://localhost:8086?db=test&tee_max_retries=x"}), InfluxDBException);
+    }
+
+#ifndef _WIN32
+    TEST_CASE("Tee factory writes to all transports", "[TeeTest]")
+    {
+        const auto prefix = "/tmp/influxdb-cxx-test-" + std::to_string(::getpid()) + "-tee-";
+        const std::vector<std::string> paths{prefix + "a.lp", prefix + "b.lp"};
+        {
+            auto influxdb = InfluxDBFactory::GetTee({"file://" + paths[0] + "?tee_queue_size=16",
+                                                     "file://" + paths[1] + "?tee_max_retries=0&tee_retry_backoff_ms=10&fsync=flush"});
+            influxdb->write(Point{"test"}.addField("value", 10).setTimestamp(std::chrono::time_point<std::chrono::system_clock>{}));
+            influxdb->flushTransport();
+        }
+
+        for (const auto& path : paths)
+        {
+            std::ifstream file{path};
+            std::ostringstream content;
+            content << file.rdbuf();
+            CHECK(content.str() == "test value=10i 0\n");
+            std::remove(path.c_str());
+        }
+    }
+#endif
+}
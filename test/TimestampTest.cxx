@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Timestamp.h"
+#include <catch2/catch.hpp>
+
+namespace influxdb::test
+{
+    namespace
+    {
+        std::chrono::system_clock::time_point utc(std::time_t seconds, long long nanoseconds = 0)
+        {
+            return std::chrono::system_clock::from_time_t(seconds) + std::chrono::nanoseconds{nanoseconds};
+        }
+    }
+
+    TEST_CASE("Parses UTC timestamp", "[TimestampTest]")
+    {
+        CHECK(internal::parseRfc3339("1970-01-01T00:00:00Z") == utc(0));
+        CHECK(internal::parseRfc3339("2021-01-01T11:22:33Z") == utc(1609500153));
+        CHECK(internal::parseRfc3339("2020-02-29T23:59:59z") == utc(1583020799));
+        CHECK(internal::parseRfc3339("1969-12-31T23:59:59Z") == utc(-1));
+    }
+
+    TEST_CASE("Parses fractional seconds up to nanoseconds", "[TimestampTest]")
+    {
+        CHECK(internal::parseRfc3339("2021-01-01T11:22:33.5Z") == utc(1609500153, 500000000));
+        CHECK(internal::parseRfc3339("2021-01-01T11:22:33.000000001Z") == utc(1609500153, 1));
+        CHECK(internal::parseRfc3339("2021-01-01T11:22:33.123456789Z") == utc(1609500153, 123456789));
+        CHECK(internal::parseRfc3339("2021-01-01T11:22:33.1234567891Z") == utc(1609500153, 123456789));
+    }
+
+    TEST_CASE("Converts time zone offsets to UTC", "[TimestampTest]")
+    {
+        CHECK(internal::parseRfc3339("2021-01-01T12:22:33+01:00") == utc(1609500153));
+        CHECK(internal::parseRfc3339("2021-01-01T05:52:33.25-05:30") == utc(1609500153, 250000000));
+        CHECK(internal::parseRfc3339("2021-01-01 11:22:33+00:00") == utc(1609500153));
+    }
+
+    TEST_CASE("Rejects invalid timestamps", "[TimestampTest]")
+    {
+        CHECK_FALSE(internal::parseRfc3339(""));
+        CHECK_FALSE(internal::parseRfc3339("2021-01-01"));
+        CHECK_FALSE(internal::parseRfc3339("2021-01-01:11:22.000000000Z"));
+        CHECK_FALSE(internal::parseRfc3339("2021-01-01T11:22:33"));
+        CHECK_FALSE(internal::parseRfc3339("2021-13-01T11:22:33Z"));
+        CHECK_FALSE(internal::parseRfc3339("2021-02-29T11:22:33Z"));
+        CHECK_FALSE(internal::parseRfc3339("2021-01-01T24:00:00Z"));
+        CHECK_FALSE(internal::parseRfc3339("2021-01-01T11:22:33.Z"));
+        CHECK_FALSE(internal::parseRfc3339("2021-01-01T11:22:33+01"));
+        CHECK_FALSE(internal::parseRfc3339("2021-01-01T11:22:33Zx"));
+    }
+}
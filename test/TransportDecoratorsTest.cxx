@@ -0,0 +1,379 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "TransportDecorators.h"
+#include "InfluxDBFactory.h"
+#include "InfluxDBException.h"
+#include "mock/TransportMock.h"
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#ifdef INFLUXCXX_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace influxdb::test
+{
+    using namespace transports;
+    using trompeloeil::_;
+
+    namespace
+    {
+        std::string temporaryPath(const std::string& name)
+        {
+            return "/tmp/influxdb-cxx-test-" + std::to_string(::getpid()) + "-" + name;
+        }
+
+        /// Sends asynchronously, its statistics count the messages sent later
+        class AsyncTransportStub : public Transport
+        {
+        public:
+            void send(std::string&&) override
+            {
+            }
+
+            TransportStatistics sendStatistics() const override
+            {
+                TransportStatistics statistics;
+                statistics.sentMessages = 1;
+                statistics.failedMessages = 2;
+                return statistics;
+            }
+        };
+    }
+
+    TEST_CASE("Decorator throws on missing transport", "[TransportDecoratorsTest]")
+    {
+        CHECK_THROWS_AS(Metrics{nullptr}, InfluxDBException);
+    }
+
+    TEST_CASE("Decorator forwards calls", "[TransportDecoratorsTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*mock, query("SELECT * FROM test")).RETURN("result");
+        REQUIRE_CALL(*mock, createDatabase());
+        REQUIRE_CALL(*mock, flush());
+
+        Metrics metrics{std::make_unique<TransportAdapter>(mock)};
+        CHECK(metrics.query("SELECT * FROM test") == "result");
+        metrics.createDatabase();
+        metrics.flush();
+    }
+
+    TEST_CASE("Retry retries failed sends", "[TransportDecoratorsTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        trompeloeil::sequence seq;
+        REQUIRE_CALL(*mock, send("a x=1")).THROW(ConnectionError{"test", "refused"}).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("a x=1")).THROW(ServerError{"test", "unavailable"}).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("a x=1")).IN_SEQUENCE(seq);
+
+        Retry retry{std::make_unique<TransportAdapter>(mock), 2, std::chrono::milliseconds{1}};
+        retry.send("a x=1");
+    }
+
+    TEST_CASE("Retry throws once retries are exhausted", "[TransportDecoratorsTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*mock, send("a x=1")).THROW(ConnectionError{"test", "refused"}).TIMES(3);
+
+        Retry retry{std::make_unique<TransportAdapter>(mock), 2, std::chrono::milliseconds{1}};
+        CHECK_THROWS_AS(retry.send("a x=1"), ConnectionError);
+    }
+
+    TEST_CASE("Retry does not retry permanent errors", "[TransportDecoratorsTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*mock, send("a x=1")).THROW(BadRequest{"test", "invalid"});
+        REQUIRE_CALL(*mock, send("b x=2")).THROW(NonExistentDatabase{"test", "not found"});
+        REQUIRE_CALL(*mock, send("c x=3")).THROW(SchemaConflict{"test", "conflict"});
+
+        Retry retry{std::make_unique<TransportAdapter>(mock), 2, std::chrono::milliseconds{1}};
+        CHECK_THROWS_AS(retry.sendBuffers({"a x=1"}), BadRequest);
+        CHECK_THROWS_AS(retry.send("b x=2"), NonExistentDatabase);
+        CHECK_THROWS_AS(retry.send("c x=3"), SchemaConflict);
+    }
+
+    TEST_CASE("Metrics counts messages, bytes and failures", "[TransportDecoratorsTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*mock, send("a x=1"));
+        REQUIRE_CALL(*mock, send("b x=2\nc x=3"));
+        REQUIRE_CALL(*mock, send("d x=4")).THROW(ConnectionError{"test", "refused"});
+
+        Metrics metrics{std::make_unique<TransportAdapter>(mock)};
+        metrics.send("a x=1");
+        metrics.sendBuffers({"b x=2", "\n", "c x=3"});
+        CHECK_THROWS_AS(metrics.send("d x=4"), ConnectionError);
+
+        const auto statistics = metrics.sendStatistics();
+        CHECK(statistics.writtenMessages == 2);
+        CHECK(statistics.sentBytes == 16);
+        CHECK(statistics.failedWrites == 1);
+    }
+
+    TEST_CASE("Metrics keeps the statistics of the wrapped transport", "[TransportDecoratorsTest]")
+    {
+        Metrics metrics{std::make_unique<AsyncTransportStub>()};
+        metrics.send("a x=1");
+        metrics.send("b x=2");
+        metrics.send("c x=3");
+
+        const auto statistics = metrics.sendStatistics();
+        CHECK(statistics.sentMessages == 1);
+        CHECK(statistics.failedMessages == 2);
+        CHECK(statistics.writtenMessages == 3);
+        CHECK(statistics.sentBytes == 15);
+    }
+
+    TEST_CASE("Rate limit delays senders exceeding the rate", "[TransportDecoratorsTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*mock, send(_)).TIMES(3);
+
+        RateLimit rateLimit{std::make_unique<TransportAdapter>(mock), 1000};
+        const auto begin = std::chrono::steady_clock::now();
+        rateLimit.send(std::string(500, 'a'));
+        rateLimit.send(std::string(500, 'b'));
+        CHECK(std::chrono::steady_clock::now() - begin < std::chrono::milliseconds{100});
+        rateLimit.send(std::string(200, 'c'));
+        CHECK(std::chrono::steady_clock::now() - begin >= std::chrono::milliseconds{150});
+
+        CHECK_THROWS_AS(RateLimit(std::make_unique<TransportAdapter>(mock), 0), InfluxDBException);
+    }
+
+    TEST_CASE("Splitter splits messages at line boundaries", "[TransportDecoratorsTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        trompeloeil::sequence seq;
+        REQUIRE_CALL(*mock, send("a x=1\nb x=2")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("c x=3")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("large x=1234")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("d x=4\ne x=5")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("f x=6")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("large x=1234")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("f x=7")).IN_SEQUENCE(seq);
+
+        Splitter splitter{std::make_unique<TransportAdapter>(mock), 12};
+        splitter.send("a x=1\nb x=2\nc x=3\nlarge x=1234");
+        splitter.sendBuffers({"d x=4", "\n", "e x=5"});
+        // Oversize lines keep their position, the last point written wins
+        splitter.send("f x=6\nlarge x=1234\nf x=7");
+
+        CHECK_THROWS_AS(Splitter(std::make_unique<TransportAdapter>(mock), 0), InfluxDBException);
+    }
+
+    TEST_CASE("Spool keeps failed messages and sends them in order", "[TransportDecoratorsTest]")
+    {
+        const auto path = temporaryPath("spool");
+        std::remove(path.c_str());
+
+        auto mock = std::make_shared<TransportMock>();
+        trompeloeil::sequence seq;
+        REQUIRE_CALL(*mock, send("a x=1")).THROW(ConnectionError{"test", "refused"}).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("a x=1")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("b x=2")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("c x=3")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, flush()).IN_SEQUENCE(seq);
+
+        {
+            Spool spool{std::make_unique<TransportAdapter>(mock), path, Spool::defaultMaxBytes, std::chrono::hours{1}};
+            spool.send("a x=1");
+            spool.send("b x=2");
+        }
+        // The spooled messages are sent by a new instance, before the new ones
+        Spool spool{std::make_unique<TransportAdapter>(mock), path, Spool::defaultMaxBytes, std::chrono::hours{1}};
+        spool.sendBuffers({"c x=3"});
+        spool.flush();
+        CHECK_FALSE(std::ifstream{path}.is_open());
+    }
+
+    TEST_CASE("Spool keeps the messages not sent again", "[TransportDecoratorsTest]")
+    {
+        const auto path = temporaryPath("spool-rest");
+        std::remove(path.c_str());
+
+        auto mock = std::make_shared<TransportMock>();
+        trompeloeil::sequence seq;
+        REQUIRE_CALL(*mock, send("a x=1")).THROW(ConnectionError{"test", "refused"}).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("a x=1")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("b x=2")).THROW(BadRequest{"test", "invalid"}).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("c x=3")).THROW(ConnectionError{"test", "refused"}).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, flush()).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, send("c x=3")).IN_SEQUENCE(seq);
+        REQUIRE_CALL(*mock, flush()).IN_SEQUENCE(seq);
+
+        {
+            Spool spool{std::make_unique<TransportAdapter>(mock), path, Spool::defaultMaxBytes, std::chrono::hours{1}};
+            spool.send("a x=1");
+            spool.send("b x=2");
+            spool.send("c x=3");
+            spool.flush();
+            CHECK(spool.sendStatistics().droppedMessages == 1);
+        }
+        // Only the message not sent is left in the spool
+        CHECK(std::filesystem::file_size(path) == sizeof(std::uint64_t) + 5);
+        Spool spool{std::make_unique<TransportAdapter>(mock), path, Spool::defaultMaxBytes, std::chrono::hours{1}};
+        spool.flush();
+        CHECK_FALSE(std::ifstream{path}.is_open());
+    }
+
+    TEST_CASE("Spool drops corrupt records", "[TransportDecoratorsTest]")
+    {
+        const auto path = temporaryPath("spool-corrupt");
+        {
+            std::ofstream file{path, std::ios::binary | std::ios::trunc};
+            const std::uint64_t sizes[]{5, std::uint64_t{1} << 62};
+            file.write(reinterpret_cast<const char*>(&sizes[0]), sizeof(sizes[0]));
+            file.write("a x=1", 5);
+            file.write(reinterpret_cast<const char*>(&sizes[1]), sizeof(sizes[1]));
+            file.write("b x=2", 5);
+        }
+
+        auto mock = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*mock, send("a x=1"));
+        REQUIRE_CALL(*mock, flush());
+
+        Spool spool{std::make_unique<TransportAdapter>(mock), path, Spool::defaultMaxBytes, std::chrono::hours{1}};
+        spool.flush();
+        CHECK(spool.sendStatistics().droppedMessages == 1);
+        CHECK_FALSE(std::ifstream{path}.is_open());
+    }
+
+    TEST_CASE("Spool drops messages if full and throws bad requests", "[TransportDecoratorsTest]")
+    {
+        const auto path = temporaryPath("spool-full");
+        std::remove(path.c_str());
+
+        auto mock = std::make_shared<TransportMock>();
+        REQUIRE_CALL(*mock, send("a x=1")).THROW(ConnectionError{"test", "refused"});
+        Spool full{std::make_unique<TransportAdapter>(mock), path, 20, std::chrono::hours{1}};
+        full.send("a x=1");
+        full.send("b x=2");
+        CHECK(full.sendStatistics().droppedMessages == 1);
+        std::remove(path.c_str());
+
+        REQUIRE_CALL(*mock, send("c x=3")).THROW(BadRequest{"test", "invalid"});
+        Spool healthy{std::make_unique<TransportAdapter>(mock), path, 20, std::chrono::hours{1}};
+        CHECK_THROWS_AS(healthy.send("c x=3"), BadRequest);
+        CHECK_FALSE(std::ifstream{path}.is_open());
+    }
+
+#ifdef INFLUXCXX_WITH_ZLIB
+    TEST_CASE("Compression sends gzip encoded messages", "[TransportDecoratorsTest]")
+    {
+        auto mock = std::make_shared<TransportMock>();
+        std::vector<std::string> bodies;
+        REQUIRE_CALL(*mock, sendEncoded(_, "gzip")).LR_SIDE_EFFECT(bodies.emplace_back(_1)).TIMES(2);
+
+        Compression compression{std::make_unique<TransportAdapter>(mock), 6};
+        compression.sendBuffers({"a x=1", "\n", "b x=2"});
+        compression.send("c x=3");
+
+        std::vector<std::string> messages;
+        for (const auto& body : bodies)
+        {
+            std::string message(64, '\0');
+            uLongf size{static_cast<uLongf>(message.size())};
+            z_stream stream{};
+            REQUIRE(inflateInit2(&stream, 15 + 16) == Z_OK);
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+            stream.avail_in = static_cast<uInt>(body.size());
+            stream.next_out = reinterpret_cast<Bytef*>(message.data());
+            stream.avail_out = static_cast<uInt>(size);
+            CHECK(inflate(&stream, Z_FINISH) == Z_STREAM_END);
+            message.resize(stream.total_out);
+            inflateEnd(&stream);
+            messages.push_back(message);
+        }
+        CHECK(messages == std::vector<std::string>{"a x=1\nb x=2", "c x=3"});
+
+        CHECK_THROWS_AS(Compression(std::make_unique<TransportAdapter>(mock), 0), InfluxDBException);
+    }
+#endif
+
+    TEST_CASE("Factory stacks decorators of the url options", "[TransportDecoratorsTest]")
+    {
+        const auto path = temporaryPath("decorated.lp");
+        std::remove(path.c_str());
+        {
+            auto influxdb = InfluxDBFactory::Get("file://" + path + "?metrics=true&retry=2&max_message_size=16&rate_limit=1000000");
+            influxdb->write({Point{"a"}.addField("x", 1).setTimestamp(std::chrono::time_point<std::chrono::system_clock>{}),
+                             Point{"b"}.addField("x", 2).setTimestamp(std::chrono::time_point<std::chrono::system_clock>{})});
+            influxdb->flushTransport();
+
+            const auto statistics = influxdb->transportStatistics();
+            CHECK(statistics.writtenMessages == 1);
+            CHECK(statistics.sentBytes == 17);
+        }
+
+        std::ifstream file{path};
+        std::ostringstream content;
+        content << file.rdbuf();
+        CHECK(content.str() == "a x=1i 0\nb x=2i 0\n");
+        std::remove(path.c_str());
+    }
+
+    TEST_CASE("Factory throws on invalid decorator options", "[TransportDecoratorsTest]")
+    {
+        const auto url = "file://" + temporaryPath("invalid.lp");
+        CHECK_THROWS_AS(InfluxDBFactory::Get(url + "?compression=zstd"), InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::Get(url + "?compression_level=6"), InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::Get("http://localhost:8086?db=test&compression=gzip&compression_level=0"),
+                        InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::Get(url + "?retry=x"), InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::Get(url + "?rate_limit=0"), InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::Get(url + "?max_message_size=0"), InfluxDBException);
+        CHECK_THROWS_AS(InfluxDBFactory::Get(url + "?metrics=yes"), InfluxDBException);
+        std::remove(temporaryPath("invalid.lp").c_str());
+    }
+
+    TEST_CASE("Factory accepts compression only for http", "[TransportDecoratorsTest]")
+    {
+        const auto messageOf = [](const std::string& url)
+        {
+            std::string message;
+            try
+            {
+                InfluxDBFactory::Get(url);
+            }
+            catch (const InfluxDBException& e)
+            {
+                message = e.what();
+            }
+            return message;
+        };
+        CHECK(messageOf("http://localhost:8086?db=test&compression=gzip&compression_level=12").find("compression_level: 12") !=
+              std::string::npos);
+        CHECK(messageOf("udp://localhost:8089?compression=gzip").find("not supported by the udp transport") != std::string::npos);
+        CHECK(messageOf("file://" + temporaryPath("compressed.lp") + "?compression=gzip").find("file transport") != std::string::npos);
+#ifdef INFLUXCXX_WITH_ZLIB
+        CHECK(messageOf("http://localhost:8086?db=test&compression=gzip&compression_level=9").empty());
+#endif
+    }
+}
@@ -0,0 +1,137 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "TransportDecorators.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t linesPerBatch{1000};
+    constexpr std::size_t messages{1000000};
+    constexpr std::size_t batches{2000};
+    constexpr std::size_t unlimited{std::numeric_limits<std::size_t>::max()};
+
+    /// Accepts everything, so only the decorators are measured
+    class NullTransport : public influxdb::Transport
+    {
+    public:
+        void send(std::string&&) override
+        {
+        }
+
+        void sendBuffers(const std::vector<std::string_view>&) override
+        {
+        }
+
+        void sendEncoded(std::string_view, std::string_view) override
+        {
+        }
+    };
+
+    std::vector<std::string> batchLines()
+    {
+        std::vector<std::string> lines;
+        for (std::size_t i = 0; i < linesPerBatch; ++i)
+        {
+            lines.push_back("cpu,host=server-" + std::to_string(i % 64) + ",region=eu load=0." + std::to_string(i % 1000) +
+                            ",count=" + std::to_string(i) + "i 16094592000" + std::to_string(10000000 + i));
+        }
+        return lines;
+    }
+
+    void measure(const char* name, const std::vector<std::string>& lines,
+                 const std::function<std::unique_ptr<influxdb::Transport>(std::unique_ptr<influxdb::Transport>)>& decorate)
+    {
+        std::vector<std::string_view> buffers;
+        for (const auto& line : lines)
+        {
+            buffers.emplace_back(line);
+            buffers.emplace_back("\n");
+        }
+        buffers.pop_back();
+
+        auto transport = decorate(std::make_unique<NullTransport>());
+
+        auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < messages; ++i)
+        {
+            transport->send(std::string{lines[i % linesPerBatch]});
+        }
+        const auto single = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+        begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < batches; ++i)
+        {
+            transport->sendBuffers(buffers);
+        }
+        const auto batched = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+        std::printf("%-28s %10.1f ns/send %12.1f ns/batch\n", name, single / static_cast<double>(messages),
+                    batched / static_cast<double>(batches));
+    }
+}
+
+int main()
+{
+    using namespace influxdb::transports;
+    using Next = std::unique_ptr<influxdb::Transport>;
+
+    const auto directory = std::filesystem::temp_directory_path() / "influxdb-cxx-benchmark";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const auto spoolPath = (directory / "spool").string();
+
+    const auto lines = batchLines();
+    std::printf("%zu single points and %zu batches of %zu points\n", messages, batches, linesPerBatch);
+
+    measure("bare", lines, [](Next next) { return next; });
+    measure("metrics", lines, [](Next next) { return std::make_unique<Metrics>(std::move(next)); });
+    measure("retry", lines, [](Next next) { return std::make_unique<Retry>(std::move(next), 3, std::chrono::milliseconds{100}); });
+    measure("splitter", lines, [](Next next) { return std::make_unique<Splitter>(std::move(next), unlimited); });
+    measure("spool", lines, [&spoolPath](Next next) {
+        return std::make_unique<Spool>(std::move(next), spoolPath, Spool::defaultMaxBytes, Spool::defaultRetryInterval);
+    });
+    measure("rate limit", lines, [](Next next) { return std::make_unique<RateLimit>(std::move(next), unlimited / 2); });
+    measure("all pass-through layers", lines, [&spoolPath](Next next) {
+        next = std::make_unique<Retry>(std::move(next), 3, std::chrono::milliseconds{100});
+        next = std::make_unique<Splitter>(std::move(next), unlimited);
+        next = std::make_unique<Spool>(std::move(next), spoolPath, Spool::defaultMaxBytes, Spool::defaultRetryInterval);
+        next = std::make_unique<RateLimit>(std::move(next), unlimited / 2);
+        return std::make_unique<Metrics>(std::move(next));
+    });
+#ifdef INFLUXCXX_WITH_ZLIB
+    measure("gzip level 1", lines, [](Next next) { return std::make_unique<Compression>(std::move(next), 1); });
+#endif
+
+    std::filesystem::remove_all(directory);
+    return 0;
+}
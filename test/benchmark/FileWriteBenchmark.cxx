@@ -0,0 +1,100 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "FileSink.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t linesPerBatch{10000};
+    constexpr std::size_t batches{400};
+
+    std::vector<std::string> batchLines()
+    {
+        std::vector<std::string> lines;
+        for (std::size_t i = 0; i < linesPerBatch; ++i)
+        {
+            lines.push_back("cpu,host=server-" + std::to_string(i % 64) + ",region=eu load=0." + std::to_string(i % 1000) +
+                            ",count=" + std::to_string(i) + "i 16094592000" + std::to_string(10000000 + i));
+        }
+        return lines;
+    }
+
+    /// Writes the batches as InfluxDB::flushBatch() does, one view per line and separator
+    void measure(const char* name, const std::string& path, const std::vector<std::string>& lines,
+                 const std::function<void(influxdb::transports::FileSink&)>& configure)
+    {
+        std::vector<std::string_view> buffers;
+        std::size_t bytes{0};
+        for (const auto& line : lines)
+        {
+            buffers.emplace_back(line);
+            buffers.emplace_back("\n");
+            bytes += line.size() + 1;
+        }
+        buffers.pop_back();
+
+        std::filesystem::remove(path);
+        const auto begin = std::chrono::steady_clock::now();
+        {
+            influxdb::transports::FileSink sink{path};
+            configure(sink);
+            for (std::size_t i = 0; i < batches; ++i)
+            {
+                sink.sendBuffers(buffers);
+            }
+            sink.flush();
+        }
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::printf("%-24s %8.2f GB/s %12.0f points/s\n", name, static_cast<double>(bytes * batches) / seconds / 1e9,
+                    static_cast<double>(linesPerBatch * batches) / seconds);
+    }
+}
+
+int main()
+{
+    const auto directory = std::filesystem::temp_directory_path() / "influxdb-cxx-benchmark";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const auto path = (directory / "metrics.lp").string();
+
+    const auto lines = batchLines();
+    std::printf("%zu batches of %zu points written to %s\n", batches, linesPerBatch, path.c_str());
+
+    using influxdb::transports::FileSink;
+    measure("buffered", path, lines, [](FileSink&) {});
+    measure("rotating every 64 MiB", path, lines, [](FileSink& sink) { sink.setMaxFileSize(64 * 1024 * 1024); });
+    measure("fsync on rotation", path, lines, [](FileSink& sink) {
+        sink.setMaxFileSize(64 * 1024 * 1024);
+        sink.setSync(FileSink::Sync::Rotate);
+    });
+
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,174 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Query.h"
+#include "MsgPackWriter.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t rows{200000};
+    constexpr std::size_t chunkSize{16384};
+    constexpr int repetitions{5};
+    constexpr std::int64_t start{1609459200000000000};
+
+    /// Delivers a response in parts of the size curl passes them
+    struct ResponseTransport : public influxdb::Transport
+    {
+        explicit ResponseTransport(std::string body)
+            : response(std::move(body))
+        {
+        }
+
+        void send([[maybe_unused]] std::string&& message) override
+        {
+        }
+
+        void queryChunked([[maybe_unused]] const std::string& query, const std::function<void(std::string_view)>& onChunk) override
+        {
+            for (std::size_t offset = 0; offset < response.size(); offset += chunkSize)
+            {
+                onChunk(std::string_view{response}.substr(offset, chunkSize));
+            }
+        }
+
+        std::string response;
+    };
+
+    std::string rfc3339(std::int64_t nanoseconds)
+    {
+        const auto seconds = static_cast<std::time_t>(nanoseconds / 1000000000);
+        std::tm time{};
+        gmtime_r(&seconds, &time);
+        char buffer[64];
+        const auto size = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &time);
+        return std::string(buffer, size) + "." + std::to_string(1000000000 + nanoseconds % 1000000000).substr(1) + "Z";
+    }
+
+    std::string json(bool epoch)
+    {
+        std::string body{R"({"results":[{"statement_id":0,"series":[{"name":"cpu","tags":{"region":"eu"},"columns":["time","load","count","host"],"values":[)"};
+        for (std::size_t row = 0; row < rows; ++row)
+        {
+            const auto time = start + static_cast<std::int64_t>(row) * 1000;
+            body.append(row == 0 ? "[" : ",[")
+                .append(epoch ? std::to_string(time) : "\"" + rfc3339(time) + "\"")
+                .append(",0.")
+                .append(std::to_string(row % 1000))
+                .append(",")
+                .append(std::to_string(row))
+                .append(",\"host-")
+                .append(std::to_string(row % 16))
+                .append("\"]");
+        }
+        return body.append("]}]}]}\n");
+    }
+
+    std::string csv()
+    {
+        std::string body{"name,tags,time,load,count,host\n"};
+        for (std::size_t row = 0; row < rows; ++row)
+        {
+            body.append("cpu,region=eu,")
+                .append(std::to_string(start + static_cast<std::int64_t>(row) * 1000))
+                .append(",0.")
+                .append(std::to_string(row % 1000))
+                .append(",")
+                .append(std::to_string(row))
+                .append(",host-")
+                .append(std::to_string(row % 16))
+                .append("\n");
+        }
+        return body;
+    }
+
+    std::string msgPack()
+    {
+        influxdb::test::MsgPackWriter writer;
+        writer.map(1).string("results").array(1).map(2).string("statement_id").integer(0).string("series").array(1);
+        writer.map(4).string("name").string("cpu").string("tags").map(1).string("region").string("eu");
+        writer.string("columns").array(4).string("time").string("load").string("count").string("host");
+        writer.string("values").array(rows);
+        for (std::size_t row = 0; row < rows; ++row)
+        {
+            writer.array(4)
+                .time(start + static_cast<std::int64_t>(row) * 1000)
+                .real(static_cast<double>(row % 1000) / 1000.0)
+                .integer(static_cast<std::int64_t>(row))
+                .string("host-" + std::to_string(row % 16));
+        }
+        return writer.data;
+    }
+
+    template <class Decode>
+    void measure(const char* name, const std::string& body, Decode&& decode)
+    {
+        ResponseTransport transport{body};
+        auto best = std::chrono::steady_clock::duration::max();
+        for (int i = 0; i < repetitions; ++i)
+        {
+            const auto begin = std::chrono::steady_clock::now();
+            decode(transport);
+            best = std::min(best, std::chrono::steady_clock::now() - begin);
+        }
+
+        const auto seconds = std::chrono::duration<double>(best).count();
+        std::printf("%-28s %10zu bytes %9.1f MB/s %11.0f rows/s\n", name, body.size(),
+                    static_cast<double>(body.size()) / seconds / 1e6, static_cast<double>(rows) / seconds);
+    }
+}
+
+int main()
+{
+    const std::vector<std::pair<const char*, std::string>> responses{
+        {"json (rfc3339)", json(false)},
+        {"json (epoch=ns)", json(true)},
+        {"csv", csv()},
+        {"msgpack", msgPack()},
+    };
+
+    std::printf("Typed results (execute), %zu rows\n", rows);
+    for (const auto& [name, body] : responses)
+    {
+        measure(name, body, [](influxdb::Transport& transport) { influxdb::internal::queryResultImpl(&transport, "SELECT"); });
+    }
+
+    std::printf("\nStreamed rows (queryStream), %zu rows\n", rows);
+    for (const auto& [name, body] : responses)
+    {
+        measure(name, body, [](influxdb::Transport& transport) {
+            std::size_t received{0};
+            influxdb::internal::queryStreamImpl(&transport, "SELECT", [&received](const influxdb::QueryRow&) { ++received; });
+        });
+    }
+
+    std::printf("\nPoints (query), %zu rows\n", rows);
+    for (const auto& [name, body] : responses)
+    {
+        measure(name, body, [](influxdb::Transport& transport) { influxdb::internal::queryImpl(&transport, "SELECT"); });
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SharedMemory.h"
+#include "SharedMemoryReader.h"
+#include "InfluxDB.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef INFLUXCXX_BENCHMARK_UDP
+#include "UDP.h"
+#endif
+
+namespace
+{
+    constexpr std::size_t points{1000000};
+    const std::string ringName{"influxdb-cxx-benchmark"};
+
+    std::string line(std::size_t i)
+    {
+        return "cpu,host=server-" + std::to_string(i % 64) + ",region=eu load=0." + std::to_string(i % 1000) + ",count=" +
+               std::to_string(i) + "i 16094592000" + std::to_string(10000000 + i);
+    }
+
+    /// Latency of reading the clock, subtracted from the latencies measured
+    std::chrono::nanoseconds clockOverhead()
+    {
+        constexpr std::size_t samples{100000};
+        const auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < samples; ++i)
+        {
+            [[maybe_unused]] volatile auto now = std::chrono::steady_clock::now();
+        }
+        return (std::chrono::steady_clock::now() - begin) / samples;
+    }
+
+    /// Times each write, printing the mean and percentiles in nanoseconds per point
+    template <class Write>
+    void measure(const char* name, std::chrono::nanoseconds overhead, Write&& write)
+    {
+        std::vector<std::chrono::nanoseconds> latencies(points);
+        const auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < points; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            write(i);
+            latencies[i] = std::chrono::steady_clock::now() - start - overhead;
+        }
+        const auto total = std::chrono::steady_clock::now() - begin;
+
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [&latencies](double p) {
+            return static_cast<long long>(latencies[static_cast<std::size_t>(p * static_cast<double>(points - 1))].count());
+        };
+        std::printf("%-34s mean %7.1f  p50 %6lld  p99 %6lld  p99.9 %7lld ns/point\n", name,
+                    static_cast<double>((total - overhead * points).count()) / points, percentile(0.5), percentile(0.99),
+                    percentile(0.999));
+    }
+}
+
+int main()
+{
+    std::vector<std::string> lines;
+    lines.reserve(points);
+    for (std::size_t i = 0; i < points; ++i)
+    {
+        lines.push_back(line(i));
+    }
+    const auto overhead = clockOverhead();
+    std::printf("%zu points of %zu bytes, clock overhead %lld ns subtracted\n", points, lines.front().size(),
+                static_cast<long long>(overhead.count()));
+
+    // A reader drains the ring on a separate thread, as the forwarder does
+    influxdb::SharedMemoryReader::remove(ringName);
+    influxdb::SharedMemoryReader reader{ringName, 64 * 1024 * 1024};
+    std::atomic<bool> stopped{false};
+    std::thread drain([&reader, &stopped] {
+        while (!stopped)
+        {
+            if (reader.wait(std::chrono::milliseconds{10}))
+            {
+                reader.read([](std::string_view) {});
+            }
+        }
+    });
+
+    {
+        influxdb::transports::SharedMemory shm{ringName};
+        measure("shm transport send", overhead, [&](std::size_t i) { shm.send(std::string{lines[i]}); });
+        measure("shm transport sendBuffers", overhead, [&](std::size_t i) { shm.sendBuffers({lines[i]}); });
+        const auto statistics = shm.sendStatistics();
+        std::printf("%34s %llu written, %llu dropped\n", "", static_cast<unsigned long long>(statistics.sentMessages),
+                    static_cast<unsigned long long>(statistics.droppedMessages));
+
+        influxdb::transports::SharedMemory singleProducer{ringName, influxdb::transports::SharedMemory::defaultCapacity, true};
+        measure("shm transport, single producer", overhead, [&](std::size_t i) { singleProducer.sendBuffers({lines[i]}); });
+
+        influxdb::InfluxDB db{std::make_unique<influxdb::transports::SharedMemory>(ringName)};
+        measure("InfluxDB::write via shm", overhead, [&db](std::size_t i) {
+            db.write(influxdb::Point{"cpu"}
+                         .addTag("host", "server")
+                         .addField("load", static_cast<double>(i % 1000) / 1000.0)
+                         .addField("count", static_cast<long long int>(i))
+                         .setTimestamp(std::chrono::system_clock::time_point{std::chrono::nanoseconds{i}}));
+        });
+    }
+
+#ifdef INFLUXCXX_BENCHMARK_UDP
+    influxdb::transports::UDP udp{"127.0.0.1", 9};
+    measure("UDP transport send (syscall)", overhead, [&](std::size_t i) { udp.send(std::string{lines[i]}); });
+#endif
+
+    stopped = true;
+    drain.join();
+    influxdb::SharedMemoryReader::remove(ringName);
+    return 0;
+}
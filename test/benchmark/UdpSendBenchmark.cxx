@@ -0,0 +1,106 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "UDP.h"
+#include "Datagrams.h"
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+namespace
+{
+    constexpr std::size_t linesPerBatch{10000};
+    constexpr std::size_t batches{200};
+
+    std::string batch()
+    {
+        std::string lines;
+        for (std::size_t i = 0; i < linesPerBatch; ++i)
+        {
+            lines.append(i == 0 ? "" : "\n")
+                .append("cpu,host=server-")
+                .append(std::to_string(i % 64))
+                .append(",region=eu load=0.")
+                .append(std::to_string(i % 1000))
+                .append(",count=")
+                .append(std::to_string(i))
+                .append("i 16094592000")
+                .append(std::to_string(10000000 + i));
+        }
+        return lines;
+    }
+
+    template <class Send>
+    void measure(const char* name, const std::string& lines, std::size_t datagrams, Send&& send)
+    {
+        const auto cpuBegin = std::clock();
+        const auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < batches; ++i)
+        {
+            send(std::string{lines});
+        }
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        const auto cpuSeconds = static_cast<double>(std::clock() - cpuBegin) / CLOCKS_PER_SEC;
+
+        const auto points = static_cast<double>(linesPerBatch * batches);
+        std::printf("%-26s %11.0f packets/s %11.0f points/s %8.1f ns CPU/point\n", name,
+                    static_cast<double>(datagrams * batches) / seconds, points / seconds, cpuSeconds / points * 1e9);
+    }
+}
+
+int main()
+{
+    // Datagrams are dropped once the receive buffer is full, only the sending side is measured
+    boost::asio::io_service ioService;
+    boost::asio::ip::udp::socket receiver{ioService, boost::asio::ip::udp::endpoint{boost::asio::ip::address_v4::loopback(), 0}};
+    const auto port = receiver.local_endpoint().port();
+
+    const auto lines = batch();
+    const auto datagrams = influxdb::internal::packDatagrams(lines, influxdb::transports::UDP::defaultMaxDatagramSize).datagrams.size();
+    std::printf("%zu batches of %zu points, %zu datagrams of at most %zu bytes per batch\n", batches, linesPerBatch, datagrams,
+                influxdb::transports::UDP::defaultMaxDatagramSize);
+
+    boost::asio::ip::udp::socket socket{ioService, boost::asio::ip::udp::endpoint{boost::asio::ip::udp::v4(), 0}};
+    const boost::asio::ip::udp::endpoint endpoint{boost::asio::ip::address_v4::loopback(), port};
+    measure("asio send_to per datagram", lines, datagrams, [&](std::string&& message) {
+        for (const auto datagram : influxdb::internal::packDatagrams(message, influxdb::transports::UDP::defaultMaxDatagramSize).datagrams)
+        {
+            socket.send_to(boost::asio::buffer(datagram.data(), datagram.size()), endpoint);
+        }
+    });
+
+    influxdb::transports::UDP udp{"127.0.0.1", port};
+    measure("UDP transport (sendmmsg)", lines, datagrams, [&udp](std::string&& message) { udp.send(std::move(message)); });
+
+    influxdb::transports::UDP ioUringUdp{"127.0.0.1", port};
+    if (!ioUringUdp.enableIoUring())
+    {
+        std::printf("%-26s not available\n", "UDP transport (io_uring)");
+        return 0;
+    }
+    measure("UDP transport (io_uring)", lines, datagrams, [&ioUringUdp](std::string&& message) { ioUringUdp.send(std::move(message)); });
+    return 0;
+}
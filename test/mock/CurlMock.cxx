@@ -55,32 +55,58 @@ CURLcode curl_easy_setopt(CURL* handle, CURLoption option, ...)
 
     va_list argp;
     va_start(argp, option);
-    std::variant<long, unsigned long, void*, std::string, WriteCallbackFn> value;
+    std::variant<long, unsigned long, void*, std::string, WriteCallbackFn, ReadCallbackFn, XferInfoCallbackFn> value;
 
     switch (option)
     {
         case CURLOPT_CONNECTTIMEOUT:
+        case CURLOPT_CONNECTTIMEOUT_MS:
         case CURLOPT_TIMEOUT:
+        case CURLOPT_TIMEOUT_MS:
         case CURLOPT_TCP_KEEPIDLE:
         case CURLOPT_TCP_KEEPINTVL:
         case CURLOPT_POST:
         case CURLOPT_POSTFIELDSIZE:
+        case CURLOPT_NOPROGRESS:
             value = va_arg(argp, long);
             break;
+        case CURLOPT_POSTFIELDSIZE_LARGE:
+            value = static_cast<long>(va_arg(argp, curl_off_t));
+            break;
         case CURLOPT_HTTPAUTH:
             value = va_arg(argp, unsigned long);
             break;
         case CURLOPT_WRITEDATA:
+        case CURLOPT_READDATA:
+        case CURLOPT_XFERINFODATA:
             value = va_arg(argp, void*);
             break;
-        case CURLOPT_URL:
+        case CURLOPT_HTTPHEADER:
+            value = static_cast<void*>(va_arg(argp, curl_slist*));
+            break;
         case CURLOPT_POSTFIELDS:
+            if (const char* fields = va_arg(argp, const char*); fields != nullptr)
+            {
+                value = fields;
+            }
+            else
+            {
+                value = static_cast<void*>(nullptr);
+            }
+            break;
+        case CURLOPT_URL:
         case CURLOPT_USERPWD:
             value = va_arg(argp, const char*);
             break;
         case CURLOPT_WRITEFUNCTION:
             value = va_arg(argp, WriteCallbackFn);
             break;
+        case CURLOPT_READFUNCTION:
+            value = va_arg(argp, ReadCallbackFn);
+            break;
+        case CURLOPT_XFERINFOFUNCTION:
+            value = va_arg(argp, XferInfoCallbackFn);
+            break;
         default:
             FAIL("Option unsupported by mock: " + std::to_string(option));
             return CURLE_UNKNOWN_OPTION;
@@ -101,6 +127,52 @@ void curl_free(void* ptr)
     influxdb::test::curlMock.curl_free(ptr);
 }
 
+curl_slist* curl_slist_append(curl_slist* list, const char* string)
+{
+    return influxdb::test::curlMock.curl_slist_append(list, string);
+}
+
+void curl_slist_free_all(curl_slist* list)
+{
+    influxdb::test::curlMock.curl_slist_free_all(list);
+}
+
+CURLM* curl_multi_init()
+{
+    return influxdb::test::curlMock.curl_multi_init();
+}
+
+CURLMcode curl_multi_cleanup(CURLM* multi_handle)
+{
+    return influxdb::test::curlMock.curl_multi_cleanup(multi_handle);
+}
+
+CURLMcode curl_multi_add_handle(CURLM* multi_handle, CURL* curl_handle)
+{
+    return influxdb::test::curlMock.curl_multi_add_handle(multi_handle, curl_handle);
+}
+
+CURLMcode curl_multi_remove_handle(CURLM* multi_handle, CURL* curl_handle)
+{
+    return influxdb::test::curlMock.curl_multi_remove_handle(multi_handle, curl_handle);
+}
+
+CURLMcode curl_multi_perform(CURLM* multi_handle, int* running_handles)
+{
+    return influxdb::test::curlMock.curl_multi_perform(multi_handle, running_handles);
+}
+
+CURLMcode curl_multi_wait(CURLM* multi_handle, [[maybe_unused]] curl_waitfd extra_fds[], [[maybe_unused]] unsigned int extra_nfds,
+                          int timeout_ms, [[maybe_unused]] int* numfds)
+{
+    return influxdb::test::curlMock.curl_multi_wait(multi_handle, timeout_ms);
+}
+
+CURLMsg* curl_multi_info_read(CURLM* multi_handle, int* msgs_in_queue)
+{
+    return influxdb::test::curlMock.curl_multi_info_read(multi_handle, msgs_in_queue);
+}
+
 CURLcode curl_global_init(long flags)
 {
     return influxdb::test::curlMock.curl_global_init(flags);
@@ -34,6 +34,8 @@ namespace influxdb::test
     };
 
     using WriteCallbackFn = size_t (*)(void*, size_t, size_t, void*);
+    using ReadCallbackFn = size_t (*)(char*, size_t, size_t, void*);
+    using XferInfoCallbackFn = int (*)(void*, curl_off_t, curl_off_t, curl_off_t, curl_off_t);
 
 
     struct CurlMock
@@ -45,12 +47,23 @@ namespace influxdb::test
         MAKE_MOCK3(curl_easy_setopt_, CURLcode(CURL*, CURLoption, std::string));
         MAKE_MOCK3(curl_easy_setopt_, CURLcode(CURL*, CURLoption, void*));
         MAKE_MOCK3(curl_easy_setopt_, CURLcode(CURL*, CURLoption, WriteCallbackFn));
+        MAKE_MOCK3(curl_easy_setopt_, CURLcode(CURL*, CURLoption, ReadCallbackFn));
+        MAKE_MOCK3(curl_easy_setopt_, CURLcode(CURL*, CURLoption, XferInfoCallbackFn));
         MAKE_MOCK1(curl_easy_cleanup, void(CURL*));
         MAKE_MOCK0(curl_global_cleanup, void());
         MAKE_MOCK1(curl_easy_perform, CURLcode(CURL* easy_handle));
         MAKE_MOCK3(curl_easy_getinfo_, CURLcode(CURL*, CURLINFO, long*));
         MAKE_MOCK3(curl_easy_escape, char*(CURL*, const char*, int));
         MAKE_MOCK1(curl_free, void(void*));
+        MAKE_MOCK2(curl_slist_append, curl_slist*(curl_slist*, const char*));
+        MAKE_MOCK1(curl_slist_free_all, void(curl_slist*));
+        MAKE_MOCK0(curl_multi_init, CURLM*());
+        MAKE_MOCK1(curl_multi_cleanup, CURLMcode(CURLM*));
+        MAKE_MOCK2(curl_multi_add_handle, CURLMcode(CURLM*, CURL*));
+        MAKE_MOCK2(curl_multi_remove_handle, CURLMcode(CURLM*, CURL*));
+        MAKE_MOCK2(curl_multi_perform, CURLMcode(CURLM*, int*));
+        MAKE_MOCK2(curl_multi_wait, CURLMcode(CURLM*, int));
+        MAKE_MOCK2(curl_multi_info_read, CURLMsg*(CURLM*, int*));
     };
 
     extern CurlMock curlMock;
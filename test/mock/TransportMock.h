@@ -33,6 +33,8 @@ namespace influxdb::test
         MAKE_MOCK1(send, void(std::string&&), override);
         MAKE_MOCK1(query, std::string(const std::string&), override);
         MAKE_MOCK0(createDatabase, void(), override);
+        MAKE_MOCK0(flush, void(), override);
+        MAKE_MOCK2(sendEncoded, void(std::string_view, std::string_view), override);
     };
 
 
@@ -59,6 +61,16 @@ namespace influxdb::test
             mockImpl->createDatabase();
         }
 
+        void flush() override
+        {
+            mockImpl->flush();
+        }
+
+        void sendEncoded(std::string_view body, std::string_view contentEncoding) override
+        {
+            mockImpl->sendEncoded(body, contentEncoding);
+        }
+
     private:
         std::shared_ptr<TransportMock> mockImpl;
     };
@@ -0,0 +1,150 @@
+// MIT License
+//
+// Copyright (c) 2020-2021 offa
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+/// Forwards the line protocol written by the shared memory transport (`shm://name`) to InfluxDB via HTTP
+
+#include "DeliveryErrors.h"
+#include "HTTP.h"
+#include "InfluxDBException.h"
+#include "SharedMemoryReader.h"
+#include "UriParser.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace
+{
+    /// Messages are joined into requests of up to this size ...
+    constexpr std::size_t defaultMaxRequestBytes{4 * 1024 * 1024};
+
+    /// ... sent at the latest after this interval
+    constexpr std::chrono::milliseconds flushInterval{100};
+
+    /// A failed request is sent again up to this many times ...
+    constexpr unsigned maxRetries{5};
+
+    /// ... waiting this long before the first retry, doubled before each further one
+    constexpr std::chrono::milliseconds initialRetryDelay{100};
+
+    std::atomic<bool> stopped{false};
+
+    void stop(int)
+    {
+        stopped = true;
+    }
+
+    void forward(influxdb::Transport& transport, std::string& request)
+    {
+        auto delay = initialRetryDelay;
+        for (unsigned retry = 0;; ++retry)
+        {
+            try
+            {
+                transport.send(std::string{request});
+                break;
+            }
+            catch (const influxdb::InfluxDBException& e)
+            {
+                if (retry == maxRetries || influxdb::internal::isPermanentError(e))
+                {
+                    std::cerr << "Dropping " << request.size() << " bytes: " << e.what() << '\n';
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(delay);
+            delay *= 2;
+        }
+        request.clear();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3 || argc > 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <ring name> <http url with db> [max request bytes]\n";
+        return EXIT_FAILURE;
+    }
+    const std::string ringName{argv[1]};
+    std::string url{argv[2]};
+    const std::size_t maxRequestBytes = (argc == 4 ? std::stoul(argv[3]) : defaultMaxRequestBytes);
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    try
+    {
+        influxdb::SharedMemoryReader reader{ringName};
+        influxdb::transports::HTTP transport{url};
+        if (const auto uri = http::ParseHttpUrl(url); !uri.user.empty())
+        {
+            transport.enableBasicAuth(uri.user + ":" + uri.password);
+        }
+
+        std::string request;
+        request.reserve(maxRequestBytes);
+        auto deadline = std::chrono::steady_clock::now();
+        while (!stopped)
+        {
+            reader.wait(flushInterval);
+            reader.read([&](std::string_view message) {
+                if (request.empty())
+                {
+                    deadline = std::chrono::steady_clock::now() + flushInterval;
+                }
+                else
+                {
+                    request.push_back('\n');
+                }
+                request.append(message);
+                if (request.size() >= maxRequestBytes)
+                {
+                    forward(transport, request);
+                }
+            });
+
+            if (!request.empty() && std::chrono::steady_clock::now() >= deadline)
+            {
+                forward(transport, request);
+            }
+        }
+
+        reader.read([&](std::string_view message) {
+            request.append(request.empty() ? "" : "\n").append(message);
+        });
+        if (!request.empty())
+        {
+            forward(transport, request);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}